@@ -0,0 +1,136 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace bench
+{
+
+inline volatile unsigned char g_sink = 0;
+
+// Prevents the compiler from throwing away benchmarked computations (MSVC has no inline asm, so volatile reads are used)
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+    const volatile unsigned char* bytes = reinterpret_cast<const volatile unsigned char*>(&value);
+    unsigned char folded = 0;
+    for (size_t i = 0; i < sizeof(T); i++)
+    {
+        folded ^= bytes[i];
+    }
+    g_sink = folded;
+}
+
+class Stopwatch
+{
+public:
+    Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+
+    void Restart() { m_start = std::chrono::steady_clock::now(); }
+
+    [[nodiscard]] double ElapsedNs() const
+    {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// Runs func `repetitions` times and returns the best (minimal) time in nanoseconds
+template <typename Func>
+double MeasureBestNs(const int repetitions, Func&& func)
+{
+    double best = 0.0;
+    for (int i = 0; i < repetitions; i++)
+    {
+        Stopwatch stopwatch;
+        func();
+        const double elapsed = stopwatch.ElapsedNs();
+        best = (i == 0 || elapsed < best) ? elapsed : best;
+    }
+    return best;
+}
+
+inline void PrintResult(const char* group, const char* name, const double ns, const size_t elements)
+{
+    std::printf("%-24s %-32s %12.3f ms %10.3f ns/elem\n", group, name, ns / 1e6, ns / (double)elements);
+}
+
+// Sorts samples in place and returns the value at percentile (0..100)
+inline double Percentile(std::vector<double>& samples, const double percentile)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+    const size_t index = std::min(samples.size() - 1, static_cast<size_t>(percentile / 100.0 * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+// Latency histogram with 8 linear sub-buckets per power of two (about 12% precision), so billions of samples
+// take constant memory
+class LatencyHistogram
+{
+public:
+    void Add(const uint64_t ns) noexcept
+    {
+        m_counts[CalculateIndex(ns)]++;
+        m_total++;
+    }
+
+    [[nodiscard]] uint64_t GetCount() const noexcept { return m_total; }
+
+    // Lower bound of the bucket which contains the percentile (0..100)
+    [[nodiscard]] uint64_t Percentile(const double percentile) const noexcept
+    {
+        const uint64_t rank = std::min(m_total == 0 ? 0 : m_total - 1, static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(m_total)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_counts.size(); i++)
+        {
+            seen += m_counts[i];
+            if (seen > rank)
+            {
+                return CalculateLowerBound(i);
+            }
+        }
+        return m_total == 0 ? 0 : CalculateLowerBound(m_counts.size() - 1);
+    }
+
+private:
+    static constexpr size_t SubBucketBits = 3;
+    static constexpr size_t SubBuckets = size_t{ 1 } << SubBucketBits;
+
+    [[nodiscard]] static size_t CalculateIndex(const uint64_t value) noexcept
+    {
+        if (value < SubBuckets)
+        {
+            return static_cast<size_t>(value);
+        }
+        const size_t msb = std::bit_width(value) - 1;
+        const size_t sub = static_cast<size_t>(value >> (msb - SubBucketBits)) & (SubBuckets - 1);
+        return (msb - SubBucketBits + 1) * SubBuckets + sub;
+    }
+
+    [[nodiscard]] static uint64_t CalculateLowerBound(const size_t index) noexcept
+    {
+        if (index < SubBuckets)
+        {
+            return index;
+        }
+        const size_t msb = index / SubBuckets + SubBucketBits - 1;
+        return (SubBuckets + index % SubBuckets) << (msb - SubBucketBits);
+    }
+
+    std::array<uint64_t, 64 * SubBuckets> m_counts = {};
+    uint64_t m_total = 0;
+};
+
+} // namespace bench end
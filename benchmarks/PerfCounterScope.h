@@ -0,0 +1,132 @@
+#pragma once
+
+// Per-operation hardware/OS counters for benchmarks: wall time, CPU cycles of the thread and page faults of the process.
+//
+// Windows doesn't expose PMU counters to user mode (perf_event_open has no counterpart, instructions retired and
+// TLB misses are only available through ETW PMC profiling with admin rights), so the scope reads what is readable
+// without privileges: QueryThreadCycleTime() for cycles and GetProcessMemoryInfo() for page faults.
+// Page faults are the cheapest proxy of TLB pressure here: every first touch of a committed page is a (soft) fault.
+//
+// Usage:
+//    bench::PerfSample sample;
+//    {
+//        bench::PerfCounterScope scope(sample);
+//        ... measured code ...
+//    }
+
+#ifdef WIN32
+#include <windows.h>
+#include <psapi.h>                      // for GetProcessMemoryInfo
+#else
+#error Unsupported
+#endif
+
+#include "BenchmarkHelpers.h"
+
+#include <cstdint>
+#include <cstdio>
+
+namespace bench
+{
+
+struct PerfSample
+{
+    double ns = 0.0;
+    uint64_t cycles = 0;
+    uint64_t pageFaults = 0;
+};
+
+class PerfCounterScope
+{
+public:
+    explicit PerfCounterScope(PerfSample& result)
+        : m_result(&result)
+        , m_startCycles(ReadThreadCycles())
+        , m_startFaults(ReadPageFaults())
+    {
+        m_stopwatch.Restart(); // the last one, so reading counters isn't measured
+    }
+
+    ~PerfCounterScope()
+    {
+        m_result->ns = m_stopwatch.ElapsedNs();
+        m_result->cycles = ReadThreadCycles() - m_startCycles;
+        m_result->pageFaults = ReadPageFaults() - m_startFaults;
+    }
+
+    PerfCounterScope(const PerfCounterScope&) = delete;
+    PerfCounterScope& operator=(const PerfCounterScope&) = delete;
+
+    [[nodiscard]] static uint64_t ReadThreadCycles()
+    {
+#if WIN32
+        ULONG64 cycles = 0;
+        QueryThreadCycleTime(GetCurrentThread(), &cycles);
+        return cycles;
+#else
+#error Not implemented
+#endif
+    }
+
+    [[nodiscard]] static uint64_t ReadPageFaults()
+    {
+#if WIN32
+        PROCESS_MEMORY_COUNTERS counters = {};
+        counters.cb = sizeof(counters);
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PageFaultCount;
+#else
+#error Not implemented
+#endif
+    }
+
+private:
+    PerfSample* m_result;
+    uint64_t m_startCycles;
+    uint64_t m_startFaults;
+    Stopwatch m_stopwatch;
+};
+
+// Current working set of the process (resident memory)
+[[nodiscard]] inline size_t ReadWorkingSetBytes()
+{
+#if WIN32
+    PROCESS_MEMORY_COUNTERS counters = {};
+    counters.cb = sizeof(counters);
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.WorkingSetSize;
+#else
+#error Not implemented
+#endif
+}
+
+// Runs func `repetitions` times and returns the sample of the fastest run
+template <typename Func>
+PerfSample MeasureBestPerf(const int repetitions, Func&& func)
+{
+    PerfSample best;
+    for (int i = 0; i < repetitions; i++)
+    {
+        PerfSample sample;
+        {
+            PerfCounterScope scope(sample);
+            func();
+        }
+        best = (i == 0 || sample.ns < best.ns) ? sample : best;
+    }
+    return best;
+}
+
+inline void PrintPerfHeader()
+{
+    std::printf("%-24s %-24s %12s %12s %12s %12s\n", "group", "name", "ms", "ns/op", "cycles/op", "faults/kop");
+}
+
+inline void PrintPerfResult(const char* group, const char* name, const PerfSample& sample, const size_t operations)
+{
+    const double ops = static_cast<double>(operations);
+    std::printf("%-24s %-24s %12.3f %12.3f %12.2f %12.3f\n", group, name, sample.ns / 1e6, sample.ns / ops,
+        static_cast<double>(sample.cycles) / ops, static_cast<double>(sample.pageFaults) * 1000.0 / ops);
+}
+
+} // namespace bench end
@@ -0,0 +1,208 @@
+// Growth benchmark: appending elements one by one into GrowingVectorVM (every reserve policy, both commit modes)
+// against std::vector with and without reserve() and std::deque.
+// Sweeps element sizes from 1 B to 256 B and total sizes from KBs up to --max-mb (tens of GB are fine if the policy
+// reserves that much, cases which don't fit the reservation are skipped).
+//
+// Every case runs twice: the first run measures throughput and time to the first element, the second one measures
+// latency of every single append (p50/p99/p999) and the peak working set growth.
+// Note: memory the CRT heap kept from earlier cases is resident already, so small std cases can show no growth.
+// Output is CSV on stdout, one row per case.
+//
+// Usage: GrowthBenchmark [--min-kb N] [--max-mb N]
+
+#include "GrowingVectorVM.h"
+#include "PerfCounterScope.h"
+
+#include <chrono>
+#include <cstdlib>                      // for std::strtoull
+#include <cstring>                      // for std::strcmp
+#include <deque>
+#include <vector>
+
+using namespace ds; // not good practice in general, but that's benchmarks
+
+namespace
+{
+
+template <size_t N>
+struct Payload
+{
+    uint8_t bytes[N];
+};
+
+struct CaseResult
+{
+    double seconds = 0.0;
+    double firstElementNs = 0.0;
+    size_t peakWorkingSetBytes = 0;
+    uint64_t p50Ns = 0;
+    uint64_t p99Ns = 0;
+    uint64_t p999Ns = 0;
+};
+
+constexpr size_t WorkingSetSampleInterval = 64 * 1024;
+
+template <typename Container, typename MakeContainer, typename Append>
+CaseResult Measure(const size_t elements, MakeContainer&& make, Append&& append)
+{
+    using Element = typename Container::value_type;
+    CaseResult result;
+
+    {
+        bench::Stopwatch stopwatch;
+        Container container = make();
+        append(container, Element{ { 1 } });
+        result.firstElementNs = stopwatch.ElapsedNs();
+        for (size_t i = 1; i < elements; i++)
+        {
+            append(container, Element{ { static_cast<uint8_t>(i) } });
+        }
+        result.seconds = stopwatch.ElapsedNs() / 1e9;
+        bench::DoNotOptimize(container);
+    }
+
+    bench::LatencyHistogram latencies;
+    const size_t baseline = bench::ReadWorkingSetBytes();
+    size_t peak = 0;
+    {
+        Container container = make();
+        for (size_t i = 0; i < elements; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            append(container, Element{ { static_cast<uint8_t>(i) } });
+            latencies.Add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+
+            if (i % WorkingSetSampleInterval == 0)
+            {
+                peak = std::max(peak, bench::ReadWorkingSetBytes());
+            }
+        }
+        peak = std::max(peak, bench::ReadWorkingSetBytes());
+        bench::DoNotOptimize(container);
+    }
+
+    result.peakWorkingSetBytes = peak > baseline ? peak - baseline : 0;
+    result.p50Ns = latencies.Percentile(50.0);
+    result.p99Ns = latencies.Percentile(99.0);
+    result.p999Ns = latencies.Percentile(99.9);
+    return result;
+}
+
+void PrintHeader()
+{
+    std::printf("container,policy,commit_with_reserve,element_bytes,total_bytes,elements,throughput_mb_s,peak_ws_bytes,"
+        "first_element_ns,p50_ns,p99_ns,p999_ns,status\n");
+}
+
+void PrintRow(const char* container, const char* policy, const char* commitWithReserve, const size_t elementBytes,
+    const size_t elements, const CaseResult& result, const char* status)
+{
+    const double totalBytes = static_cast<double>(elements * elementBytes);
+    std::printf("%s,%s,%s,%zu,%zu,%zu,%.3f,%zu,%.1f,%llu,%llu,%llu,%s\n", container, policy, commitWithReserve, elementBytes,
+        elements * elementBytes, elements, result.seconds > 0.0 ? totalBytes / (1024.0 * 1024.0) / result.seconds : 0.0,
+        result.peakWorkingSetBytes, result.firstElementNs, static_cast<unsigned long long>(result.p50Ns),
+        static_cast<unsigned long long>(result.p99Ns), static_cast<unsigned long long>(result.p999Ns), status);
+    std::fflush(stdout);
+}
+
+template <typename ReservePolicy>
+const char* GetPolicyName()
+{
+    if constexpr (std::is_same_v<ReservePolicy, _4GBSisePolicyTag>) return "4GB";
+    else if constexpr (std::is_same_v<ReservePolicy, _8GBSisePolicyTag>) return "8GB";
+    else if constexpr (std::is_same_v<ReservePolicy, _16GBSisePolicyTag>) return "16GB";
+    else if constexpr (std::is_same_v<ReservePolicy, RAMSizePolicyTag>) return "RAM";
+    else if constexpr (std::is_same_v<ReservePolicy, RAMDoubleSizePolicyTag>) return "RAMDouble";
+    else return "Custom";
+}
+
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+void RunGrowingVector(const size_t elements)
+{
+    using Container = GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>;
+    const char* commitMode = CommitPagesWithReserve ? "true" : "false";
+    if (elements * sizeof(T) > CalculateReserveBytesForPolicy<ReservePolicy>())
+    {
+        return; // doesn't fit the reservation by design
+    }
+
+    try
+    {
+        const CaseResult result = Measure<Container>(elements,
+            [] { return Container{}; },
+            [](Container& container, const T& value) { container.PushBack(value); });
+        PrintRow("GrowingVectorVM", GetPolicyName<ReservePolicy>(), commitMode, sizeof(T), elements, result, "ok");
+    }
+    catch (const std::bad_alloc&)
+    {
+        PrintRow("GrowingVectorVM", GetPolicyName<ReservePolicy>(), commitMode, sizeof(T), elements, {}, "bad_alloc");
+    }
+}
+
+template <typename T>
+void RunStdContainers(const size_t elements)
+{
+    try
+    {
+        PrintRow("std::vector", "-", "-", sizeof(T), elements, Measure<std::vector<T>>(elements,
+            [] { return std::vector<T>{}; },
+            [](std::vector<T>& container, const T& value) { container.push_back(value); }), "ok");
+        PrintRow("std::vector+reserve", "-", "-", sizeof(T), elements, Measure<std::vector<T>>(elements,
+            [elements] { std::vector<T> container; container.reserve(elements); return container; },
+            [](std::vector<T>& container, const T& value) { container.push_back(value); }), "ok");
+        PrintRow("std::deque", "-", "-", sizeof(T), elements, Measure<std::deque<T>>(elements,
+            [] { return std::deque<T>{}; },
+            [](std::deque<T>& container, const T& value) { container.push_back(value); }), "ok");
+    }
+    catch (const std::bad_alloc&)
+    {
+        PrintRow("std", "-", "-", sizeof(T), elements, {}, "bad_alloc");
+    }
+}
+
+template <typename T, typename... ReservePolicies>
+void RunForElement(const size_t minBytes, const size_t maxBytes)
+{
+    for (size_t totalBytes = minBytes; totalBytes <= maxBytes; totalBytes *= 16)
+    {
+        const size_t elements = totalBytes / sizeof(T);
+        (RunGrowingVector<T, ReservePolicies, false>(elements), ...);
+        (RunGrowingVector<T, ReservePolicies, true>(elements), ...);
+        RunStdContainers<T>(elements);
+    }
+}
+
+template <typename T>
+void RunAllPolicies(const size_t minBytes, const size_t maxBytes)
+{
+    RunForElement<T, _4GBSisePolicyTag, _8GBSisePolicyTag, _16GBSisePolicyTag, RAMSizePolicyTag, RAMDoubleSizePolicyTag,
+        CustomSizePolicyTag<DS_GB(1)>>(minBytes, maxBytes);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t minBytes = DS_KB(4);
+    size_t maxBytes = DS_MB(256);
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const size_t value = static_cast<size_t>(std::strtoull(argv[i + 1], nullptr, 10));
+        if (std::strcmp(argv[i], "--min-kb") == 0)
+        {
+            minBytes = DS_KB(value);
+        }
+        else if (std::strcmp(argv[i], "--max-mb") == 0)
+        {
+            maxBytes = DS_MB(value);
+        }
+    }
+
+    PrintHeader();
+    RunAllPolicies<Payload<1>>(minBytes, maxBytes);
+    RunAllPolicies<Payload<8>>(minBytes, maxBytes);
+    RunAllPolicies<Payload<32>>(minBytes, maxBytes);
+    RunAllPolicies<Payload<256>>(minBytes, maxBytes);
+
+    return 0;
+}
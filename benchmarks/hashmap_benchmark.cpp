@@ -0,0 +1,59 @@
+// Per-insert latency of GrowingHashMapVM against std::unordered_map. Averages are comparable, the point is the tail:
+// std::unordered_map rehashes everything at once when it grows, GrowingHashMapVM splits one bucket per insert.
+
+#include "GrowingHashMapVM.h"
+#include "BenchmarkHelpers.h"
+
+#include <unordered_map>
+#include <random>
+
+using namespace ds; // not good practice in general, but that's benchmarks
+
+namespace
+{
+
+constexpr size_t InsertCount = 4 * 1024 * 1024;
+
+template <typename Map, typename InsertFunc>
+void RunInserts(const char* name, const std::vector<uint64_t>& keys, InsertFunc&& insert)
+{
+    std::vector<double> latencies(keys.size());
+
+    Map map;
+    bench::Stopwatch total;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        bench::Stopwatch stopwatch;
+        insert(map, keys[i]);
+        latencies[i] = stopwatch.ElapsedNs();
+    }
+    const double totalNs = total.ElapsedNs();
+    bench::DoNotOptimize(map);
+
+    bench::PrintResult("insert", name, totalNs, keys.size());
+    const double p50 = bench::Percentile(latencies, 50.0);
+    const double p99 = bench::Percentile(latencies, 99.0);
+    const double p999 = bench::Percentile(latencies, 99.9);
+    const double max = bench::Percentile(latencies, 100.0);
+    std::printf("%-24s %-32s p50 %8.0f ns, p99 %8.0f ns, p99.9 %8.0f ns, max %12.0f ns\n", "latency", name, p50, p99, p999, max);
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937_64 generator(42);
+    std::vector<uint64_t> keys(InsertCount);
+    for (auto& key : keys)
+    {
+        key = generator();
+    }
+
+    using VMMap = GrowingHashMapVM<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, _4GBSisePolicyTag>;
+    using StdMap = std::unordered_map<uint64_t, uint64_t>;
+
+    RunInserts<StdMap>("std::unordered_map", keys, [](StdMap& map, uint64_t key) { map.emplace(key, key); });
+    RunInserts<VMMap>("GrowingHashMapVM", keys, [](VMMap& map, uint64_t key) { map.Insert(key, key); });
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Compares SIMD kernels from GrowingVectorVMKernels.h against scalar STL algorithms over the same container
+// (the ones already exercised in tests/test_main.cpp: std::find, std::count, std::min_element/std::max_element, std::accumulate).
+
+#include "GrowingVectorVMKernels.h"
+#include "BenchmarkHelpers.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using namespace ds; // not good practice in general, but that's benchmarks
+
+namespace
+{
+
+constexpr size_t ElementCount = 16 * 1024 * 1024;
+constexpr int Repetitions = 10;
+
+const char* ToString(const simd::SimdLevel level)
+{
+    switch (level)
+    {
+    case simd::SimdLevel::Scalar: return "scalar";
+    case simd::SimdLevel::SSE2:   return "sse2";
+    case simd::SimdLevel::AVX2:   return "avx2";
+    case simd::SimdLevel::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+template <typename T>
+void RunForType(const char* typeName)
+{
+    GrowingVectorVM<T, _4GBSisePolicyTag> vec;
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(-1'000'000, 1'000'000);
+    for (size_t i = 0; i < ElementCount; i++)
+    {
+        vec.PushBack(static_cast<T>(distribution(generator)));
+    }
+    const T absent = static_cast<T>(5'000'000); // forces full scans
+
+    GrowingVectorVM<size_t, _4GBSisePolicyTag> indices;
+    for (size_t i = 0; i < ElementCount / 4; i++)
+    {
+        indices.PushBack((i * 2654435761u) % ElementCount);
+    }
+
+    bench::PrintResult(typeName, "std::find", bench::MeasureBestNs(Repetitions, [&] { bench::DoNotOptimize(std::find(vec.CBegin(), vec.CEnd(), absent)); }), ElementCount);
+    bench::PrintResult(typeName, "std::count", bench::MeasureBestNs(Repetitions, [&] { bench::DoNotOptimize(std::count(vec.CBegin(), vec.CEnd(), absent)); }), ElementCount);
+    bench::PrintResult(typeName, "std::min/max_element", bench::MeasureBestNs(Repetitions, [&] {
+        bench::DoNotOptimize(std::min_element(vec.CBegin(), vec.CEnd()));
+        bench::DoNotOptimize(std::max_element(vec.CBegin(), vec.CEnd()));
+    }), ElementCount);
+    bench::PrintResult(typeName, "std::accumulate", bench::MeasureBestNs(Repetitions, [&] { bench::DoNotOptimize(std::accumulate(vec.CBegin(), vec.CEnd(), simd::SumType<T>{})); }), ElementCount);
+    bench::PrintResult(typeName, "scalar gather", bench::MeasureBestNs(Repetitions, [&] {
+        GrowingVectorVM<T, _4GBSisePolicyTag> out;
+        for (size_t i = 0; i < indices.GetSize(); i++)
+        {
+            out.PushBack(vec[indices[i]]);
+        }
+        bench::DoNotOptimize(out);
+    }), indices.GetSize());
+
+    for (const auto level : { simd::SimdLevel::Scalar, simd::SimdLevel::SSE2, simd::SimdLevel::AVX2, simd::SimdLevel::AVX512 })
+    {
+        if (level > simd::GetDetectedSimdLevel())
+        {
+            continue;
+        }
+        simd::SetSimdLevelLimit(level);
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "ds::Find [%s]", ToString(level));
+        bench::PrintResult(typeName, name, bench::MeasureBestNs(Repetitions, [&] { bench::DoNotOptimize(ds::Find(vec, absent)); }), ElementCount);
+        std::snprintf(name, sizeof(name), "ds::Count [%s]", ToString(level));
+        bench::PrintResult(typeName, name, bench::MeasureBestNs(Repetitions, [&] { bench::DoNotOptimize(ds::Count(vec, absent)); }), ElementCount);
+        std::snprintf(name, sizeof(name), "ds::MinMax [%s]", ToString(level));
+        bench::PrintResult(typeName, name, bench::MeasureBestNs(Repetitions, [&] { bench::DoNotOptimize(ds::MinMax(vec)); }), ElementCount);
+        std::snprintf(name, sizeof(name), "ds::Sum [%s]", ToString(level));
+        bench::PrintResult(typeName, name, bench::MeasureBestNs(Repetitions, [&] { bench::DoNotOptimize(ds::Sum(vec)); }), ElementCount);
+        std::snprintf(name, sizeof(name), "ds::Gather [%s]", ToString(level));
+        bench::PrintResult(typeName, name, bench::MeasureBestNs(Repetitions, [&] {
+            GrowingVectorVM<T, _4GBSisePolicyTag> out;
+            ds::Gather(vec, indices, out);
+            bench::DoNotOptimize(out);
+        }), indices.GetSize());
+        std::snprintf(name, sizeof(name), "ds::FilterIndices [%s]", ToString(level));
+        bench::PrintResult(typeName, name, bench::MeasureBestNs(Repetitions, [&] {
+            GrowingVectorVM<size_t, _4GBSisePolicyTag> out;
+            ds::FilterIndices(vec, simd::CompareOp::Greater, static_cast<T>(900'000), out);
+            bench::DoNotOptimize(out);
+        }), ElementCount);
+    }
+    simd::SetSimdLevelLimit(simd::SimdLevel::AVX512);
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("Detected SIMD level: %s\n", ToString(simd::GetDetectedSimdLevel()));
+
+    RunForType<int32_t>("int32_t");
+    RunForType<float>("float");
+    RunForType<double>("double");
+
+    return 0;
+}
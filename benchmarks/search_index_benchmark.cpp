@@ -0,0 +1,67 @@
+// Lookups in a big sorted vector: std::lower_bound against StaticSearchIndex (single and batched lookups).
+
+#include "GrowingVectorVMSearchIndex.h"
+#include "BenchmarkHelpers.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace ds; // not good practice in general, but that's benchmarks
+
+namespace
+{
+
+constexpr size_t ElementCount = 64 * 1024 * 1024;
+constexpr size_t QueryCount = 4 * 1024 * 1024;
+constexpr int Repetitions = 3;
+
+} // namespace
+
+int main()
+{
+    GrowingVectorVM<uint64_t, _4GBSisePolicyTag> sorted;
+    std::mt19937_64 generator(42);
+    uint64_t value = 0;
+    for (size_t i = 0; i < ElementCount; i++)
+    {
+        value += 1 + generator() % 16;
+        sorted.PushBack(value);
+    }
+
+    GrowingVectorVM<uint64_t, _4GBSisePolicyTag> queries;
+    for (size_t i = 0; i < QueryCount; i++)
+    {
+        queries.PushBack(generator() % (value + 100));
+    }
+
+    bench::Stopwatch buildStopwatch;
+    const auto index = BuildSearchIndex(sorted);
+    bench::PrintResult("build", "BuildSearchIndex", buildStopwatch.ElapsedNs(), ElementCount);
+
+    bench::PrintResult("lower_bound", "std::lower_bound", bench::MeasureBestNs(Repetitions, [&] {
+        size_t checksum = 0;
+        for (size_t i = 0; i < QueryCount; i++)
+        {
+            checksum += std::lower_bound(sorted.CBegin(), sorted.CEnd(), queries[i]) - sorted.CBegin();
+        }
+        bench::DoNotOptimize(checksum);
+    }), QueryCount);
+
+    bench::PrintResult("lower_bound", "StaticSearchIndex::LowerBound", bench::MeasureBestNs(Repetitions, [&] {
+        size_t checksum = 0;
+        for (size_t i = 0; i < QueryCount; i++)
+        {
+            checksum += index.LowerBound(queries[i]);
+        }
+        bench::DoNotOptimize(checksum);
+    }), QueryCount);
+
+    GrowingVectorVM<size_t, _4GBSisePolicyTag> results;
+    bench::PrintResult("lower_bound", "StaticSearchIndex::Batch", bench::MeasureBestNs(Repetitions, [&] {
+        results.Clear();
+        index.LowerBoundBatch(queries, results);
+        bench::DoNotOptimize(results.Back());
+    }), QueryCount);
+
+    return 0;
+}
@@ -0,0 +1,268 @@
+// Replays an operation trace (recorded with ds::TraceRecorder, see GrowingVectorVMTrace.h) against GrowingVectorVM
+// with every reserve policy and against std::vector, to tune policies on a real mix of operations.
+// Operations are replayed back to back (recorded pauses are ignored) on elements of the recorded size rounded up
+// to a power of two (256 B at most), element values are not recorded.
+//
+// Reports total time, latency distribution of single operations, peak working set growth and amount of operations
+// which failed (e.g. a vector outgrew the reservation of the policy). Output is CSV on stdout.
+//
+// Usage: TraceReplay <trace file>
+
+#include "GrowingVectorVM.h"
+#include "GrowingVectorVMTrace.h"
+#include "PerfCounterScope.h"
+
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace ds; // not good practice in general, but that's benchmarks
+
+namespace
+{
+
+template <size_t N>
+struct Payload
+{
+    uint8_t bytes[N];
+};
+
+struct StdVectorTag {};
+
+// Same operations for every container and element size
+class ReplayVector
+{
+public:
+    virtual ~ReplayVector() = default;
+    virtual void Append() = 0;
+    virtual void Insert(size_t index, size_t count) = 0;
+    virtual void Erase(size_t index, size_t count) = 0;
+    virtual void Resize(size_t size) = 0;
+    virtual void Clear() = 0;
+    virtual void MoveFrom(ReplayVector& other) = 0;
+    virtual void SwapWith(ReplayVector& other) = 0;
+    [[nodiscard]] virtual size_t GetSize() const = 0;
+};
+
+template <typename Container>
+class ReplayVectorImpl final : public ReplayVector
+{
+public:
+    using Element = typename Container::value_type;
+
+    void Append() override
+    {
+        if constexpr (IsStd) { m_container.push_back(Element{}); }
+        else { m_container.PushBack(Element{}); }
+    }
+
+    void Insert(const size_t index, const size_t count) override
+    {
+        const size_t position = std::min(index, GetSize());
+        if constexpr (IsStd) { m_container.insert(m_container.cbegin() + position, count, Element{}); }
+        else { m_container.Insert(m_container.CBegin() + position, count, Element{}); }
+    }
+
+    void Erase(const size_t index, const size_t count) override
+    {
+        const size_t first = std::min(index, GetSize());
+        const size_t last = std::min(first + count, GetSize());
+        if constexpr (IsStd) { m_container.erase(m_container.cbegin() + first, m_container.cbegin() + last); }
+        else { m_container.Erase(m_container.CBegin() + first, m_container.CBegin() + last); }
+    }
+
+    void Resize(const size_t size) override
+    {
+        if constexpr (IsStd) { m_container.resize(size); }
+        else { m_container.Resize(size, Element{}); }
+    }
+
+    void Clear() override
+    {
+        if constexpr (IsStd) { m_container.clear(); }
+        else { m_container.Clear(); }
+    }
+
+    void MoveFrom(ReplayVector& other) override
+    {
+        if (auto* same = dynamic_cast<ReplayVectorImpl*>(&other))
+        {
+            m_container = std::move(same->m_container);
+            return;
+        }
+        Resize(other.GetSize()); // element size differs, keep at least the size
+        other.Clear();
+    }
+
+    void SwapWith(ReplayVector& other) override
+    {
+        if (auto* same = dynamic_cast<ReplayVectorImpl*>(&other))
+        {
+            std::swap(m_container, same->m_container);
+        }
+    }
+
+    [[nodiscard]] size_t GetSize() const override
+    {
+        if constexpr (IsStd) { return m_container.size(); }
+        else { return m_container.GetSize(); }
+    }
+
+private:
+    static constexpr bool IsStd = std::is_same_v<Container, std::vector<Element>>;
+
+    Container m_container;
+};
+
+template <typename Target, size_t N>
+using ContainerFor = std::conditional_t<std::is_same_v<Target, StdVectorTag>, std::vector<Payload<N>>, GrowingVectorVM<Payload<N>, Target>>;
+
+template <typename Target>
+std::unique_ptr<ReplayVector> MakeVector(const size_t elementSize)
+{
+    if (elementSize <= 1) return std::make_unique<ReplayVectorImpl<ContainerFor<Target, 1>>>();
+    if (elementSize <= 2) return std::make_unique<ReplayVectorImpl<ContainerFor<Target, 2>>>();
+    if (elementSize <= 4) return std::make_unique<ReplayVectorImpl<ContainerFor<Target, 4>>>();
+    if (elementSize <= 8) return std::make_unique<ReplayVectorImpl<ContainerFor<Target, 8>>>();
+    if (elementSize <= 16) return std::make_unique<ReplayVectorImpl<ContainerFor<Target, 16>>>();
+    if (elementSize <= 32) return std::make_unique<ReplayVectorImpl<ContainerFor<Target, 32>>>();
+    if (elementSize <= 64) return std::make_unique<ReplayVectorImpl<ContainerFor<Target, 64>>>();
+    if (elementSize <= 128) return std::make_unique<ReplayVectorImpl<ContainerFor<Target, 128>>>();
+    return std::make_unique<ReplayVectorImpl<ContainerFor<Target, 256>>>();
+}
+
+struct ReplayResult
+{
+    double totalMs = 0.0;
+    size_t peakWorkingSetBytes = 0;
+    size_t failedOperations = 0;
+    bench::LatencyHistogram latencies;
+};
+
+constexpr size_t WorkingSetSampleInterval = 4096;
+
+template <typename Target>
+ReplayResult Replay(const std::vector<TraceRecord>& records)
+{
+    ReplayResult result;
+    std::unordered_map<uint64_t, size_t> elementSizes;
+    std::unordered_map<uint64_t, std::unique_ptr<ReplayVector>> vectors;
+    const size_t baseline = bench::ReadWorkingSetBytes();
+    size_t peak = baseline;
+
+    auto find = [&vectors, &elementSizes](const uint64_t id) -> ReplayVector&
+    {
+        auto& vector = vectors[id];
+        if (vector == nullptr)
+        {
+            // recording started after the vector was created
+            const auto size = elementSizes.find(id);
+            vector = MakeVector<Target>(size == elementSizes.end() ? 8 : size->second);
+        }
+        return *vector;
+    };
+
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const TraceRecord& record = records[i];
+        const auto start = std::chrono::steady_clock::now();
+        try
+        {
+            switch (record.operation)
+            {
+            case TraceOperation::Create:
+                elementSizes[record.vector] = static_cast<size_t>(record.first);
+                vectors[record.vector] = MakeVector<Target>(static_cast<size_t>(record.first));
+                break;
+            case TraceOperation::Destroy:
+                vectors.erase(record.vector);
+                break;
+            case TraceOperation::Append:
+                find(record.vector).Append();
+                break;
+            case TraceOperation::Insert:
+                find(record.vector).Insert(static_cast<size_t>(record.first), static_cast<size_t>(record.count));
+                break;
+            case TraceOperation::Erase:
+                find(record.vector).Erase(static_cast<size_t>(record.first), static_cast<size_t>(record.count));
+                break;
+            case TraceOperation::Resize:
+                find(record.vector).Resize(static_cast<size_t>(record.first));
+                break;
+            case TraceOperation::Clear:
+                find(record.vector).Clear();
+                break;
+            case TraceOperation::MoveConstruct:
+            case TraceOperation::MoveAssign:
+                if (const auto source = elementSizes.find(record.first); source != elementSizes.end())
+                {
+                    elementSizes[record.vector] = source->second;
+                }
+                find(record.vector).MoveFrom(find(record.first));
+                break;
+            case TraceOperation::Swap:
+                find(record.vector).SwapWith(find(record.first));
+                break;
+            }
+        }
+        catch (const std::exception&)
+        {
+            result.failedOperations++;
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        result.latencies.Add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        result.totalMs += std::chrono::duration<double, std::milli>(elapsed).count();
+
+        if (i % WorkingSetSampleInterval == 0)
+        {
+            peak = std::max(peak, bench::ReadWorkingSetBytes());
+        }
+    }
+    peak = std::max(peak, bench::ReadWorkingSetBytes());
+    result.peakWorkingSetBytes = peak - baseline;
+    return result;
+}
+
+template <typename Target>
+void Run(const char* name, const std::vector<TraceRecord>& records)
+{
+    const ReplayResult result = Replay<Target>(records);
+    std::printf("%s,%zu,%.3f,%llu,%llu,%llu,%llu,%zu,%zu\n", name, records.size(), result.totalMs,
+        static_cast<unsigned long long>(result.latencies.Percentile(50.0)), static_cast<unsigned long long>(result.latencies.Percentile(99.0)),
+        static_cast<unsigned long long>(result.latencies.Percentile(99.9)), static_cast<unsigned long long>(result.latencies.Percentile(100.0)),
+        result.peakWorkingSetBytes, result.failedOperations);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::printf("Usage: TraceReplay <trace file>\n");
+        return 1;
+    }
+
+    std::vector<TraceRecord> records;
+    try
+    {
+        records = LoadTrace(argv[1]);
+    }
+    catch (const std::exception& error)
+    {
+        std::printf("%s\n", error.what());
+        return 1;
+    }
+
+    std::printf("target,operations,total_ms,p50_ns,p99_ns,p999_ns,max_ns,peak_ws_bytes,failed_operations\n");
+    Run<_4GBSisePolicyTag>("GrowingVectorVM<4GB>", records);
+    Run<_8GBSisePolicyTag>("GrowingVectorVM<8GB>", records);
+    Run<_16GBSisePolicyTag>("GrowingVectorVM<16GB>", records);
+    Run<RAMSizePolicyTag>("GrowingVectorVM<RAM>", records);
+    Run<RAMDoubleSizePolicyTag>("GrowingVectorVM<RAMDouble>", records);
+    Run<StdVectorTag>("std::vector", records);
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Compares basic operations of GrowingVectorVM against std::vector with per-operation counters (see PerfCounterScope.h):
+// PushBack, iteration, Insert and Erase at the front, Resize and Clear.
+// GrowingVectorVM never relocates, but pays a page fault for every new page, std::vector pays copies on growth instead.
+
+#include "GrowingVectorVM.h"
+#include "PerfCounterScope.h"
+
+#include <vector>
+
+using namespace ds; // not good practice in general, but that's benchmarks
+
+namespace
+{
+
+constexpr size_t ElementCount = 16 * 1024 * 1024;
+constexpr size_t ShiftElementCount = 64 * 1024;    // Insert/Erase at the front are O(n)
+constexpr size_t ShiftOperationCount = 1024;
+constexpr int Repetitions = 5;
+
+using DsVector = GrowingVectorVM<uint64_t, _4GBSisePolicyTag>;
+using StdVector = std::vector<uint64_t>;
+
+// Wraps both containers into the same small interface
+void PushBack(DsVector& vec, const uint64_t value) { vec.PushBack(value); }
+void PushBack(StdVector& vec, const uint64_t value) { vec.push_back(value); }
+void InsertFront(DsVector& vec, const uint64_t value) { vec.Insert(vec.CBegin(), value); }
+void InsertFront(StdVector& vec, const uint64_t value) { vec.insert(vec.cbegin(), value); }
+void EraseFront(DsVector& vec) { vec.Erase(vec.CBegin()); }
+void EraseFront(StdVector& vec) { vec.erase(vec.cbegin()); }
+void Resize(DsVector& vec, const size_t size) { vec.Resize(size, uint64_t{ 1 }); }
+void Resize(StdVector& vec, const size_t size) { vec.resize(size, uint64_t{ 1 }); }
+void Clear(DsVector& vec) { vec.Clear(); }
+void Clear(StdVector& vec) { vec.clear(); }
+
+template <typename Vector>
+void Run(const char* group)
+{
+    bench::PrintPerfResult(group, "PushBack", bench::MeasureBestPerf(Repetitions, [] {
+        Vector vec;
+        for (size_t i = 0; i < ElementCount; i++)
+        {
+            PushBack(vec, i);
+        }
+        bench::DoNotOptimize(vec);
+    }), ElementCount);
+
+    Vector filled;
+    Resize(filled, ElementCount);
+    bench::PrintPerfResult(group, "Iterate", bench::MeasureBestPerf(Repetitions, [&] {
+        uint64_t sum = 0;
+        for (const uint64_t value : filled)
+        {
+            sum += value;
+        }
+        bench::DoNotOptimize(sum);
+    }), ElementCount);
+
+    bench::PrintPerfResult(group, "Insert (front)", bench::MeasureBestPerf(Repetitions, [] {
+        Vector vec;
+        Resize(vec, ShiftElementCount);
+        for (size_t i = 0; i < ShiftOperationCount; i++)
+        {
+            InsertFront(vec, i);
+        }
+        bench::DoNotOptimize(vec);
+    }), ShiftOperationCount);
+
+    bench::PrintPerfResult(group, "Erase (front)", bench::MeasureBestPerf(Repetitions, [] {
+        Vector vec;
+        Resize(vec, ShiftElementCount);
+        for (size_t i = 0; i < ShiftOperationCount; i++)
+        {
+            EraseFront(vec);
+        }
+        bench::DoNotOptimize(vec);
+    }), ShiftOperationCount);
+
+    bench::PrintPerfResult(group, "Resize", bench::MeasureBestPerf(Repetitions, [] {
+        Vector vec;
+        Resize(vec, ElementCount);
+        bench::DoNotOptimize(vec);
+    }), ElementCount);
+
+    // Clear keeps the memory in both containers, so the second fill shows the cost of touching it again
+    bench::PrintPerfResult(group, "Clear + refill", bench::MeasureBestPerf(Repetitions, [&] {
+        Clear(filled);
+        Resize(filled, ElementCount);
+        bench::DoNotOptimize(filled);
+    }), ElementCount);
+}
+
+} // namespace
+
+int main()
+{
+    bench::PrintPerfHeader();
+    Run<DsVector>("GrowingVectorVM");
+    Run<StdVector>("std::vector");
+
+    return 0;
+}
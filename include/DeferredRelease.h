@@ -0,0 +1,172 @@
+#pragma once
+
+// Opt-in deferred release of big GrowingVectorVM reservations.
+// Releasing tens of GB tears down page tables (and shoots down TLBs of other cores) for milliseconds, so once
+// enabled, destruction of a vector with at least minCommittedBytes committed just enqueues the reservation and
+// a background reclaimer thread releases it. Payload needs nothing else: GrowingVectorVM never runs destructors
+// of elements on release.
+//
+// Queue is bounded: when it's full the vector is released synchronously by the caller as before, so the amount
+// of memory waiting for release is bounded too. Call DrainReleases() at shutdown or before measuring memory.
+// Commit budgets are refunded and memory stats count the release when the reclaimer has released the memory, not
+// on enqueue, so a budget must outlive releases queued by its vectors as well (drain before destroying it).
+//
+// Usage:
+//    ds::DeferredReleaser::GetInstance().Enable(DS_MB(64));
+//    ...
+//    ds::DrainReleases();
+
+#include "GrowingVectorVM.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace ds
+{
+
+class DeferredReleaser
+{
+public:
+    [[nodiscard]] static DeferredReleaser& GetInstance()
+    {
+        static DeferredReleaser releaser;
+        return releaser;
+    }
+
+    // Starts the reclaimer (if not started yet) and routes releases of vectors with at least minCommittedBytes to it
+    void Enable(const size_t minCommittedBytes = DS_MB(64), const size_t maxQueuedReleases = 64)
+    {
+        std::lock_guard lock(m_mutex);
+        m_minCommittedBytes = minCommittedBytes;
+        if (m_queuedCount == 0)
+        {
+            m_queue.resize(std::max<size_t>(maxQueuedReleases, 1));
+            m_head = 0;
+        }
+        if (!m_thread.joinable())
+        {
+            m_isStopping = false;
+            m_thread = std::thread(&DeferredReleaser::Run, this);
+        }
+        GetReleaseInterceptor().store(&DeferredReleaser::Intercept, std::memory_order_release);
+    }
+
+    // Releases everything queued and stops the reclaimer, vectors are released synchronously afterwards
+    void Disable()
+    {
+        GetReleaseInterceptor().store(nullptr, std::memory_order_release);
+        {
+            std::lock_guard lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_hasWork.notify_one();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    // Blocks until every queued reservation is released
+    void Drain()
+    {
+        std::unique_lock lock(m_mutex);
+        m_isDrained.wait(lock, [this] { return m_queuedCount == 0 && !m_isReleasing; });
+    }
+
+    [[nodiscard]] bool IsEnabled() const noexcept { return GetReleaseInterceptor().load(std::memory_order_acquire) == &DeferredReleaser::Intercept; }
+    [[nodiscard]] size_t GetDeferredCount() const noexcept { return m_deferredCount.load(std::memory_order_relaxed); }
+    [[nodiscard]] size_t GetSynchronousCount() const noexcept { return m_synchronousCount.load(std::memory_order_relaxed); }
+
+private:
+    DeferredReleaser() = default;
+
+    ~DeferredReleaser() noexcept
+    {
+        // vectors destroyed after this point (static destruction order) are released synchronously
+        Disable();
+    }
+
+    DeferredReleaser(const DeferredReleaser&) = delete;
+    DeferredReleaser& operator=(const DeferredReleaser&) = delete;
+
+    static bool Intercept(const ReservationRelease& release) noexcept
+    {
+        return GetInstance().TryEnqueue(release);
+    }
+
+    bool TryEnqueue(const ReservationRelease& release) noexcept
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            if (release.committedBytes < m_minCommittedBytes)
+            {
+                return false; // small ones are cheaper to release than to hand over
+            }
+            if (m_isStopping || m_queuedCount == m_queue.size())
+            {
+                m_synchronousCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            m_queue[(m_head + m_queuedCount) % m_queue.size()] = release;
+            m_queuedCount++;
+        }
+        m_deferredCount.fetch_add(1, std::memory_order_relaxed);
+        m_hasWork.notify_one();
+        return true;
+    }
+
+    void Run()
+    {
+        std::unique_lock lock(m_mutex);
+        while (true)
+        {
+            m_hasWork.wait(lock, [this] { return m_queuedCount > 0 || m_isStopping; });
+            if (m_queuedCount == 0)
+            {
+                break; // stopping and everything is released
+            }
+
+            const ReservationRelease release = m_queue[m_head];
+            m_head = (m_head + 1) % m_queue.size();
+            m_queuedCount--;
+            m_isReleasing = true;
+
+            lock.unlock();
+            ReleaseReservation(release);
+            lock.lock();
+
+            m_isReleasing = false;
+            if (m_queuedCount == 0)
+            {
+                m_isDrained.notify_all();
+            }
+        }
+        m_isDrained.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_hasWork;
+    std::condition_variable m_isDrained;
+    std::thread m_thread;
+    std::vector<ReservationRelease> m_queue; // ring buffer
+    size_t m_head = 0;
+    size_t m_queuedCount = 0;
+    size_t m_minCommittedBytes = 0;
+    bool m_isReleasing = false;
+    bool m_isStopping = false;
+    std::atomic<size_t> m_deferredCount = 0;
+    std::atomic<size_t> m_synchronousCount = 0;
+};
+
+// Waits until the background reclaimer has released everything queued
+inline void DrainReleases()
+{
+    DeferredReleaser::GetInstance().Drain();
+}
+
+} // namespace ds end
@@ -0,0 +1,507 @@
+#pragma once
+
+// Packed bit vector on top of GrowingVectorVM: one bit per element instead of a byte for GrowingVectorVM<bool>.
+// Bits are stored in 64-bit words inside the same Virtual Memory reservation model, so growth never relocates
+// and bit iterators stay valid on PushBack/Resize.
+//
+// Rank/Select are backed by a small superblock index (cumulative popcount every 512 bits) which is maintained
+// incrementally: mutation invalidates only the superblocks to the right of it, BuildRankIndex() recomputes the tail.
+// Queries are const and don't touch the index, so concurrent readers are fine: they use the valid part of the index
+// and count the rest word by word, call BuildRankIndex() after a batch of modifications to keep them fast.
+
+#include "GrowingVectorVM.h"
+
+#include <bit>                          // for std::popcount, std::countr_zero
+#include <algorithm>                    // for std::min, std::upper_bound
+
+
+namespace ds
+{
+
+// Custom iterator classes over bits
+template <typename Container>
+class ConstBitIterator
+{
+public:
+    using value_type = bool;
+    using reference = bool;
+    using difference_type = ptrdiff_t;
+    using iterator_category = std::random_access_iterator_tag;
+    using WordType = typename Container::WordType;
+
+    ConstBitIterator(const WordType* words, size_t index) noexcept : words(words), index(index) {}
+
+    reference operator*() const noexcept
+    {
+        return ((words[index / Container::BitsPerWord] >> (index % Container::BitsPerWord)) & 1) != 0;
+    }
+
+    ConstBitIterator& operator++() noexcept { ++index; return *this; }
+    ConstBitIterator operator++(int) noexcept { ConstBitIterator temp = *this; ++index; return temp; }
+    ConstBitIterator& operator--() noexcept { --index; return *this; }
+    ConstBitIterator operator--(int) noexcept { ConstBitIterator temp = *this; --index; return temp; }
+
+    difference_type operator-(const ConstBitIterator& other) const noexcept
+    {
+        return static_cast<difference_type>(index) - static_cast<difference_type>(other.index);
+    }
+    ConstBitIterator operator+(difference_type n) const noexcept { return ConstBitIterator(words, index + n); }
+    ConstBitIterator operator-(difference_type n) const noexcept { return ConstBitIterator(words, index - n); }
+    ConstBitIterator& operator+=(difference_type n) noexcept { index += n; return *this; }
+    ConstBitIterator& operator-=(difference_type n) noexcept { index -= n; return *this; }
+
+    bool operator==(const ConstBitIterator& other) const noexcept { return index == other.index; }
+    std::strong_ordering operator<=>(const ConstBitIterator& other) const noexcept { return index <=> other.index; }
+
+    reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+    // No need to make it a private/protected, same as for ConstIterator
+    const WordType* words;
+    size_t index;
+};
+
+template <typename Container>
+class BitReference
+{
+public:
+    using WordType = typename Container::WordType;
+
+    BitReference(WordType* word, WordType mask, Container* owner) noexcept : m_word(word), m_mask(mask), m_owner(owner) {}
+
+    operator bool() const noexcept { return (*m_word & m_mask) != 0; }
+
+    BitReference& operator=(const bool value) noexcept
+    {
+        *m_word = value ? (*m_word | m_mask) : (*m_word & ~m_mask);
+        m_owner->InvalidateRankIndex(m_word);
+        return *this;
+    }
+
+    BitReference& operator=(const BitReference& other) noexcept
+    {
+        return *this = static_cast<bool>(other);
+    }
+
+    void Flip() noexcept
+    {
+        *m_word ^= m_mask;
+        m_owner->InvalidateRankIndex(m_word);
+    }
+
+private:
+    WordType* m_word;
+    WordType m_mask;
+    Container* m_owner;
+};
+
+template <typename Container>
+class BitIterator : public ConstBitIterator<Container>
+{
+public:
+    using Base = ConstBitIterator<Container>;
+    using value_type = bool;
+    using reference = BitReference<Container>;
+    using difference_type = ptrdiff_t;
+    using iterator_category = std::random_access_iterator_tag;
+    using WordType = typename Container::WordType;
+
+    BitIterator(WordType* words, size_t index, Container* owner) noexcept : Base(words, index), owner(owner) {}
+
+    reference operator*() const noexcept
+    {
+        WordType* word = const_cast<WordType*>(this->words) + this->index / Container::BitsPerWord;
+        return reference(word, WordType{ 1 } << (this->index % Container::BitsPerWord), owner);
+    }
+
+    BitIterator& operator++() noexcept { Base::operator++(); return *this; }
+    BitIterator operator++(int) noexcept { BitIterator temp = *this; Base::operator++(); return temp; }
+    BitIterator& operator--() noexcept { Base::operator--(); return *this; }
+    BitIterator operator--(int) noexcept { BitIterator temp = *this; Base::operator--(); return temp; }
+
+    difference_type operator-(const BitIterator& other) const noexcept { return Base::operator-(other); }
+    BitIterator operator+(difference_type n) const noexcept { return BitIterator(const_cast<WordType*>(this->words), this->index + n, owner); }
+    BitIterator operator-(difference_type n) const noexcept { return BitIterator(const_cast<WordType*>(this->words), this->index - n, owner); }
+    BitIterator& operator+=(difference_type n) noexcept { Base::operator+=(n); return *this; }
+    BitIterator& operator-=(difference_type n) noexcept { Base::operator-=(n); return *this; }
+
+    reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+    Container* owner;
+};
+
+
+// Important: the same strict reserve limitation as for GrowingVectorVM applies, ReservePolicy bounds the amount of words.
+template<typename ReservePolicy = RAMSizePolicyTag>
+class GrowingBitVectorVM
+{
+public:
+    using WordType = uint64_t;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using value_type = bool;
+
+    static constexpr size_t BitsPerWord = sizeof(WordType) * 8;
+    static constexpr size_t WordsPerSuperblock = 8;                  // 512 bits, one cache line of words
+    static constexpr size_t BitsPerSuperblock = BitsPerWord * WordsPerSuperblock;
+
+    using SelfType = GrowingBitVectorVM<ReservePolicy>;
+    using WordStorage = GrowingVectorVM<WordType, ReservePolicy>;
+    using iterator = BitIterator<SelfType>;
+    using const_iterator = ConstBitIterator<SelfType>;
+    using reference = BitReference<SelfType>;
+
+    GrowingBitVectorVM() = default;
+
+    GrowingBitVectorVM(const size_type count, const bool value)
+    {
+        Resize(count, value);
+    }
+
+    GrowingBitVectorVM(GrowingBitVectorVM&& other) noexcept
+        : m_words(std::move(other.m_words))
+        , m_superblockRanks(std::move(other.m_superblockRanks))
+        , m_size(std::exchange(other.m_size, 0))
+        , m_validSuperblocks(std::exchange(other.m_validSuperblocks, 0))
+    {
+    }
+
+    GrowingBitVectorVM& operator=(GrowingBitVectorVM&& other) noexcept
+    {
+        if (this != &other)
+        {
+            m_words = std::move(other.m_words);
+            m_superblockRanks = std::move(other.m_superblockRanks);
+            m_size = std::exchange(other.m_size, 0);
+            m_validSuperblocks = std::exchange(other.m_validSuperblocks, 0);
+        }
+        return *this;
+    }
+
+    // Copying of multi-GB bitmaps is expected to be explicit, no copy ctor for now
+    GrowingBitVectorVM(const GrowingBitVectorVM&) = delete;
+    GrowingBitVectorVM& operator=(const GrowingBitVectorVM&) = delete;
+
+    [[nodiscard]] inline size_type GetSize() const noexcept { return m_size; }
+    [[nodiscard]] inline bool Empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] inline size_type GetCapacity() const noexcept { return m_words.GetCapacity() * BitsPerWord; }
+    [[nodiscard]] inline size_type GetReserve() const noexcept { return m_words.GetReserve() * BitsPerWord; }
+
+    [[nodiscard]] inline size_type GetWordCount() const noexcept { return m_words.GetSize(); }
+    [[nodiscard]] inline const WordType* GetWords() const noexcept { return m_words.GetData(); }
+
+    [[nodiscard]] inline iterator Begin() noexcept { return iterator(m_words.Begin().ptr, 0, this); }
+    [[nodiscard]] inline const_iterator Begin() const noexcept { return const_iterator(m_words.CBegin().ptr, 0); }
+    [[nodiscard]] inline iterator End() noexcept { return iterator(m_words.Begin().ptr, m_size, this); }
+    [[nodiscard]] inline const_iterator End() const noexcept { return const_iterator(m_words.CBegin().ptr, m_size); }
+    [[nodiscard]] inline const_iterator CBegin() const noexcept { return Begin(); }
+    [[nodiscard]] inline const_iterator CEnd() const noexcept { return End(); }
+
+    // Note: can throw with bad_alloc if reserve limitation is exceed or allocation was failed
+    void Reserve(const size_type bitAmount)
+    {
+        m_words.Reserve(CalculateWordCount(bitAmount));
+    }
+
+    void PushBack(const bool value)
+    {
+        if (m_size % BitsPerWord == 0)
+        {
+            m_words.PushBack(WordType{ 0 });
+        }
+
+        if (value)
+        {
+            m_words.GetData()[m_size / BitsPerWord] |= WordType{ 1 } << (m_size % BitsPerWord);
+        }
+        ++m_size;
+        // only the last superblock is affected and its own rank (bits before it) stays correct
+        m_validSuperblocks = std::min(m_validSuperblocks, CalculateSuperblockIndex(m_size - 1) + 1);
+    }
+
+    void PopBack()
+    {
+        assert(!Empty());
+        Set(m_size - 1, false);
+        --m_size;
+        if (m_size % BitsPerWord == 0)
+        {
+            m_words.PopBack();
+        }
+    }
+
+    void Resize(const size_type newSize, const bool value = false)
+    {
+        if (newSize < m_size)
+        {
+            m_words.Resize(CalculateWordCount(newSize));
+            m_size = newSize;
+            ClearUnusedTailBits();
+        }
+        else if (newSize > m_size)
+        {
+            if (value && m_size % BitsPerWord != 0)
+            {
+                // fill the rest of the last partial word first
+                m_words.GetData()[m_size / BitsPerWord] |= ~WordType{ 0 } << (m_size % BitsPerWord);
+            }
+            m_words.Resize(CalculateWordCount(newSize), value ? ~WordType{ 0 } : WordType{ 0 });
+            m_size = newSize;
+            ClearUnusedTailBits();
+        }
+        InvalidateRankIndexFromBit(0);
+    }
+
+    void Clear() noexcept
+    {
+        m_words.Clear();
+        m_size = 0;
+        m_validSuperblocks = 0;
+    }
+
+    [[nodiscard]] bool Test(const size_type index) const
+    {
+        ValidateIndex(index);
+        return ((m_words.GetData()[index / BitsPerWord] >> (index % BitsPerWord)) & 1) != 0;
+    }
+
+    [[nodiscard]] bool operator[](const size_type index) const
+    {
+        return Test(index);
+    }
+
+    [[nodiscard]] reference operator[](const size_type index)
+    {
+        ValidateIndex(index);
+        return reference(m_words.GetData() + index / BitsPerWord, WordType{ 1 } << (index % BitsPerWord), this);
+    }
+
+    void Set(const size_type index, const bool value = true)
+    {
+        ValidateIndex(index);
+        WordType& word = m_words.GetData()[index / BitsPerWord];
+        const WordType mask = WordType{ 1 } << (index % BitsPerWord);
+        word = value ? (word | mask) : (word & ~mask);
+        InvalidateRankIndexFromBit(index);
+    }
+
+    void Reset(const size_type index)
+    {
+        Set(index, false);
+    }
+
+    void Flip(const size_type index)
+    {
+        ValidateIndex(index);
+        m_words.GetData()[index / BitsPerWord] ^= WordType{ 1 } << (index % BitsPerWord);
+        InvalidateRankIndexFromBit(index);
+    }
+
+    // Word-level bulk operations, both bit vectors must have the same size
+    GrowingBitVectorVM& And(const GrowingBitVectorVM& other) { return ApplyBulk(other, [](WordType a, WordType b) { return a & b; }); }
+    GrowingBitVectorVM& Or(const GrowingBitVectorVM& other) { return ApplyBulk(other, [](WordType a, WordType b) { return a | b; }); }
+    GrowingBitVectorVM& Xor(const GrowingBitVectorVM& other) { return ApplyBulk(other, [](WordType a, WordType b) { return a ^ b; }); }
+
+    GrowingBitVectorVM& operator&=(const GrowingBitVectorVM& other) { return And(other); }
+    GrowingBitVectorVM& operator|=(const GrowingBitVectorVM& other) { return Or(other); }
+    GrowingBitVectorVM& operator^=(const GrowingBitVectorVM& other) { return Xor(other); }
+
+    // Makes the rank index valid for the whole vector, recomputes only the part invalidated since the last build
+    void BuildRankIndex()
+    {
+        if (m_size > 0)
+        {
+            UpdateRankIndex(CalculateSuperblockIndex(m_size - 1) + 1);
+        }
+    }
+
+    [[nodiscard]] bool IsRankIndexBuilt() const noexcept
+    {
+        return m_size == 0 || m_validSuperblocks > CalculateSuperblockIndex(m_size - 1);
+    }
+
+    // Amount of set bits
+    [[nodiscard]] size_type Count() const
+    {
+        return Rank(m_size);
+    }
+
+    // Amount of set bits in [0, position)
+    [[nodiscard]] size_type Rank(const size_type position) const
+    {
+        if (position > m_size)
+        {
+            throw std::out_of_range{ "Rank failed" };
+        }
+        if (position == 0)
+        {
+            return 0;
+        }
+
+        const size_type wordIndex = position / BitsPerWord;
+        // the closest superblock with a valid rank, words behind it are counted one by one
+        const size_type superblock = m_validSuperblocks > 0 ? std::min(wordIndex / WordsPerSuperblock, m_validSuperblocks - 1) : 0;
+
+        const WordType* words = m_words.GetData();
+        size_type result = m_validSuperblocks > 0 ? m_superblockRanks[superblock] : 0;
+        for (size_type i = superblock * WordsPerSuperblock; i < wordIndex; i++)
+        {
+            result += std::popcount(words[i]);
+        }
+
+        const size_type bitOffset = position % BitsPerWord;
+        if (bitOffset != 0)
+        {
+            result += std::popcount(words[wordIndex] & ((WordType{ 1 } << bitOffset) - 1));
+        }
+        return result;
+    }
+
+    // Position of the set bit with the given zero-based rank, GetSize() if there is no such bit
+    [[nodiscard]] size_type Select(const size_type rank) const
+    {
+        if (m_size == 0)
+        {
+            return m_size;
+        }
+
+        // last valid superblock which starts with rank <= requested one
+        size_type superblock = 0;
+        size_type remaining = rank;
+        if (m_validSuperblocks > 0)
+        {
+            const uint64_t* ranks = m_superblockRanks.GetData();
+            superblock = static_cast<size_type>(std::upper_bound(ranks, ranks + m_validSuperblocks, rank) - ranks) - 1;
+            remaining = rank - ranks[superblock];
+        }
+
+        // the bit is in this superblock, unless it's the last valid one and the rest isn't indexed
+        const WordType* words = m_words.GetData();
+        const size_type lastWord = superblock + 1 < m_validSuperblocks ? (superblock + 1) * WordsPerSuperblock : m_words.GetSize();
+        for (size_type i = superblock * WordsPerSuperblock; i < lastWord; i++)
+        {
+            const size_type bitsInWord = std::popcount(words[i]);
+            if (remaining < bitsInWord)
+            {
+                return i * BitsPerWord + SelectInWord(words[i], remaining);
+            }
+            remaining -= bitsInWord;
+        }
+
+        return m_size;
+    }
+
+    // Called by references and iterators on write access
+    void InvalidateRankIndex(const WordType* word) noexcept
+    {
+        InvalidateRankIndexFromBit(static_cast<size_type>(word - m_words.GetData()) * BitsPerWord);
+    }
+
+private:
+    [[nodiscard]] constexpr static size_type CalculateWordCount(const size_type bits) noexcept
+    {
+        return (bits + BitsPerWord - 1) / BitsPerWord;
+    }
+
+    [[nodiscard]] constexpr static size_type CalculateSuperblockIndex(const size_type bit) noexcept
+    {
+        return bit / BitsPerSuperblock;
+    }
+
+    [[nodiscard]] static size_type SelectInWord(WordType word, size_type rank) noexcept
+    {
+        for (; rank != 0; --rank)
+        {
+            word &= word - 1; // drop the lowest set bit
+        }
+        return std::countr_zero(word);
+    }
+
+    void ValidateIndex(const size_type index) const
+    {
+        if (index >= m_size)
+        {
+            throw std::out_of_range{ "bit index is out of range" };
+        }
+    }
+
+    void InvalidateRankIndexFromBit(const size_type bit) noexcept
+    {
+        // rank of the superblock containing the bit counts only bits before it, so it stays valid
+        m_validSuperblocks = std::min(m_validSuperblocks, CalculateSuperblockIndex(bit) + 1);
+    }
+
+    // Makes ranks valid for superblocks [0, superblockCount), recomputes only the invalidated part
+    void UpdateRankIndex(const size_type superblockCount)
+    {
+        if (m_validSuperblocks >= superblockCount)
+        {
+            return;
+        }
+
+        if (m_superblockRanks.GetSize() < superblockCount)
+        {
+            m_superblockRanks.Resize(superblockCount, uint64_t{ 0 });
+        }
+
+        const WordType* words = m_words.GetData();
+        uint64_t* ranks = m_superblockRanks.GetData();
+        size_type superblock = m_validSuperblocks;
+        if (superblock == 0)
+        {
+            ranks[0] = 0;
+            superblock = 1;
+        }
+
+        for (; superblock < superblockCount; superblock++)
+        {
+            const size_type firstWord = (superblock - 1) * WordsPerSuperblock;
+            uint64_t count = ranks[superblock - 1];
+            for (size_type i = 0; i < WordsPerSuperblock; i++)
+            {
+                count += std::popcount(words[firstWord + i]);
+            }
+            ranks[superblock] = count;
+        }
+
+        m_validSuperblocks = superblockCount;
+    }
+
+    void ClearUnusedTailBits() noexcept
+    {
+        // bits beyond m_size must be always zero, Count/Rank/Select rely on that
+        const size_type bitOffset = m_size % BitsPerWord;
+        if (bitOffset != 0)
+        {
+            m_words.GetData()[m_size / BitsPerWord] &= (WordType{ 1 } << bitOffset) - 1;
+        }
+    }
+
+    template <typename Operation>
+    GrowingBitVectorVM& ApplyBulk(const GrowingBitVectorVM& other, Operation operation)
+    {
+        if (other.GetSize() != GetSize())
+        {
+            throw std::logic_error("Bulk bit operations require bit vectors of the same size");
+        }
+
+        WordType* words = m_words.GetData();
+        const WordType* otherWords = other.m_words.GetData();
+        const size_type wordCount = m_words.GetSize();
+        for (size_type i = 0; i < wordCount; i++) // plain loop over words, compiler vectorizes it
+        {
+            words[i] = operation(words[i], otherWords[i]);
+        }
+
+        m_validSuperblocks = 0;
+        return *this;
+    }
+
+private:
+    WordStorage m_words;
+    // m_superblockRanks[i] = amount of set bits before superblock i, valid for [0, m_validSuperblocks)
+    GrowingVectorVM<uint64_t, ReservePolicy> m_superblockRanks;
+    size_type m_size = 0;
+    size_type m_validSuperblocks = 0;
+};
+
+} // namespace ds end
@@ -0,0 +1,335 @@
+#pragma once
+
+// Sorted flat map for read-mostly workloads. Keys and values are kept in two separate GrowingVectorVM reservations
+// (lookups touch only keys), single inserts go to a small unsorted buffer which is merged into the main run with
+// one linear pass from the back once it's big enough, so the tail isn't shifted on every insert.
+// Merge uses already committed memory at the end of the reservation, nothing is reallocated or copied aside.
+
+#include "GrowingVectorVM.h"
+
+#include <functional>                   // for std::less
+#include <utility>                      // for std::pair
+#include <algorithm>                    // for std::sort
+#include <cmath>                        // for std::sqrt
+
+
+namespace ds
+{
+
+template<
+    typename Key,
+    typename Value,
+    typename Compare = std::less<Key>,
+    typename ReservePolicy = RAMSizePolicyTag>
+class GrowingFlatMapVM
+{
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using size_type = size_t;
+    using key_compare = Compare;
+    using KeysContainer = GrowingVectorVM<Key, ReservePolicy>;
+    using ValuesContainer = GrowingVectorVM<Value, ReservePolicy>;
+
+    static constexpr size_t MinMergeThreshold = 64;
+
+    // Merge grows the sorted run with default constructed elements and moves keys and values into them
+    static_assert(std::is_default_constructible_v<Key> && std::is_default_constructible_v<Value>,
+        "Keys and values must be default constructible");
+
+    GrowingFlatMapVM() = default;
+    GrowingFlatMapVM(GrowingFlatMapVM&&) noexcept = default;
+    GrowingFlatMapVM(const GrowingFlatMapVM&) = delete;
+    GrowingFlatMapVM& operator=(const GrowingFlatMapVM&) = delete;
+    GrowingFlatMapVM& operator=(GrowingFlatMapVM&&) = delete;
+
+    [[nodiscard]] inline size_type GetSize() const noexcept { return m_keys.GetSize() + m_buffer.GetSize(); }
+    [[nodiscard]] inline bool Empty() const noexcept { return GetSize() == 0; }
+    [[nodiscard]] inline size_type GetBufferedCount() const noexcept { return m_buffer.GetSize(); }
+
+    // 0 means adaptive threshold: sqrt of the main run size, but not less than MinMergeThreshold.
+    // Lookups of keys which aren't in the main run scan the buffer linearly, and so does every insert (it looks for
+    // the key first), while a merge moves the whole main run: an insert costs O(log n + threshold) plus O(n / threshold)
+    // amortized. The adaptive threshold balances both to O(sqrt n) per insert and per lookup of an absent key, a bigger
+    // one makes merges rarer but these lookups slower.
+    void SetMergeThreshold(const size_t threshold) noexcept { m_mergeThreshold = threshold; }
+    [[nodiscard]] size_t GetMergeThreshold() const noexcept
+    {
+        if (m_mergeThreshold != 0)
+        {
+            return m_mergeThreshold;
+        }
+        return std::max(MinMergeThreshold, static_cast<size_t>(std::sqrt(static_cast<double>(m_keys.GetSize()))));
+    }
+
+    // Returns pointer to the value or nullptr. Pointers are invalidated by the next merge (insert or Flush).
+    [[nodiscard]] Value* Find(const Key& key)
+    {
+        const size_t index = LowerBoundIndex(key);
+        if (index < m_keys.GetSize() && !m_compare(key, m_keys[index]))
+        {
+            return &m_values[index];
+        }
+
+        for (size_t i = 0; i < m_buffer.GetSize(); i++)
+        {
+            if (IsEqual(m_buffer[i].first, key))
+            {
+                return &m_buffer[i].second;
+            }
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] const Value* Find(const Key& key) const
+    {
+        return const_cast<GrowingFlatMapVM*>(this)->Find(key);
+    }
+
+    [[nodiscard]] bool Contains(const Key& key) const
+    {
+        return Find(key) != nullptr;
+    }
+
+    [[nodiscard]] Value& At(const Key& key)
+    {
+        Value* value = Find(key);
+        if (value == nullptr)
+        {
+            throw std::out_of_range{ "At failed, no such key" };
+        }
+        return *value;
+    }
+
+    [[nodiscard]] const Value& At(const Key& key) const
+    {
+        return const_cast<GrowingFlatMapVM*>(this)->At(key);
+    }
+
+    // Doesn't overwrite existing value, returns true if the key was inserted
+    bool Insert(const Key& key, const Value& value)
+    {
+        if (Find(key) != nullptr)
+        {
+            return false;
+        }
+
+        m_buffer.PushBack({ key, value });
+        if (m_buffer.GetSize() >= GetMergeThreshold())
+        {
+            Flush();
+        }
+        return true;
+    }
+
+    bool InsertOrAssign(const Key& key, const Value& value)
+    {
+        if (Value* existing = Find(key))
+        {
+            *existing = value;
+            return false;
+        }
+        return Insert(key, value);
+    }
+
+    // Range of pairs (.first - key, .second - value) sorted by key. Existing keys are kept untouched,
+    // for duplicates inside the range the first one wins. Merged in place from the back in O(size + count).
+    template <typename BidirectionalIt>
+    void InsertBatch(BidirectionalIt first, BidirectionalIt last)
+    {
+        Flush();
+        MergeSorted(first, last);
+    }
+
+    // Merges insert buffer into the main run
+    void Flush()
+    {
+        if (m_buffer.Empty())
+        {
+            return;
+        }
+
+        std::sort(m_buffer.Begin(), m_buffer.End(), [this](const auto& lhs, const auto& rhs) { return m_compare(lhs.first, rhs.first); });
+        MergeSorted(m_buffer.CBegin(), m_buffer.CEnd());
+        m_buffer.Clear();
+    }
+
+    bool Erase(const Key& key)
+    {
+        const size_t index = LowerBoundIndex(key);
+        if (index < m_keys.GetSize() && !m_compare(key, m_keys[index]))
+        {
+            m_keys.Erase(m_keys.CBegin() + index);
+            m_values.Erase(m_values.CBegin() + index);
+            return true;
+        }
+
+        for (size_t i = 0; i < m_buffer.GetSize(); i++)
+        {
+            if (IsEqual(m_buffer[i].first, key))
+            {
+                // order in buffer doesn't matter
+                std::swap(m_buffer[i], m_buffer.Back());
+                m_buffer.PopBack();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Clear() noexcept
+    {
+        m_keys.Clear();
+        m_values.Clear();
+        m_buffer.Clear();
+    }
+
+    // Index of the first key which is not less than the given one, over the merged run (flushes the buffer)
+    [[nodiscard]] size_t LowerBound(const Key& key)
+    {
+        Flush();
+        return LowerBoundIndex(key);
+    }
+
+    // Sorted keys and values, index in one matches index in another. Buffer is merged first.
+    [[nodiscard]] const KeysContainer& GetKeys()
+    {
+        Flush();
+        return m_keys;
+    }
+
+    [[nodiscard]] ValuesContainer& GetValues()
+    {
+        Flush();
+        return m_values;
+    }
+
+private:
+    [[nodiscard]] bool IsEqual(const Key& lhs, const Key& rhs) const
+    {
+        return !m_compare(lhs, rhs) && !m_compare(rhs, lhs);
+    }
+
+    // Branchless binary search over main run: the loop has fixed trip count for given size and
+    // the only data dependent step compiles into cmov, so there are no mispredictions.
+    [[nodiscard]] size_t LowerBoundIndex(const Key& key) const
+    {
+        size_t length = m_keys.GetSize();
+        if (length == 0)
+        {
+            return 0;
+        }
+
+        const Key* base = m_keys.GetData();
+        const Key* const first = base;
+        while (length > 1)
+        {
+            const size_t half = length / 2;
+            base = m_compare(base[half - 1], key) ? base + half : base;
+            length -= half;
+        }
+        return (base - first) + (m_compare(*base, key) ? 1 : 0);
+    }
+
+    template <typename BidirectionalIt>
+    void MergeSorted(BidirectionalIt first, BidirectionalIt last)
+    {
+        if (first == last)
+        {
+            return;
+        }
+
+        // First pass counts really new keys to know the final size
+        size_t newCount = 0;
+        {
+            size_t mainIndex = 0;
+            const Key* previous = nullptr;
+            for (auto it = first; it != last; ++it)
+            {
+                const Key& key = it->first;
+                if (previous != nullptr && !m_compare(*previous, key))
+                {
+                    continue; // duplicate inside the batch
+                }
+                previous = &key;
+
+                while (mainIndex < m_keys.GetSize() && m_compare(m_keys[mainIndex], key))
+                {
+                    ++mainIndex;
+                }
+                if (mainIndex == m_keys.GetSize() || m_compare(key, m_keys[mainIndex]))
+                {
+                    ++newCount;
+                }
+            }
+        }
+
+        if (newCount == 0)
+        {
+            return;
+        }
+
+        const size_t oldSize = m_keys.GetSize();
+        const size_t newSize = oldSize + newCount;
+        // commit both tails before any size changes, so a failed commit leaves keys and values in sync
+        m_keys.Reserve(newSize);    // can throw
+        m_values.Reserve(newSize);  // can throw
+        m_keys.Resize(newSize);
+        try
+        {
+            m_values.Resize(newSize);
+        }
+        catch (...)
+        {
+            m_keys.Erase(m_keys.CBegin() + oldSize, m_keys.CEnd()); // default constructor of a value has thrown
+            throw;
+        }
+
+        // Second pass merges from the back, so every element is moved at most once and no extra memory is needed
+        size_t mainIndex = oldSize;
+        size_t writeIndex = newSize;
+        auto it = last;
+        while (it != first)
+        {
+            --it;
+            const Key& key = it->first;
+            if (it != first)
+            {
+                auto previous = std::prev(it);
+                if (!m_compare(previous->first, key))
+                {
+                    continue; // the first of equal keys wins, so skip the later ones
+                }
+            }
+
+            while (mainIndex > 0 && m_compare(key, m_keys[mainIndex - 1]))
+            {
+                --mainIndex;
+                --writeIndex;
+                m_keys[writeIndex] = std::move(m_keys[mainIndex]);
+                m_values[writeIndex] = std::move(m_values[mainIndex]);
+            }
+
+            if (mainIndex > 0 && !m_compare(m_keys[mainIndex - 1], key))
+            {
+                continue; // already present
+            }
+
+            --writeIndex;
+            m_keys[writeIndex] = key;
+            m_values[writeIndex] = it->second;
+        }
+        // the rest of the main run is already in place
+        assert(writeIndex == mainIndex);
+    }
+
+private:
+    KeysContainer m_keys;
+    ValuesContainer m_values;
+    GrowingVectorVM<std::pair<Key, Value>, ReservePolicy> m_buffer;  // unsorted, keys aren't present in the main run
+    size_t m_mergeThreshold = 0;
+
+    Compare m_compare;
+};
+
+} // namespace ds end
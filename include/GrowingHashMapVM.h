@@ -0,0 +1,620 @@
+#pragma once
+
+// Hash map which grows in place: bucket groups live in a GrowingVectorVM reservation, so the table is extended by
+// committing more pages and never copied. Growth is done with linear hashing - every insert which pushes the load
+// factor over the limit splits exactly one bucket group (the one under the split pointer), there is no full rehash.
+//
+// Layout: each bucket is a group of GroupSize slots with 1-byte control tags (open addressing inside the group),
+// full groups are chained to overflow groups from a second reservation (with a free list for reuse).
+// Iterators and references stay valid on inserts except for elements of the bucket which is being split.
+
+#include "GrowingVectorVM.h"
+
+#include <functional>                   // for std::hash, std::equal_to
+#include <utility>                      // for std::pair
+#include <tuple>                        // for std::forward_as_tuple
+#include <new>                          // for std::launder
+
+
+namespace ds
+{
+
+template <typename Map, bool IsConst>
+class HashMapIterator
+{
+public:
+    using value_type = typename Map::value_type;
+    using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+    using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+    using difference_type = ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+    using MapPointer = std::conditional_t<IsConst, const Map*, Map*>;
+    using GroupPointer = std::conditional_t<IsConst, const typename Map::Group*, typename Map::Group*>;
+
+    HashMapIterator(MapPointer map, size_t bucketIndex, GroupPointer group, size_t slot) noexcept
+        : map(map), bucketIndex(bucketIndex), group(group), slot(slot)
+    {
+    }
+
+    // const iterator from non-const one
+    template <bool OtherConst, std::enable_if_t<IsConst && !OtherConst, int> = 0>
+    HashMapIterator(const HashMapIterator<Map, OtherConst>& other) noexcept
+        : map(other.map), bucketIndex(other.bucketIndex), group(other.group), slot(other.slot)
+    {
+    }
+
+    reference operator*() const noexcept { return *group->GetSlot(slot); }
+    pointer operator->() const noexcept { return group->GetSlot(slot); }
+
+    HashMapIterator& operator++() noexcept
+    {
+        ++slot;
+        map->SkipEmptySlots(bucketIndex, group, slot);
+        return *this;
+    }
+
+    HashMapIterator operator++(int) noexcept
+    {
+        HashMapIterator temp = *this;
+        ++(*this);
+        return temp;
+    }
+
+    bool operator==(const HashMapIterator& other) const noexcept
+    {
+        return group == other.group && slot == other.slot;
+    }
+
+    // No need to make it a private/protected, same as for ConstIterator
+    MapPointer map;
+    size_t bucketIndex;
+    GroupPointer group;     // nullptr for End()
+    size_t slot;
+};
+
+
+template<
+    typename Key,
+    typename Value,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>,
+    typename ReservePolicy = RAMSizePolicyTag>
+class GrowingHashMapVM
+{
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<const Key, Value>;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+
+    using SelfType = GrowingHashMapVM<Key, Value, Hash, KeyEqual, ReservePolicy>;
+    using iterator = HashMapIterator<SelfType, false>;
+    using const_iterator = HashMapIterator<SelfType, true>;
+
+    static constexpr size_t GroupSize = 8;
+    static constexpr size_t InitialBucketCount = 16;         // must be power of 2
+    static constexpr size_t NoOverflow = ~size_t{ 0 };
+    static constexpr float DefaultMaxLoadFactor = 0.75f;      // relatively to all slots of the main bucket groups
+
+    static_assert((InitialBucketCount & (InitialBucketCount - 1)) == 0);
+
+    // Trivially copyable on purpose: groups are stored in GrowingVectorVM and new ones are appended empty (all zeros),
+    // slots are raw storage, lifetime of objects inside is managed by the map.
+    struct Group
+    {
+        uint8_t control[GroupSize];             // 0 - empty slot, otherwise 0x80 | 7 bits of hash
+        size_t overflow;                        // index in overflow storage, NoOverflow if none
+        alignas(value_type) unsigned char storage[GroupSize * sizeof(value_type)];
+
+        [[nodiscard]] value_type* GetSlot(const size_t slot) noexcept
+        {
+            return std::launder(reinterpret_cast<value_type*>(storage) + slot);
+        }
+        [[nodiscard]] const value_type* GetSlot(const size_t slot) const noexcept
+        {
+            return std::launder(reinterpret_cast<const value_type*>(storage) + slot);
+        }
+    };
+
+    GrowingHashMapVM()
+    {
+        for (size_t i = 0; i < InitialBucketCount; i++)
+        {
+            m_buckets.PushBack(MakeEmptyGroup());
+        }
+    }
+
+    ~GrowingHashMapVM() noexcept
+    {
+        DestroyAll();
+    }
+
+    GrowingHashMapVM(GrowingHashMapVM&& other) noexcept
+        : m_buckets(std::move(other.m_buckets))
+        , m_overflow(std::move(other.m_overflow))
+        , m_freeOverflow(std::exchange(other.m_freeOverflow, NoOverflow))
+        , m_size(std::exchange(other.m_size, 0))
+        , m_level(std::exchange(other.m_level, 0))
+        , m_splitPointer(std::exchange(other.m_splitPointer, 0))
+        , m_maxLoadFactor(other.m_maxLoadFactor)
+        , m_hash(std::move(other.m_hash))
+        , m_equal(std::move(other.m_equal))
+    {
+    }
+
+    GrowingHashMapVM(const GrowingHashMapVM&) = delete;
+    GrowingHashMapVM& operator=(const GrowingHashMapVM&) = delete;
+    GrowingHashMapVM& operator=(GrowingHashMapVM&&) = delete;
+
+    [[nodiscard]] inline size_type GetSize() const noexcept { return m_size; }
+    [[nodiscard]] inline bool Empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] inline size_type GetBucketCount() const noexcept { return m_buckets.GetSize(); }
+    [[nodiscard]] inline size_type GetOverflowGroupCount() const noexcept { return m_overflow.GetSize(); }
+    [[nodiscard]] inline float GetLoadFactor() const noexcept { return static_cast<float>(m_size) / (GetBucketCount() * GroupSize); }
+    [[nodiscard]] inline float GetMaxLoadFactor() const noexcept { return m_maxLoadFactor; }
+    void SetMaxLoadFactor(const float loadFactor) noexcept
+    {
+        assert(loadFactor > 0.0f);
+        m_maxLoadFactor = loadFactor;
+    }
+
+    [[nodiscard]] iterator Begin() noexcept
+    {
+        if (m_buckets.Empty())
+        {
+            return End(); // moved-from state
+        }
+
+        size_t bucketIndex = 0;
+        Group* group = &m_buckets.GetData()[0];
+        size_t slot = 0;
+        SkipEmptySlots(bucketIndex, group, slot);
+        return iterator(this, bucketIndex, group, slot);
+    }
+    [[nodiscard]] const_iterator Begin() const noexcept { return const_cast<SelfType*>(this)->Begin(); }
+    [[nodiscard]] iterator End() noexcept { return iterator(this, GetBucketCount(), nullptr, 0); }
+    [[nodiscard]] const_iterator End() const noexcept { return const_iterator(this, GetBucketCount(), nullptr, 0); }
+    [[nodiscard]] const_iterator CBegin() const noexcept { return Begin(); }
+    [[nodiscard]] const_iterator CEnd() const noexcept { return End(); }
+
+    [[nodiscard]] iterator Find(const Key& key)
+    {
+        if (m_buckets.Empty())
+        {
+            return End(); // moved-from state
+        }
+
+        const size_t hash = MixHash(m_hash(key));
+        const size_t bucketIndex = CalculateBucketIndex(hash);
+        const uint8_t tag = CalculateTag(hash);
+
+        for (Group* group = &m_buckets.GetData()[bucketIndex]; group != nullptr; group = GetNextGroup(group))
+        {
+            for (size_t slot = 0; slot < GroupSize; slot++)
+            {
+                if (group->control[slot] == tag && m_equal(group->GetSlot(slot)->first, key))
+                {
+                    return iterator(this, bucketIndex, group, slot);
+                }
+            }
+        }
+        return End();
+    }
+
+    [[nodiscard]] const_iterator Find(const Key& key) const
+    {
+        return const_cast<SelfType*>(this)->Find(key);
+    }
+
+    [[nodiscard]] bool Contains(const Key& key) const
+    {
+        return Find(key) != End();
+    }
+
+    // Doesn't overwrite the value if the key exists already, same as std::unordered_map::try_emplace
+    // The bucket is split before the element is inserted, so if the split throws the map stays as it was.
+    template <typename... Args>
+    std::pair<iterator, bool> TryEmplace(const Key& key, Args&&... args)
+    {
+        if (m_buckets.Empty())
+        {
+            throw std::logic_error{ "TryEmplace failed, the map is moved-from" };
+        }
+
+        const size_t hash = MixHash(m_hash(key));
+        InsertPosition position = FindInsertPosition(key, hash);
+        if (position.isFound)
+        {
+            return { iterator(this, position.bucketIndex, position.group, position.slot), false };
+        }
+
+        if (static_cast<float>(m_size + 1) / (GetBucketCount() * GroupSize) > m_maxLoadFactor)
+        {
+            // the key could belong to the split bucket or to the new one, so look for the place again
+            SplitNextBucket(); // can throw
+            position = FindInsertPosition(key, hash);
+        }
+
+        if (position.group == nullptr)
+        {
+            position.group = AppendOverflowGroup(position.lastGroup); // can throw
+            position.slot = 0;
+        }
+
+        new (position.group->GetSlot(position.slot)) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        position.group->control[position.slot] = CalculateTag(hash);
+        ++m_size;
+
+        return { iterator(this, position.bucketIndex, position.group, position.slot), true };
+    }
+
+    std::pair<iterator, bool> Insert(const value_type& value)
+    {
+        return TryEmplace(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> Insert(const Key& key, const Value& value)
+    {
+        return TryEmplace(key, value);
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> InsertOrAssign(const Key& key, V&& value)
+    {
+        auto result = TryEmplace(key, std::forward<V>(value));
+        if (!result.second)
+        {
+            result.first->second = std::forward<V>(value);
+        }
+        return result;
+    }
+
+    Value& operator[](const Key& key)
+    {
+        return TryEmplace(key).first->second;
+    }
+
+    [[nodiscard]] Value& At(const Key& key)
+    {
+        auto it = Find(key);
+        if (it == End())
+        {
+            throw std::out_of_range{ "At failed, no such key" };
+        }
+        return it->second;
+    }
+
+    [[nodiscard]] const Value& At(const Key& key) const
+    {
+        return const_cast<SelfType*>(this)->At(key);
+    }
+
+    bool Erase(const Key& key)
+    {
+        auto it = Find(key);
+        if (it == End())
+        {
+            return false;
+        }
+        EraseSlot(it.group, it.slot);
+        return true;
+    }
+
+    void Clear() noexcept
+    {
+        DestroyAll();
+        for (size_t i = 0; i < m_buckets.GetSize(); i++)
+        {
+            m_buckets[i] = MakeEmptyGroup();
+        }
+        m_overflow.Clear();
+        m_freeOverflow = NoOverflow;
+        m_size = 0;
+        // keep the current amount of buckets and split state, memory is committed already anyway
+    }
+
+    // Iteration helper, moves (bucketIndex, group, slot) to the next occupied slot or to End()
+    template <typename GroupPtr>
+    void SkipEmptySlots(size_t& bucketIndex, GroupPtr& group, size_t& slot) const noexcept
+    {
+        while (group != nullptr)
+        {
+            for (; slot < GroupSize; slot++)
+            {
+                if (group->control[slot] != 0)
+                {
+                    return;
+                }
+            }
+
+            slot = 0;
+            group = GetNextGroup(group);
+            if (group == nullptr && ++bucketIndex < GetBucketCount())
+            {
+                group = const_cast<GroupPtr>(&m_buckets.GetData()[bucketIndex]);
+            }
+        }
+        bucketIndex = GetBucketCount();
+    }
+
+private:
+    // Control value of a slot whose element is copied to the new bucket during a split, never equal to a tag
+    static constexpr uint8_t SplitMovedControl = 0x01;
+
+    // Split copies keys (they are const inside value_type), values are moved if that can't throw and copied otherwise
+    static_assert(std::is_copy_constructible_v<Key>, "Keys must be copy constructible to split buckets");
+
+    struct InsertPosition
+    {
+        bool isFound;
+        size_t bucketIndex;
+        Group* group;       // group with the found element or the first free slot, nullptr if the bucket is full
+        size_t slot;
+        Group* lastGroup;   // the last group of the bucket chain
+    };
+
+    [[nodiscard]] InsertPosition FindInsertPosition(const Key& key, const size_t hash)
+    {
+        const size_t bucketIndex = CalculateBucketIndex(hash);
+        const uint8_t tag = CalculateTag(hash);
+
+        InsertPosition position{ false, bucketIndex, nullptr, 0, nullptr };
+        for (Group* group = &m_buckets.GetData()[bucketIndex]; group != nullptr; group = GetNextGroup(group))
+        {
+            for (size_t slot = 0; slot < GroupSize; slot++)
+            {
+                const uint8_t control = group->control[slot];
+                if (control == tag && m_equal(group->GetSlot(slot)->first, key))
+                {
+                    return { true, bucketIndex, group, slot, group };
+                }
+                if (control == 0 && position.group == nullptr)
+                {
+                    position.group = group;
+                    position.slot = slot;
+                }
+            }
+            position.lastGroup = group;
+        }
+        return position;
+    }
+
+    [[nodiscard]] static Group MakeEmptyGroup() noexcept
+    {
+        Group group{};
+        group.overflow = NoOverflow;
+        return group;
+    }
+
+    // std::hash is identity for integers on most platforms and linear hashing takes low bits, so mix them (fmix64 from MurmurHash3)
+    [[nodiscard]] static size_t MixHash(size_t hash) noexcept
+    {
+        uint64_t h = static_cast<uint64_t>(hash);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    [[nodiscard]] static uint8_t CalculateTag(const size_t hash) noexcept
+    {
+        return static_cast<uint8_t>(0x80 | (hash >> (sizeof(size_t) * 8 - 7)));
+    }
+
+    [[nodiscard]] size_t CalculateBucketIndex(const size_t hash) const noexcept
+    {
+        const size_t levelBuckets = InitialBucketCount << m_level;
+        const size_t index = hash & (levelBuckets - 1);
+        // buckets on the left of split pointer were split already and are addressed with one more bit
+        return index < m_splitPointer ? hash & ((levelBuckets << 1) - 1) : index;
+    }
+
+    template <typename GroupPtr>
+    [[nodiscard]] GroupPtr GetNextGroup(GroupPtr group) const noexcept
+    {
+        return group->overflow == NoOverflow ? nullptr : const_cast<GroupPtr>(&m_overflow.GetData()[group->overflow]);
+    }
+
+    Group* AppendOverflowGroup(Group* lastGroup)
+    {
+        size_t index = m_freeOverflow;
+        if (index != NoOverflow)
+        {
+            Group& reused = m_overflow.GetData()[index];
+            m_freeOverflow = reused.overflow;
+            reused = MakeEmptyGroup();
+        }
+        else
+        {
+            index = m_overflow.GetSize();
+            m_overflow.PushBack(MakeEmptyGroup()); // can throw, doesn't relocate
+        }
+
+        lastGroup->overflow = index;
+        return &m_overflow.GetData()[index];
+    }
+
+    void EraseSlot(Group* group, const size_t slot) noexcept
+    {
+        ObjectLifecycleHelper::DestructObject(group->GetSlot(slot));
+        group->control[slot] = 0;
+        --m_size;
+    }
+
+    // Linear hashing step: bucket under the split pointer is divided between itself and a new bucket at the end.
+    // All memory is committed before the first element is touched and elements are first copied to the new bucket,
+    // then destroyed in the source one, so if anything throws the split is undone and the map stays as it was.
+    void SplitNextBucket()
+    {
+        const size_t levelBuckets = InitialBucketCount << m_level;
+        const size_t sourceIndex = m_splitPointer;
+        const size_t targetIndex = sourceIndex + levelBuckets;
+        assert(targetIndex == GetBucketCount());
+
+        // the new bucket needs at most one group less than the source one has
+        size_t sourceGroupCount = 0;
+        for (const Group* group = &m_buckets.GetData()[sourceIndex]; group != nullptr; group = GetNextGroup(group))
+        {
+            ++sourceGroupCount;
+        }
+        m_overflow.Reserve(m_overflow.GetSize() + sourceGroupCount - 1); // can throw, overflow groups won't fail below
+        m_buckets.PushBack(MakeEmptyGroup()); // can throw, commits more pages in place
+
+        Group* target = &m_buckets.GetData()[targetIndex];
+        size_t targetSlot = 0;
+        const size_t splitBit = levelBuckets;
+        try
+        {
+            for (Group* group = &m_buckets.GetData()[sourceIndex]; group != nullptr; group = GetNextGroup(group))
+            {
+                for (size_t slot = 0; slot < GroupSize; slot++)
+                {
+                    if (group->control[slot] == 0)
+                    {
+                        continue;
+                    }
+
+                    value_type* element = group->GetSlot(slot);
+                    if ((MixHash(m_hash(element->first)) & splitBit) == 0)
+                    {
+                        continue; // stays in the source bucket
+                    }
+
+                    if (targetSlot == GroupSize)
+                    {
+                        target = AppendOverflowGroup(target);
+                        targetSlot = 0;
+                    }
+
+                    new (target->GetSlot(targetSlot)) value_type(element->first, std::move_if_noexcept(element->second));
+                    target->control[targetSlot] = group->control[slot];
+                    ++targetSlot;
+                    group->control[slot] = SplitMovedControl;
+                }
+            }
+        }
+        catch (...)
+        {
+            UndoSplit(sourceIndex, targetIndex);
+            throw;
+        }
+
+        for (Group* group = &m_buckets.GetData()[sourceIndex]; group != nullptr; group = GetNextGroup(group))
+        {
+            for (size_t slot = 0; slot < GroupSize; slot++)
+            {
+                if (group->control[slot] == SplitMovedControl)
+                {
+                    ObjectLifecycleHelper::DestructObject(group->GetSlot(slot));
+                    group->control[slot] = 0;
+                }
+            }
+        }
+        ReleaseEmptyOverflowGroups(&m_buckets.GetData()[sourceIndex]);
+
+        ++m_splitPointer;
+        if (m_splitPointer == levelBuckets)
+        {
+            ++m_level;
+            m_splitPointer = 0;
+        }
+    }
+
+    // Gives moved values back to the source bucket (in the same order they were copied) and removes the new bucket
+    void UndoSplit(const size_t sourceIndex, const size_t targetIndex) noexcept
+    {
+        Group* target = &m_buckets.GetData()[targetIndex];
+        size_t targetSlot = 0;
+        for (Group* group = &m_buckets.GetData()[sourceIndex]; group != nullptr; group = GetNextGroup(group))
+        {
+            for (size_t slot = 0; slot < GroupSize; slot++)
+            {
+                if (group->control[slot] != SplitMovedControl)
+                {
+                    continue;
+                }
+
+                if (targetSlot == GroupSize)
+                {
+                    target = GetNextGroup(target);
+                    targetSlot = 0;
+                }
+
+                value_type* copy = target->GetSlot(targetSlot);
+                if constexpr (std::is_nothrow_move_constructible_v<Value> || !std::is_copy_constructible_v<Value>)
+                {
+                    // the value was moved from the source element, the key stays there untouched
+                    Value* source = &group->GetSlot(slot)->second;
+                    ObjectLifecycleHelper::DestructObject(source);
+                    new (source) Value(std::move(copy->second));
+                }
+                group->control[slot] = target->control[targetSlot];
+                ObjectLifecycleHelper::DestructObject(copy);
+                target->control[targetSlot] = 0;
+                ++targetSlot;
+            }
+        }
+
+        ReleaseEmptyOverflowGroups(&m_buckets.GetData()[targetIndex]);
+        m_buckets.PopBack();
+    }
+
+    // Unlinks overflow groups which became empty after split and puts them into the free list
+    void ReleaseEmptyOverflowGroups(Group* head) noexcept
+    {
+        Group* previous = head;
+        while (previous->overflow != NoOverflow)
+        {
+            const size_t index = previous->overflow;
+            Group& group = m_overflow.GetData()[index];
+
+            bool isEmpty = true;
+            for (size_t slot = 0; slot < GroupSize && isEmpty; slot++)
+            {
+                isEmpty = group.control[slot] == 0;
+            }
+
+            if (isEmpty)
+            {
+                previous->overflow = group.overflow;
+                group.overflow = m_freeOverflow;
+                m_freeOverflow = index;
+            }
+            else
+            {
+                previous = &group;
+            }
+        }
+    }
+
+    void DestroyAll() noexcept
+    {
+        if constexpr (!std::is_trivially_destructible_v<value_type>)
+        {
+            for (auto it = Begin(); it != End(); ++it)
+            {
+                ObjectLifecycleHelper::DestructObject(&*it);
+            }
+        }
+    }
+
+private:
+    GrowingVectorVM<Group, ReservePolicy> m_buckets;
+    GrowingVectorVM<Group, ReservePolicy> m_overflow;
+    size_t m_freeOverflow = NoOverflow;     // head of free list linked through Group::overflow
+
+    size_type m_size = 0;
+    size_t m_level = 0;                     // amount of buckets at the start of the round is InitialBucketCount << m_level
+    size_t m_splitPointer = 0;              // next bucket to split in the current round
+    float m_maxLoadFactor = DefaultMaxLoadFactor;
+
+    Hash m_hash;
+    KeyEqual m_equal;
+};
+
+} // namespace ds end
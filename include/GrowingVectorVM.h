@@ -16,9 +16,66 @@
 #include <assert.h>
 #include <compare>                      // for operator <=>
 #include <utility>                      // for std::reverse_iterator
+#include <algorithm>                    // for std::min
 #include <stdexcept>                    // for std::logic_error
+#include <atomic>                       // for std::atomic
 #include <memory>                       // for uninitialized_default_construct_n and uninitialized_fill_n (potential candidate to implement on my own)
 
+#include "GrowingVectorVMBudget.h"
+
+// Process-wide memory statistics (see GrowingVectorVMStats.h) cost nothing unless compiled in
+#ifndef DS_ENABLE_MEMORY_STATS
+#define DS_ENABLE_MEMORY_STATS 0
+#endif
+
+#if DS_ENABLE_MEMORY_STATS
+#include "GrowingVectorVMStats.h"
+#define DS_MEMORY_STATS(statement) statement
+#else
+#define DS_MEMORY_STATS(statement)
+#endif
+
+// Recording of mutating operations (see GrowingVectorVMTrace.h), also compiled out by default
+#ifndef DS_ENABLE_OPERATION_TRACE
+#define DS_ENABLE_OPERATION_TRACE 0
+#endif
+
+#if DS_ENABLE_OPERATION_TRACE
+#include "GrowingVectorVMTrace.h"
+#define DS_TRACE_OPERATION(operation, first, count) detail::NotifyOperation(this, TraceOperation::operation, first, count)
+#else
+#define DS_TRACE_OPERATION(operation, first, count)
+#endif
+
+// Reserve/commit/decommit/release events with rdtsc timestamps (see GrowingVectorVMEvents.h): a user hook and/or
+// ETW TraceLogging, compiled out by default as well
+#ifndef DS_ENABLE_MEMORY_EVENTS
+#define DS_ENABLE_MEMORY_EVENTS 0
+#endif
+
+#ifndef DS_ENABLE_TRACELOGGING
+#define DS_ENABLE_TRACELOGGING 0
+#endif
+
+#if DS_ENABLE_MEMORY_EVENTS || DS_ENABLE_TRACELOGGING
+#include "GrowingVectorVMEvents.h"
+#define DS_MEMORY_EVENT(statement) statement
+#else
+#define DS_MEMORY_EVENT(statement)
+#endif
+
+// Registry of trimmable vectors for TrimAll() under memory pressure (see GrowingVectorVMRegistry.h), compiled out by default
+#ifndef DS_ENABLE_VECTOR_REGISTRY
+#define DS_ENABLE_VECTOR_REGISTRY 0
+#endif
+
+#if DS_ENABLE_VECTOR_REGISTRY
+#include "GrowingVectorVMRegistry.h"
+#define DS_VECTOR_REGISTRY(statement) statement
+#else
+#define DS_VECTOR_REGISTRY(statement)
+#endif
+
 
 
 #define DS_KB(x) (x) * (size_t)1024
@@ -103,6 +160,59 @@ struct PlatformHelper
         return TotalMemoryInBytes;
     }
 
+    // Returns false if the variable isn't set or doesn't fit the buffer
+    static bool ReadEnvironmentVariable(const char* name, char* buffer, const size_t bufferSize)
+    {
+#if WIN32
+        const DWORD length = GetEnvironmentVariableA(name, buffer, static_cast<DWORD>(bufferSize));
+        return length > 0 && length < bufferSize;
+#else
+#error Not implemented
+#endif
+    }
+
+    // Commit limit (RAM plus page files) and user-mode address space, 0 if unknown
+    static void ReadSystemMemoryLimits(size_t& commitLimit, size_t& addressSpace)
+    {
+        commitLimit = 0;
+        addressSpace = 0;
+#if WIN32
+        MEMORYSTATUSEX status = {};
+        status.dwLength = sizeof(status);
+        if (GlobalMemoryStatusEx(&status))
+        {
+            commitLimit = static_cast<size_t>(status.ullTotalPageFile);
+            addressSpace = static_cast<size_t>(status.ullTotalVirtual);
+        }
+#else
+#error Not implemented
+#endif
+    }
+
+    // Committed memory limits of the job object of the process (that's how Windows containers limit memory), SIZE_MAX if none
+    static void ReadJobMemoryLimits(size_t& processLimit, size_t& jobLimit)
+    {
+        processLimit = SIZE_MAX;
+        jobLimit = SIZE_MAX;
+#if WIN32
+        // nullptr is the job of the calling process, fails if the process isn't in a job
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION job = {};
+        if (QueryInformationJobObject(nullptr, JobObjectExtendedLimitInformation, &job, sizeof(job), nullptr))
+        {
+            if (job.BasicLimitInformation.LimitFlags & JOB_OBJECT_LIMIT_PROCESS_MEMORY)
+            {
+                processLimit = job.ProcessMemoryLimit;
+            }
+            if (job.BasicLimitInformation.LimitFlags & JOB_OBJECT_LIMIT_JOB_MEMORY)
+            {
+                jobLimit = job.JobMemoryLimit;
+            }
+        }
+#else
+#error Not implemented
+#endif
+    }
+
     [[nodiscard]] static void* ReserveVirtualMemory(
         const size_t alignedAllocationSize,
         const size_t pageSize,
@@ -175,6 +285,26 @@ struct PlatformHelper
         return result;
     }
 
+    static bool ProtectVirtualMemory(
+        void* destination,
+        const size_t memorySizeToProtect,
+        const bool isReadOnly
+    )
+    {
+        bool result = false;
+#if WIN32
+        DWORD oldProtection = 0;
+        result = VirtualProtect(
+            destination,
+            memorySizeToProtect,
+            isReadOnly ? PAGE_READONLY : PAGE_READWRITE,
+            &oldProtection);
+#else
+#error Not implemented
+#endif
+        return result;
+    }
+
     static bool ReleaseVirtualMemory(
         void* destination
     )
@@ -201,6 +331,8 @@ struct _8GBSisePolicyTag {};
 struct _16GBSisePolicyTag {};
 struct RAMSizePolicyTag {};
 struct RAMDoubleSizePolicyTag {};
+struct ContainerLimitPolicyTag {};      // what the process can actually commit: job object (container) and commit limits
+struct RuntimeSizePolicyTag {};         // size is chosen at runtime with ReserveConfig, one type for all sizes
 
 template <size_t N>
 struct CustomSizePolicyTag
@@ -216,6 +348,235 @@ struct is_custom_sizing_policy : std::false_type {};
 template <size_t N>
 struct is_custom_sizing_policy<CustomSizePolicyTag<N>> : std::true_type {};
 
+// Limits of memory the process can commit, see GetMemoryLimits()
+struct MemoryLimits
+{
+    size_t installedRAM;
+    size_t commitLimit;                 // system commit limit: RAM plus page files
+    size_t addressSpace;                // user-mode virtual address space of the process
+    size_t jobProcessLimit;             // committed memory limit of the process in its job object, SIZE_MAX if none
+    size_t jobLimit;                    // committed memory limit of the whole job (Windows containers), SIZE_MAX if none
+    size_t effectiveLimit;              // what can actually be committed: the smallest of the above except RAM
+};
+
+// Read once on the first call, limits changed afterwards (e.g. a job object is reconfigured) aren't noticed
+[[nodiscard]] inline const MemoryLimits& GetMemoryLimits()
+{
+    static const MemoryLimits limits = []
+    {
+        MemoryLimits result = {};
+        result.installedRAM = PlatformHelper::CalculateInstalledRAM();
+        PlatformHelper::ReadSystemMemoryLimits(result.commitLimit, result.addressSpace);
+        PlatformHelper::ReadJobMemoryLimits(result.jobProcessLimit, result.jobLimit);
+
+        // one reservation can't take the whole address space, other allocations need it too
+        result.effectiveLimit = std::min<size_t>({ result.commitLimit != 0 ? result.commitLimit : result.installedRAM,
+            result.addressSpace != 0 ? result.addressSpace / 2 : SIZE_MAX, result.jobProcessLimit, result.jobLimit });
+        return result;
+    }();
+    return limits;
+}
+
+namespace detail
+{
+
+// Size in bytes with an optional K, M or G suffix (e.g. "512M"), 0 if the text isn't a size
+[[nodiscard]] inline size_t ParseReserveSize(const char* text) noexcept
+{
+    size_t bytes = 0;
+    for (; *text >= '0' && *text <= '9'; text++)
+    {
+        if (bytes > (SIZE_MAX - 9) / 10)
+        {
+            return 0;
+        }
+        bytes = bytes * 10 + static_cast<size_t>(*text - '0');
+    }
+
+    size_t multiplier = 1;
+    switch (*text)
+    {
+    case 'K': case 'k': multiplier = DS_KB(1); text++; break;
+    case 'M': case 'm': multiplier = DS_MB(1); text++; break;
+    case 'G': case 'g': multiplier = DS_GB(1); text++; break;
+    default: break;
+    }
+    if (*text != '\0' || bytes > SIZE_MAX / multiplier)
+    {
+        return 0;
+    }
+    return bytes * multiplier;
+}
+
+} // namespace detail end
+
+// Reservation size of a RuntimeSizePolicyTag vector: the explicit size, otherwise the environment variable,
+// otherwise the default. Lets a deployment tune memory without recompiling.
+struct ReserveConfig
+{
+    size_t reserveBytes = 0;                                // explicit size, 0 to read the environment variable
+    const char* environmentVariable = "DS_RESERVE_SIZE";    // bytes with an optional K/M/G suffix, nullptr to not read any
+    size_t defaultReserveBytes = DS_GB(4);
+
+    [[nodiscard]] size_t Resolve() const
+    {
+        if (reserveBytes != 0)
+        {
+            return reserveBytes;
+        }
+
+        char value[32] = {};
+        if (environmentVariable != nullptr && PlatformHelper::ReadEnvironmentVariable(environmentVariable, value, sizeof(value)))
+        {
+            const size_t bytes = detail::ParseReserveSize(value);
+            if (bytes != 0)
+            {
+                return bytes;
+            }
+        }
+        return defaultReserveBytes;
+    }
+};
+
+// Amount of bytes to reserve for the policy (not aligned to page size yet).
+// Shared with other containers which manage their own reservation (file-backed, shared memory, etc.)
+template <typename ReservePolicy>
+[[nodiscard]] inline size_t CalculateReserveBytesForPolicy()
+{
+    constexpr size_t GigabyteInBytes = 1024 * 1024 * 1024;
+    if constexpr (std::is_same_v<ReservePolicy, _4GBSisePolicyTag>)
+    {
+        return GigabyteInBytes * 4;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, _8GBSisePolicyTag>)
+    {
+        return GigabyteInBytes * 8;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, _16GBSisePolicyTag>)
+    {
+        return GigabyteInBytes * 16;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, RAMSizePolicyTag>)
+    {
+        return PlatformHelper::CalculateInstalledRAM();
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, RAMDoubleSizePolicyTag>)
+    {
+        return PlatformHelper::CalculateInstalledRAM() * 2;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, ContainerLimitPolicyTag>)
+    {
+        return GetMemoryLimits().effectiveLimit;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, RuntimeSizePolicyTag>)
+    {
+        // default config, the environment is read once
+        static const size_t bytes = ReserveConfig{}.Resolve();
+        return bytes;
+    }
+    else if constexpr (is_custom_sizing_policy<ReservePolicy>::value)
+    {
+        return ReservePolicy::size;
+    }
+    else
+    {
+        // TODO find a way to make it static_assert
+        //assert(false && "Unallowed Reserve Policy type is used! Use RAMSizePolicyTag, RAMDoubleSizePolicyTag or CustomSizePolicyTag");
+        throw std::logic_error("Unallowed Reserve Policy type is used! Use RAMSizePolicyTag, RAMDoubleSizePolicyTag, ContainerLimitPolicyTag, RuntimeSizePolicyTag or CustomSizePolicyTag");
+    }
+}
+
+// Index of the policy in memory statistics, see MemoryStatsPolicyNames
+template <typename ReservePolicy>
+[[nodiscard]] constexpr size_t CalculatePolicyStatsIndex() noexcept
+{
+    if constexpr (std::is_same_v<ReservePolicy, _4GBSisePolicyTag>)
+    {
+        return 0;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, _8GBSisePolicyTag>)
+    {
+        return 1;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, _16GBSisePolicyTag>)
+    {
+        return 2;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, RAMSizePolicyTag>)
+    {
+        return 3;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, RAMDoubleSizePolicyTag>)
+    {
+        return 4;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, ContainerLimitPolicyTag>)
+    {
+        return 5;
+    }
+    else if constexpr (std::is_same_v<ReservePolicy, RuntimeSizePolicyTag>)
+    {
+        return 6;
+    }
+    else
+    {
+        return 7;
+    }
+}
+
+// Memory footprint of a single vector
+struct VectorMemoryStats
+{
+    size_t reservedBytes;
+    size_t committedBytes;
+    size_t usedBytes;                   // GetSize() elements, the rest of committed bytes is slack
+};
+
+// Result of TryReserve(), Reserve() throws std::bad_alloc instead of anything except Success
+enum class ReserveResult : uint8_t
+{
+    Success,
+    ExceedsReservation,                 // the vector can't grow beyond the reserve of its policy
+    BudgetExceeded,                     // the commit budget of the vector refused the commit (see GrowingVectorVMBudget.h)
+    CommitFailed,                       // the OS refused the commit (commit limit is reached)
+    Frozen                              // the vector is frozen, Unfreeze() it first
+};
+
+// Reservation of a vector which is being released with everything needed to account for it
+struct ReservationRelease
+{
+    void* reservation;
+    size_t reservedBytes;
+    size_t committedBytes;
+    CommitBudget* budget;               // refunded with committedBytes once the memory is released, can be nullptr
+    size_t policyStatsIndex;            // see CalculatePolicyStatsIndex()
+};
+
+// Hook which can take over the release of a reservation (see DeferredRelease.h).
+// Returns true if the reservation is taken and will be released later with ReleaseReservation(), false to release it right away.
+using ReleaseInterceptor = bool (*)(const ReservationRelease& release) noexcept;
+
+[[nodiscard]] inline std::atomic<ReleaseInterceptor>& GetReleaseInterceptor() noexcept
+{
+    static std::atomic<ReleaseInterceptor> interceptor{ nullptr };
+    return interceptor;
+}
+
+// Releases the reservation, the budget is refunded and the release is counted only after the memory is given back
+inline bool ReleaseReservation(const ReservationRelease& release) noexcept
+{
+    DS_MEMORY_EVENT(const uint64_t releaseStart = detail::ReadTimestampCounter());
+    const bool success = PlatformHelper::ReleaseVirtualMemory(release.reservation);
+    assert(success);
+    DS_MEMORY_EVENT(detail::EmitMemoryEvent(MemoryEventType::Release, release.reservation, release.reservedBytes, releaseStart));
+    DS_MEMORY_STATS(detail::MemoryStatsCounters::GetInstance().RecordRelease(release.policyStatsIndex, release.reservedBytes, release.committedBytes));
+    if (release.budget != nullptr)
+    {
+        release.budget->Refund(release.committedBytes);
+    }
+    return success;
+}
+
 // TODO analyze what can be constexpr and nodiscard again in the code?
 // TODO validate that iterators are compatible with each other (_Compat method in STL)
 // Custom iterator classes
@@ -450,6 +811,54 @@ public:
 
 
 
+// Read-only window into a frozen GrowingVectorVM (see GrowingVectorVM::Freeze): just a pointer and a size,
+// so it's cheap to copy and can be shared between threads without synchronization. Valid while the vector
+// stays frozen and alive.
+template<typename T>
+class FrozenView
+{
+public:
+    using value_type = T;
+    using const_pointer = const T*;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using const_iterator = const T*;
+
+    FrozenView() noexcept = default;
+    FrozenView(const T* data, const size_type size) noexcept
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    [[nodiscard]] inline size_type GetSize() const noexcept { return m_size; }
+    [[nodiscard]] inline bool Empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] inline const_pointer GetData() const noexcept { return m_data; }
+
+    [[nodiscard]] inline const_reference operator[](const size_type index) const noexcept
+    {
+        assert(index < m_size);
+        return m_data[index];
+    }
+
+    [[nodiscard]] const_reference At(const size_type index) const
+    {
+        if (index >= m_size)
+        {
+            throw std::out_of_range{ "Index is out of range" };
+        }
+        return m_data[index];
+    }
+
+    [[nodiscard]] inline const_iterator Begin() const noexcept { return m_data; }
+    [[nodiscard]] inline const_iterator End() const noexcept { return m_data + m_size; }
+
+private:
+    const T* m_data = nullptr;
+    size_type m_size = 0;
+};
+
+
 // Some examples which helps to understand expected behavior from this type of container
 //{
 //    GrowingVectorVM<int, _4GBSisePolicyTag> vec; // default ctor
@@ -502,6 +911,8 @@ public:
     // TODO LargePagesEnabled wasn't tested at all, so no guarantee that it works as expected in this implementation, so comment it out to not confuse the end user side.
     // Keep this as good point to extend the functionality.
     static constexpr bool IsLargePagesEnabled = false;
+    static constexpr size_t PolicyStatsIndex = CalculatePolicyStatsIndex<ReservePolicy>();
+    static constexpr bool IsRuntimeSized = std::is_same_v<ReservePolicy, RuntimeSizePolicyTag>;
     using iterator = Iterator<SelfType>;
     using const_iterator = ConstIterator<SelfType>;
 
@@ -513,6 +924,12 @@ public:
     GrowingVectorVM();
     ~GrowingVectorVM() noexcept;
 
+    // Runtime sized vector: all sizes share the type, so they can be moved, swapped and copied into each other
+    explicit GrowingVectorVM(const ReserveConfig& config) requires std::is_same_v<ReservePolicy, RuntimeSizePolicyTag>
+        : GrowingVectorVM(config.Resolve(), ReserveBytesTag{})
+    {
+    }
+
     // From cppreference: After the move, other is guaranteed to be empty().
     GrowingVectorVM(GrowingVectorVM&& other) noexcept
         : m_data(std::exchange(other.m_data, nullptr))
@@ -520,13 +937,23 @@ public:
         , m_committedPages(std::exchange(other.m_committedPages, 0))
         , m_reservedPages(std::exchange(other.m_reservedPages, 0))
         , m_pageSize(std::exchange(other.m_pageSize, 0))
+        , m_isFrozen(std::exchange(other.m_isFrozen, false))
+        , m_budget(std::exchange(other.m_budget, nullptr))
+        , m_isTrimmable(std::exchange(other.m_isTrimmable, false))
     {
+        if (m_isTrimmable)
+        {
+            other.UpdateRegistration();
+            UpdateRegistration();
+        }
+        DS_TRACE_OPERATION(MoveConstruct, reinterpret_cast<uintptr_t>(&other), 0);
     }
 
     GrowingVectorVM& operator=(GrowingVectorVM&& other) noexcept
     {
         if (this != &other)
         {
+            DS_TRACE_OPERATION(MoveAssign, reinterpret_cast<uintptr_t>(&other), 0);
             ReleaseMemory();
 
             m_data = std::exchange(other.m_data, nullptr);
@@ -534,6 +961,15 @@ public:
             m_committedPages = std::exchange(other.m_committedPages, 0);
             m_reservedPages = std::exchange(other.m_reservedPages, 0);
             m_pageSize = std::exchange(other.m_pageSize, 0);
+            m_isFrozen = std::exchange(other.m_isFrozen, false);
+            m_budget = std::exchange(other.m_budget, nullptr);
+            const bool wasTrimmable = m_isTrimmable;
+            m_isTrimmable = std::exchange(other.m_isTrimmable, false);
+            if (wasTrimmable || m_isTrimmable)
+            {
+                other.UpdateRegistration();
+                UpdateRegistration();
+            }
         }
 
         return *this;
@@ -542,12 +978,29 @@ public:
     // Be careful that memory reserve should be done for another vector as well and it will throw (with bad alloc) without careful setup.
     // TODO (optional) resolve this restriction to have exactly the same type (including ReservePolicy). other.Size() and current Reserve policy should be compared
     GrowingVectorVM(const SelfType& other)
-        : GrowingVectorVM() // initial reserve
+        : GrowingVectorVM(IsRuntimeSized ? other.GetReservedBytes() : CalculateReserveBytesForPolicy<ReservePolicy>(), ReserveBytesTag{}) // initial reserve
     {
         ConstructN(other.GetSize(), other.CBegin(), other.CEnd());
     }
     GrowingVectorVM& operator=(const SelfType& other)
     {
+        ThrowIfFrozen();
+        if (this == &other)
+        {
+            return *this;
+        }
+        if constexpr (IsRuntimeSized)
+        {
+            if (GetReservedBytes() != other.GetReservedBytes())
+            {
+                // the reservation can't be resized in place, so the copy gets the reservation of other and takes over
+                SelfType copy(other);
+                copy.SetCommitBudget(m_budget);
+                copy.SetTrimmable(m_isTrimmable);
+                Swap(copy);
+                return *this;
+            }
+        }
         if (!Empty())
         {
             Clear();
@@ -587,6 +1040,7 @@ public:
     GrowingVectorVM& operator=(std::initializer_list<T> ilist)
     {
         // Naive implementation but I clearly ok with it now
+        ThrowIfFrozen();
         Clear();
         ConstructN(ilist.size(), ilist.begin(), ilist.end());
 
@@ -595,16 +1049,26 @@ public:
 
     void Swap(SelfType& other) noexcept
     {
+        DS_TRACE_OPERATION(Swap, reinterpret_cast<uintptr_t>(&other), 0);
         std::swap(m_data, other.m_data);
         std::swap(m_size, other.m_size);
         std::swap(m_committedPages, other.m_committedPages);
         std::swap(m_reservedPages, other.m_reservedPages);
         std::swap(m_pageSize, other.m_pageSize);
+        std::swap(m_isFrozen, other.m_isFrozen);
+        std::swap(m_budget, other.m_budget);
+        if (m_isTrimmable != other.m_isTrimmable)
+        {
+            std::swap(m_isTrimmable, other.m_isTrimmable);
+            UpdateRegistration();
+            other.UpdateRegistration();
+        }
     }
 
     [[nodiscard]] inline size_type GetSize() const noexcept { return m_size; }
     [[nodiscard]] inline size_type GetCapacity() const noexcept { return CalculateObjectAmountForNBytes(GetCommittedBytes()); }
     [[nodiscard]] inline size_type GetReserve() const noexcept { return CalculateObjectAmountForNBytes(GetReservedBytes()); }
+    [[nodiscard]] inline VectorMemoryStats GetStats() const noexcept { return { GetReservedBytes(), GetCommittedBytes(), GetSize() * ElementSize }; }
     [[nodiscard]] size_type GetPageSize() const noexcept
     {
         if (m_pageSize == 0) [[unlikely]]
@@ -658,6 +1122,32 @@ public:
         CommitOverallMemory(elementAmount * ElementSize);
     }
 
+    // Same as Reserve() but reports why the memory can't be committed instead of throwing
+    [[nodiscard]] ReserveResult TryReserve(const size_t elementAmount) noexcept
+    {
+        return TryCommitOverallMemory(elementAmount * ElementSize);
+    }
+
+    // Committed bytes are moved from the current budget to the new one (even above its limit), nullptr means no budget
+    void SetCommitBudget(CommitBudget* budget) noexcept
+    {
+        if (budget == m_budget)
+        {
+            return;
+        }
+        if (m_budget != nullptr)
+        {
+            m_budget->Refund(GetCommittedBytes());
+        }
+        if (budget != nullptr)
+        {
+            budget->ForceCharge(GetCommittedBytes());
+        }
+        m_budget = budget;
+    }
+
+    [[nodiscard]] inline CommitBudget* GetCommitBudget() const noexcept { return m_budget; }
+
     [[nodiscard]] inline bool Empty() const noexcept { return GetSize() == 0; }
 
     [[nodiscard]] const value_type& operator[](size_type index) const
@@ -751,6 +1241,7 @@ public:
 
     iterator Insert(const_iterator position, const size_type count, const value_type& value)
     {
+        ThrowIfFrozen();
         if (GetCapacity() < GetSize() + count)
         {
             // [README] Naive solution, potentially can be rewritten in the future.
@@ -770,6 +1261,7 @@ public:
         std::uninitialized_fill_n(nonConstPosition, count, value);
 
         m_size += count;
+        DS_TRACE_OPERATION(Insert, offset, count);
 
         return nonConstPosition;
     }
@@ -785,12 +1277,14 @@ public:
         }
 
         assert(index >= 0);
+        ThrowIfFrozen();
 
         ReallocateIfNeed();
 
         ShiftElementsToTheRight(Begin() + index, 1);
 
         EmplaceAtPlace(&m_data[index], std::forward<Args...>(args)...);
+        DS_TRACE_OPERATION(Insert, index, 1);
 
         // Return iterator pointing to the inserted element
         return Begin() + index;
@@ -841,6 +1335,7 @@ public:
             return MakeNonConstIterator(last);
         }
 
+        ThrowIfFrozen();
         const bool hasLastElementAffected = last == CEnd();
 
         // Destructing range
@@ -856,6 +1351,7 @@ public:
         }
 
         m_size -= removingRangeSize;
+        DS_TRACE_OPERATION(Erase, positionOffset, removingRangeSize);
 
         return Begin() + positionOffset;
     }
@@ -863,14 +1359,16 @@ public:
     void Clear() noexcept
     {
         // README Didn't use Resize(0) to not trigger assert(is_default_constructible) in else-constexpr section there (thank you c++)
-
-        if (GetSize() == 0)
+        // noexcept, so unlike other modifying calls it can't throw for a frozen vector: it does nothing instead
+        assert(!m_isFrozen && "Unfreeze() the vector first");
+        if (m_isFrozen || GetSize() == 0)
         {
             return;
         }
 
         PlatformHelper::NullifyMemory(m_data, GetSize() * ElementSize);
         m_size = 0;
+        DS_TRACE_OPERATION(Clear, 0, 0);
     }
 
     template <typename U>
@@ -880,7 +1378,9 @@ public:
         {
             return;
         }
-        else if (newSize < GetSize())
+
+        ThrowIfFrozen();
+        if (newSize < GetSize())
         {
             PlatformHelper::NullifyMemory(m_data + newSize, (GetSize() - newSize) * ElementSize);
             m_size = newSize;
@@ -905,6 +1405,7 @@ public:
 
             m_size = newSize;
         }
+        DS_TRACE_OPERATION(Resize, newSize, 0);
     }
 
     void Resize(const size_type newSize)
@@ -912,11 +1413,155 @@ public:
         Resize(newSize, DefaultContructTag{}); // spied on STL
     }
 
+    // For tables which never change after build: used pages become read-only and committed pages behind them are
+    // decommitted, so exactly the used memory stays charged. Modifying calls of a frozen vector throw std::logic_error
+    // (TryReserve() returns ReserveResult::Frozen, noexcept Clear() asserts and does nothing) and writes through
+    // references or iterators are access violations, Unfreeze() it first.
+    // Note: the reservation itself stays, a part of it can't be released on Windows.
+    FrozenView<T> Freeze()
+    {
+        if (!m_isFrozen)
+        {
+            DecommitUnusedPages();
+
+            const size_t usedPages = m_committedPages;
+            if (usedPages > 0 && !PlatformHelper::ProtectVirtualMemory(m_data, usedPages * GetPageSize(), true))
+            {
+                throw std::runtime_error{ "Failed to protect the memory" };
+            }
+            m_isFrozen = true;
+        }
+
+        return FrozenView<T>(GetData(), GetSize());
+    }
+
+    void Unfreeze()
+    {
+        if (!m_isFrozen)
+        {
+            return;
+        }
+
+        if (m_committedPages > 0 && !PlatformHelper::ProtectVirtualMemory(m_data, GetCommittedBytes(), false))
+        {
+            throw std::runtime_error{ "Failed to unprotect the memory" };
+        }
+        if constexpr (CommitPagesWithReserve)
+        {
+            // growth doesn't commit anything in this mode, so the whole reservation has to be committed back
+            if (m_committedPages < m_reservedPages)
+            {
+                void* tail = reinterpret_cast<char*>(m_data) + GetCommittedBytes();
+                if (m_budget != nullptr && !m_budget->Charge(GetReservedBytes() - GetCommittedBytes()))
+                {
+                    throw std::bad_alloc{};
+                }
+                DS_MEMORY_STATS(const auto commitStart = std::chrono::steady_clock::now());
+                DS_MEMORY_EVENT(const uint64_t commitTicks = detail::ReadTimestampCounter());
+                if (PlatformHelper::CommitVirtualMemory(tail, GetReservedBytes() - GetCommittedBytes()) == nullptr)
+                {
+                    DS_MEMORY_EVENT(detail::EmitMemoryEvent(MemoryEventType::CommitFailure, m_data, GetReservedBytes() - GetCommittedBytes(), commitTicks));
+                    if (m_budget != nullptr)
+                    {
+                        m_budget->Refund(GetReservedBytes() - GetCommittedBytes());
+                    }
+                    throw std::bad_alloc{};
+                }
+                DS_MEMORY_EVENT(detail::EmitMemoryEvent(MemoryEventType::Commit, m_data, GetReservedBytes() - GetCommittedBytes(), commitTicks));
+                DS_MEMORY_STATS(detail::MemoryStatsCounters::GetInstance().RecordCommit(PolicyStatsIndex, GetReservedBytes() - GetCommittedBytes(), std::chrono::steady_clock::now() - commitStart));
+                m_committedPages = m_reservedPages;
+            }
+        }
+        m_isFrozen = false;
+    }
+
+    [[nodiscard]] inline bool IsFrozen() const noexcept { return m_isFrozen; }
+
+    // Trimmable vectors are registered for TrimAll() (see GrowingVectorVMRegistry.h), nothing is registered by default.
+    // Mark only vectors the caller owns and trims on the owning thread. The flag follows the content on move and swap,
+    // without DS_ENABLE_VECTOR_REGISTRY it's only stored.
+    void SetTrimmable(const bool trimmable) noexcept
+    {
+        m_isTrimmable = trimmable;
+        UpdateRegistration();
+    }
+
+    [[nodiscard]] inline bool IsTrimmable() const noexcept { return m_isTrimmable; }
+
+    // Decommits committed pages behind the last element (the opposite of Reserve), returns the amount of decommitted bytes.
+    // Does nothing for frozen vectors (nothing to decommit) and in CommitPagesWithReserve mode (growth expects everything committed).
+    size_t ShrinkToFit() noexcept
+    {
+        if constexpr (CommitPagesWithReserve)
+        {
+            return 0;
+        }
+        else
+        {
+            return m_isFrozen ? 0 : DecommitUnusedPages();
+        }
+    }
+
+    // Committed bytes ShrinkToFit() would decommit
+    [[nodiscard]] size_t GetSlackBytes() const noexcept
+    {
+        if (CommitPagesWithReserve || m_isFrozen)
+        {
+            return 0;
+        }
+        return GetCommittedBytes() - CalculateAlignedMemorySize(GetSize() * ElementSize, GetPageSize());
+    }
+
 private:
+    size_t DecommitUnusedPages() noexcept
+    {
+        const size_t usedPages = CalculateAlignedMemorySize(GetSize() * ElementSize, GetPageSize()) / GetPageSize();
+        if (m_committedPages <= usedPages)
+        {
+            return 0;
+        }
+
+        const size_t decommittedBytes = (m_committedPages - usedPages) * GetPageSize();
+        void* tail = reinterpret_cast<char*>(m_data) + usedPages * GetPageSize();
+        DS_MEMORY_EVENT(const uint64_t decommitStart = detail::ReadTimestampCounter());
+        PlatformHelper::DecommitVirtualMemory(tail, decommittedBytes);
+        DS_MEMORY_EVENT(detail::EmitMemoryEvent(MemoryEventType::Decommit, m_data, decommittedBytes, decommitStart));
+        DS_MEMORY_STATS(detail::MemoryStatsCounters::GetInstance().RecordDecommit(PolicyStatsIndex, decommittedBytes));
+        if (m_budget != nullptr)
+        {
+            m_budget->Refund(decommittedBytes);
+        }
+        m_committedPages = usedPages;
+
+        return decommittedBytes;
+    }
+
     bool InitialReserveBytes(const size_t requestedBytes);
 
     // Note: can throw with bad_alloc if reserve limitation is exceed or allocation was failed
-    void CommitOverallMemory(const size_t bytes);
+    void CommitOverallMemory(const size_t bytes)
+    {
+        const ReserveResult result = TryCommitOverallMemory(bytes);
+        if (result == ReserveResult::Frozen)
+        {
+            throw std::logic_error{ "The vector is frozen, Unfreeze() it first" };
+        }
+        if (result != ReserveResult::Success)
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    // Pages of a frozen vector are read-only and its slack is decommitted, so any modification has to fail early
+    void ThrowIfFrozen() const
+    {
+        if (m_isFrozen)
+        {
+            throw std::logic_error{ "The vector is frozen, Unfreeze() it first" };
+        }
+    }
+
+    [[nodiscard]] ReserveResult TryCommitOverallMemory(const size_t bytes) noexcept;
 
     void CommitAdditionalPage()
     {
@@ -929,12 +1574,15 @@ private:
         {
             return true;
         }
-
-        const bool success = PlatformHelper::ReleaseVirtualMemory(m_data);
-        assert(success);
+        const ReservationRelease release{ m_data, GetReservedBytes(), GetCommittedBytes(), m_budget, PolicyStatsIndex };
         m_data = nullptr;
 
-        return success;
+        const ReleaseInterceptor interceptor = GetReleaseInterceptor().load(std::memory_order_acquire);
+        if (interceptor != nullptr && interceptor(release))
+        {
+            return true;
+        }
+        return ReleaseReservation(release);
     }
 
     void ReallocateIfNeed()
@@ -950,8 +1598,10 @@ private:
     template<typename... Args>
     void EmplaceBackReallocate(Args&&... args)
     {
+        ThrowIfFrozen();
         ReallocateIfNeed();
         EmplaceAtPlace(&m_data[GetSize()], std::forward<Args...>(args)...);
+        DS_TRACE_OPERATION(Append, GetSize() - 1, 1);
     }
 
     template<typename... Args>
@@ -984,6 +1634,7 @@ private:
         }
 
         m_size += count;
+        DS_TRACE_OPERATION(Resize, m_size, 0);
     }
 
     static __forceinline iterator MakeNonConstIterator(pointer ptr) noexcept
@@ -1034,6 +1685,12 @@ protected:
         explicit DefaultContructTag() = default;
     };
 
+    struct ReserveBytesTag { // tag to identify construction with the reservation size
+        explicit ReserveBytesTag() = default;
+    };
+
+    GrowingVectorVM(size_t reserveBytes, ReserveBytesTag);
+
     [[nodiscard]] inline size_t GetCommittedBytes() const noexcept { return m_committedPages * GetPageSize(); }
     [[nodiscard]] inline size_t GetReservedBytes() const noexcept { return m_reservedPages * GetPageSize(); }
 
@@ -1088,6 +1745,20 @@ protected:
 
         return alignedGrowthSize;
     }
+
+    void UpdateRegistration() noexcept
+    {
+#if DS_ENABLE_VECTOR_REGISTRY
+        if (m_isTrimmable)
+        {
+            detail::VectorRegistry::GetInstance().Register(this, &detail::GetSlackBytesOf<SelfType>, &detail::ShrinkToFitOf<SelfType>);
+        }
+        else
+        {
+            detail::VectorRegistry::GetInstance().Unregister(this);
+        }
+#endif
+    }
     /////////////////////////////////////////////////////////////////////////////////////////
 
 private:
@@ -1098,6 +1769,9 @@ private:
     size_t m_committedPages;
     size_t m_reservedPages;
     mutable size_t m_pageSize; // mutable is used here to initialize the value in getter after reset
+    bool m_isFrozen;
+    CommitBudget* m_budget; // charged by every commit, nullptr if there is no budget
+    bool m_isTrimmable; // registered for TrimAll(), see SetTrimmable()
 };
 
 
@@ -1105,46 +1779,23 @@ private:
 ////////////////// IMPLEMENTATION //////////////////////////////
 template<typename T, typename ReservePolicy, bool CommitPagesWithReserve>
 inline GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>::GrowingVectorVM()
+    : GrowingVectorVM(CalculateReserveBytesForPolicy<ReservePolicy>(), ReserveBytesTag{})
+{
+}
+
+template<typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+inline GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>::GrowingVectorVM(const size_t reserveBytes, ReserveBytesTag)
     : m_data(nullptr)
     , m_size(0)
     , m_committedPages(0)
     , m_reservedPages(0)
+    , m_isFrozen(false)
+    , m_budget(GetDefaultCommitBudget().load(std::memory_order_acquire))
+    , m_isTrimmable(false)
 {
     m_pageSize = PlatformHelper::CalculateVirtualPageSize(false);
 
-    unsigned long long TotalMemoryInBytes = 0;
-    constexpr size_t GigabyteInBytes = 1024 * 1024 * 1024;
-    if constexpr (std::is_same_v<ReservePolicy, _4GBSisePolicyTag>)
-    {
-        TotalMemoryInBytes = GigabyteInBytes * 4;
-    }
-    else if constexpr (std::is_same_v<ReservePolicy, _8GBSisePolicyTag>)
-    {
-        TotalMemoryInBytes = GigabyteInBytes * 8;
-    }
-    else if constexpr (std::is_same_v<ReservePolicy, _16GBSisePolicyTag>)
-    {
-        TotalMemoryInBytes = GigabyteInBytes * 16;
-    }
-    else if constexpr (std::is_same_v<ReservePolicy, RAMSizePolicyTag>)
-    {
-        TotalMemoryInBytes = PlatformHelper::CalculateInstalledRAM();
-    }
-    else if constexpr (std::is_same_v<ReservePolicy, RAMDoubleSizePolicyTag>)
-    {
-        TotalMemoryInBytes = PlatformHelper::CalculateInstalledRAM() * 2;
-    }
-    else if constexpr (is_custom_sizing_policy<ReservePolicy>::value)
-    {
-        TotalMemoryInBytes = ReservePolicy::size;
-    }
-    else
-    {
-        // TODO find a way to make it static_assert
-        //assert(false && "Unallowed Reserve Policy type is used! Use RAMSizePolicyTag, RAMDoubleSizePolicyTag or CustomSizePolicyTag");
-        throw std::logic_error("Unallowed Reserve Policy type is used! Use RAMSizePolicyTag, RAMDoubleSizePolicyTag or CustomSizePolicyTag");
-    }
-
+    unsigned long long TotalMemoryInBytes = reserveBytes;
     if (TotalMemoryInBytes % GetPageSize() != 0)
     {
         TotalMemoryInBytes = CalculateAlignedMemorySize(TotalMemoryInBytes, GetPageSize());
@@ -1154,11 +1805,17 @@ inline GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>::GrowingVectorV
     {
         throw std::bad_alloc{};
     }
+    DS_TRACE_OPERATION(Create, ElementSize, GetReservedBytes());
 }
 
 template<typename T, typename ReservePolicy, bool CommitPagesWithReserve>
 inline GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>::~GrowingVectorVM() noexcept
 {
+    DS_TRACE_OPERATION(Destroy, 0, 0);
+    if (m_isTrimmable)
+    {
+        DS_VECTOR_REGISTRY(detail::VectorRegistry::GetInstance().Unregister(this));
+    }
     ReleaseMemory();
 }
 
@@ -1168,6 +1825,15 @@ inline bool GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>::InitialRe
     size_t requiredPages = 0;
     const size_t alignedGrowthSize = CalculateGrowthInternal(requestedBytes, &requiredPages);
 
+    if constexpr (CommitPagesWithReserve)
+    {
+        if (m_budget != nullptr && !m_budget->Charge(alignedGrowthSize))
+        {
+            return false;
+        }
+    }
+
+    DS_MEMORY_EVENT(const uint64_t reserveStart = detail::ReadTimestampCounter());
     void* memory = PlatformHelper::ReserveVirtualMemory(
         alignedGrowthSize,
         GetPageSize(),
@@ -1178,6 +1844,10 @@ inline bool GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>::InitialRe
 
     if (memory == nullptr)
     {
+        if (CommitPagesWithReserve && m_budget != nullptr)
+        {
+            m_budget->Refund(alignedGrowthSize);
+        }
         return false;
     }
 
@@ -1186,43 +1856,70 @@ inline bool GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>::InitialRe
 
     m_reservedPages = requiredPages;
     m_committedPages = CommitPagesWithReserve ? m_reservedPages : 0;
+    DS_MEMORY_STATS(detail::MemoryStatsCounters::GetInstance().RecordReserve(PolicyStatsIndex, GetReservedBytes(), GetCommittedBytes()));
+    DS_MEMORY_EVENT(detail::EmitMemoryEvent(MemoryEventType::Reserve, m_data, GetReservedBytes(), reserveStart));
 
     return true;
 }
 
 template<typename T, typename ReservePolicy, bool CommitPagesWithReserve>
-inline void GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>::CommitOverallMemory(const size_t bytes)
+inline ReserveResult GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>::TryCommitOverallMemory(const size_t bytes) noexcept
 {
+    if (m_isFrozen)
+    {
+        return ReserveResult::Frozen;
+    }
+
     if (bytes > GetReservedBytes())
     {
         // No extend mechanism is pre-designed, so that's strict limitation for end user.
-        throw std::bad_alloc();
+        DS_MEMORY_EVENT(detail::EmitMemoryEvent(MemoryEventType::Overflow, m_data, bytes, detail::ReadTimestampCounter()));
+        return ReserveResult::ExceedsReservation;
     }
 
     if constexpr (CommitPagesWithReserve)
     {
         // do absolutely nothing in this case
-        return;
+        return ReserveResult::Success;
     }
     
     if (bytes <= GetCommittedBytes())
     {
         // we already allocated required amount of memory, skip
-        return;
+        return ReserveResult::Success;
     }
 
     size_t requiredPages = 0;
     const size_t totalMemoryToCommit = CalculateGrowthInternal(bytes, &requiredPages);
+    if (m_budget != nullptr)
+    {
+        [[maybe_unused]] const size_t committedPages = m_committedPages;
+        if (!m_budget->Charge(totalMemoryToCommit))
+        {
+            return ReserveResult::BudgetExceeded;
+        }
+        assert(m_committedPages == committedPages && "Trim callback of the budget must not modify the committing vector");
+    }
 
     void* memoryToCommit = reinterpret_cast<char*>(m_data) + GetCommittedBytes();
+    DS_MEMORY_STATS(const auto commitStart = std::chrono::steady_clock::now());
+    DS_MEMORY_EVENT(const uint64_t commitTicks = detail::ReadTimestampCounter());
     void* committedMemory = PlatformHelper::CommitVirtualMemory(memoryToCommit, totalMemoryToCommit);
 
     if (committedMemory == nullptr)
     {
-        throw std::bad_alloc();
+        DS_MEMORY_EVENT(detail::EmitMemoryEvent(MemoryEventType::CommitFailure, m_data, totalMemoryToCommit, commitTicks));
+        if (m_budget != nullptr)
+        {
+            m_budget->Refund(totalMemoryToCommit);
+        }
+        return ReserveResult::CommitFailed;
     }
+    DS_MEMORY_EVENT(detail::EmitMemoryEvent(MemoryEventType::Commit, m_data, requiredPages * GetPageSize(), commitTicks));
+    DS_MEMORY_STATS(detail::MemoryStatsCounters::GetInstance().RecordCommit(PolicyStatsIndex, requiredPages * GetPageSize(), std::chrono::steady_clock::now() - commitStart));
 
     m_committedPages += requiredPages;
+    return ReserveResult::Success;
 }
 
 } // namespace ds end
@@ -1245,6 +1942,18 @@ namespace std
         return container.End();
     }
 
+    template<typename T>
+    inline const T* begin(const ds::FrozenView<T>& view) noexcept
+    {
+        return view.Begin();
+    }
+
+    template<typename T>
+    inline const T* end(const ds::FrozenView<T>& view) noexcept
+    {
+        return view.End();
+    }
+
     template<typename T, typename ReservePolicy, bool CommitPagesWithReserve>
     inline void swap(
         ds::GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& a,
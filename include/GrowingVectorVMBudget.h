@@ -0,0 +1,207 @@
+#pragma once
+
+// Commit budget shared by a group of GrowingVectorVM instances (e.g. one per tenant) or by the whole process.
+// The reservation limits a single vector only, so without a budget one runaway vector can commit all memory of
+// the machine. Every vector which has a budget charges it before a commit and refunds it on decommit and release.
+// A commit which doesn't fit the budget is handled by the policy of the budget:
+// - FailFast: the commit fails right away, Reserve()/PushBack() throw std::bad_alloc and TryReserve() returns
+//   ReserveResult::BudgetExceeded;
+// - Block: the thread waits until other vectors give memory back (or the timeout expires, then it fails);
+// - Trim: the trim callback is asked to free the missing bytes (e.g. drop caches owned by the same thread) and
+//   the charge is retried once.
+//
+// Charge and refund are a CAS/fetch_sub on a single atomic counter, nothing is locked. Waiting of the Block policy
+// uses WaitOnAddress, refunds wake waiters only if there are any.
+//
+// Usage:
+//    ds::CommitBudget budget(DS_GB(8));
+//    ds::GetDefaultCommitBudget().store(&budget);      // charged by vectors created afterwards
+//    ...
+//    vec.SetCommitBudget(&tenantBudget);               // or assign groups explicitly
+//
+// The budget must outlive vectors which charge it.
+//
+// Note: it doesn't include GrowingVectorVM.h, GrowingVectorVM.h includes it.
+
+#ifdef WIN32
+#include <windows.h>
+#include <synchapi.h>                   // for WaitOnAddress
+#pragma comment(lib, "Synchronization.lib")
+#else
+#error Unsupported
+#endif
+
+#include <stdint.h>
+#include <algorithm>                    // for std::min
+#include <atomic>
+
+
+namespace ds
+{
+
+enum class CommitBudgetPolicy : uint8_t
+{
+    FailFast,
+    Block,
+    Trim
+};
+
+// Asked to free at least `bytes` of the budget, called on the thread which is committing from inside the commit
+// of a vector: it must not modify that vector, nor vectors used by other threads (so not TrimAll() either).
+using CommitBudgetTrimCallback = void (*)(size_t bytes) noexcept;
+
+class CommitBudget
+{
+public:
+    static constexpr uint32_t InfiniteTimeout = INFINITE;
+
+    explicit CommitBudget(const size_t limitBytes, const CommitBudgetPolicy policy = CommitBudgetPolicy::FailFast,
+        const CommitBudgetTrimCallback trim = nullptr, const uint32_t blockTimeoutMs = InfiniteTimeout) noexcept
+        : m_limitBytes(limitBytes)
+        , m_policy(policy)
+        , m_trim(trim)
+        , m_blockTimeoutMs(blockTimeoutMs)
+    {
+    }
+
+    CommitBudget(const CommitBudget&) = delete;
+    CommitBudget& operator=(const CommitBudget&) = delete;
+
+    // Charges the budget if bytes fit the limit, never waits
+    [[nodiscard]] bool TryCharge(const size_t bytes) noexcept
+    {
+        const size_t limit = m_limitBytes.load(std::memory_order_relaxed);
+        size_t used = m_usedBytes.load(std::memory_order_relaxed);
+        do
+        {
+            if (used > limit || bytes > limit - used)
+            {
+                return false;
+            }
+        } while (!m_usedBytes.compare_exchange_weak(used, used + bytes, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        return true;
+    }
+
+    // Charges the budget applying the policy when bytes don't fit, returns false if they still don't
+    [[nodiscard]] bool Charge(const size_t bytes) noexcept
+    {
+        if (TryCharge(bytes)) [[likely]]
+        {
+            return true;
+        }
+
+        bool isCharged = false;
+        switch (m_policy)
+        {
+        case CommitBudgetPolicy::FailFast:
+            break;
+        case CommitBudgetPolicy::Block:
+            isCharged = WaitAndCharge(bytes);
+            break;
+        case CommitBudgetPolicy::Trim:
+            if (m_trim != nullptr)
+            {
+                m_trim(bytes - std::min<size_t>(bytes, GetAvailableBytes()));
+                isCharged = TryCharge(bytes);
+            }
+            break;
+        }
+
+        if (!isCharged)
+        {
+            m_rejectedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return isCharged;
+    }
+
+    // Charges even above the limit: for memory which is committed already (e.g. a vector moved to another group)
+    void ForceCharge(const size_t bytes) noexcept
+    {
+        m_usedBytes.fetch_add(bytes, std::memory_order_acq_rel);
+    }
+
+    void Refund(const size_t bytes) noexcept
+    {
+        m_usedBytes.fetch_sub(bytes); // seq_cst with the waiter counter, so a waiter can't be missed
+        WakeWaiters();
+    }
+
+    // Lowering the limit doesn't take anything back, further commits just fail until usage drops below it
+    void SetLimitBytes(const size_t limitBytes) noexcept
+    {
+        m_limitBytes.store(limitBytes, std::memory_order_release);
+        WakeWaiters();
+    }
+
+    [[nodiscard]] size_t GetLimitBytes() const noexcept { return m_limitBytes.load(std::memory_order_acquire); }
+    [[nodiscard]] size_t GetUsedBytes() const noexcept { return m_usedBytes.load(std::memory_order_acquire); }
+    [[nodiscard]] size_t GetAvailableBytes() const noexcept { return GetLimitBytes() - std::min<size_t>(GetUsedBytes(), GetLimitBytes()); }
+    [[nodiscard]] size_t GetRejectedCount() const noexcept { return m_rejectedCount.load(std::memory_order_relaxed); }
+    [[nodiscard]] CommitBudgetPolicy GetPolicy() const noexcept { return m_policy; }
+
+private:
+    bool WaitAndCharge(const size_t bytes) noexcept
+    {
+#if WIN32
+        m_waiterCount.fetch_add(1);
+        const ULONGLONG start = GetTickCount64();
+        bool isCharged = false;
+        while (!(isCharged = TryCharge(bytes)))
+        {
+            DWORD timeout = INFINITE;
+            if (m_blockTimeoutMs != InfiniteTimeout)
+            {
+                const ULONGLONG elapsed = GetTickCount64() - start;
+                if (elapsed >= m_blockTimeoutMs)
+                {
+                    break;
+                }
+                timeout = static_cast<DWORD>(m_blockTimeoutMs - elapsed);
+            }
+
+            size_t used = m_usedBytes.load();
+            if (bytes <= GetLimitBytes() - std::min<size_t>(used, GetLimitBytes()))
+            {
+                continue; // refunded in between, no need to wait
+            }
+            // wakes up on refund or limit change (spurious wake-ups just retry)
+            WaitOnAddress(&m_usedBytes, &used, sizeof(used), timeout);
+        }
+        m_waiterCount.fetch_sub(1);
+        return isCharged;
+#else
+#error Not implemented
+#endif
+    }
+
+    void WakeWaiters() noexcept
+    {
+#if WIN32
+        if (m_waiterCount.load() > 0) [[unlikely]]
+        {
+            WakeByAddressAll(&m_usedBytes);
+        }
+#else
+#error Not implemented
+#endif
+    }
+
+private:
+    std::atomic<size_t> m_usedBytes = 0;
+    std::atomic<size_t> m_limitBytes;
+    std::atomic<uint32_t> m_waiterCount = 0;
+    std::atomic<size_t> m_rejectedCount = 0;
+    const CommitBudgetPolicy m_policy;
+    const CommitBudgetTrimCallback m_trim;
+    const uint32_t m_blockTimeoutMs;
+};
+
+// Budget which vectors created afterwards charge, nullptr (the default) means no budget
+[[nodiscard]] inline std::atomic<CommitBudget*>& GetDefaultCommitBudget() noexcept
+{
+    static std::atomic<CommitBudget*> budget{ nullptr };
+    return budget;
+}
+
+} // namespace ds end
@@ -0,0 +1,345 @@
+#pragma once
+
+// Incremental checkpoints of a live GrowingVectorVM: only pages modified since the previous checkpoint are written.
+//
+// Dirty pages are found with write trapping: tracked pages are read-only, the first write faults, the fault handler
+// marks the page dirty and makes it writable again (see PageFaultRouter). So every page costs at most one fault
+// per checkpoint interval. GetWriteWatch would be cheaper, but MEM_WRITE_WATCH can be requested only at reservation
+// time and would slow down every vector, so trapping is used here.
+//
+// Checkpoint file: DeltaHeader and then pairs of (uint64_t page index, page bytes).
+// ReplayCheckpoints() applies a chain of deltas to a base file of PersistentGrowingVectorVM format
+// (which can be created by the first checkpoint itself: everything is dirty right after the tracker is attached).
+//
+// Restrictions: tracked vector must not be shrunk (decommit) while the tracker is alive, size is read without
+// synchronization, so growing the vector concurrently with a checkpoint needs external synchronization.
+// In-place writes from other threads during a checkpoint are fine: pages are re-armed before being written out.
+// Clean tracked pages are read-only, and kernel writes into them (ReadFile into GetData(), LoadFrom(), ReadAppend())
+// don't fault, they fail with ERROR_NOACCESS (see PageFaultRouter): read into a buffer and copy, or attach the tracker after.
+//
+// ReplayCheckpoints() rejects a chain with gaps or out of order deltas (DeltaHeader::sequence), a new base has to
+// start from the checkpoint 0. The base doesn't store the sequence it was brought to, so continuing an existing base
+// is checked within the passed chain only.
+
+#include "PersistentGrowingVectorVM.h"
+#include "PageFaultRouter.h"
+#include "GrowingBitVectorVM.h"
+
+#include <initializer_list>
+#include <mutex>
+
+
+namespace ds
+{
+
+struct DeltaHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t pageSize;
+    uint64_t elementSize;
+    uint64_t elementAlignment;
+    uint64_t typeTag;
+    uint64_t sequence;                  // number of checkpoint produced by the tracker, starting from 0
+    uint64_t size;                      // amount of elements in the vector at the moment of checkpoint
+    uint64_t pageCount;                 // amount of pages which follow
+};
+
+static constexpr uint64_t DeltaMagic = 0x41544C4444564756ull;   // "VGVDDLTA"
+static constexpr uint32_t DeltaFormatVersion = 1;
+
+
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve = false>
+class DirtyPageTracker
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be saved as is");
+
+    using VectorType = GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>;
+
+    // If startClean is true, current content is considered saved already (e.g. by a snapshot),
+    // otherwise the first checkpoint contains all pages.
+    explicit DirtyPageTracker(VectorType& vec, const bool startClean = false)
+        : m_vector(&vec)
+        , m_pageSize(vec.GetPageSize())
+    {
+        // whole reservation is registered, so grown pages are routed here after they are armed
+        m_base = reinterpret_cast<std::byte*>(vec.Begin().operator->());
+        PageFaultRouter::GetInstance().Register(m_base, vec.GetReserve() * sizeof(T), &DirtyPageTracker::HandleFault, this);
+
+        if (startClean)
+        {
+            std::lock_guard lock(m_mutex);
+            m_dirty.Resize(CalculateUsedPages(), false);
+            SetProtection(0, m_dirty.GetSize(), false);
+            m_armedPages = m_dirty.GetSize();
+        }
+    }
+
+    ~DirtyPageTracker() noexcept
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            SetProtection(0, m_armedPages, true);
+            m_armedPages = 0;
+        }
+        PageFaultRouter::GetInstance().Unregister(m_base);
+    }
+
+    DirtyPageTracker(const DirtyPageTracker&) = delete;
+    DirtyPageTracker& operator=(const DirtyPageTracker&) = delete;
+
+    [[nodiscard]] size_t GetPageSize() const noexcept { return m_pageSize; }
+    [[nodiscard]] uint64_t GetCheckpointCount() const noexcept { return m_sequence; }
+
+    // Returns indices of pages modified (or added by growth) since the previous call and re-arms them
+    template <typename IndicesContainer>
+    void CollectDirtyPages(IndicesContainer& pages)
+    {
+        const size_t usedPages = CalculateUsedPages();
+
+        std::lock_guard lock(m_mutex);
+        const size_t trackedPages = std::min(m_armedPages, usedPages);
+        for (size_t page = 0; page < trackedPages; page++)
+        {
+            if (m_dirty.Test(page))
+            {
+                pages.PushBack(page);
+                m_dirty.Reset(page);
+            }
+        }
+        for (size_t page = trackedPages; page < usedPages; page++)
+        {
+            pages.PushBack(page); // pages which appeared after the last checkpoint
+        }
+
+        m_dirty.Resize(usedPages, false);
+        // pages are re-armed before their content is copied, so writes from now on go to the next checkpoint
+        for (size_t i = 0; i < pages.GetSize(); )
+        {
+            size_t runEnd = i + 1;
+            while (runEnd < pages.GetSize() && pages[runEnd] == pages[runEnd - 1] + 1)
+            {
+                runEnd++;
+            }
+            SetProtection(pages[i], pages[runEnd - 1] + 1 - pages[i], false);
+            i = runEnd;
+        }
+        m_armedPages = std::max(m_armedPages, usedPages);
+    }
+
+    // Writes dirty pages to the current position of the file, returns amount of written pages
+    size_t WriteIncrementalCheckpoint(HANDLE file)
+    {
+        GrowingVectorVM<size_t, ReservePolicy> pages;
+        CollectDirtyPages(pages);
+
+        DeltaHeader header = {};
+        header.magic = DeltaMagic;
+        header.version = DeltaFormatVersion;
+        header.pageSize = static_cast<uint32_t>(m_pageSize);
+        header.elementSize = sizeof(T);
+        header.elementAlignment = alignof(T);
+        header.typeTag = PersistentTypeTag<T>::value;
+        header.sequence = m_sequence;
+        header.size = m_vector->GetSize();
+        header.pageCount = pages.GetSize();
+        FileMappingHelper::WriteAll(file, &header, sizeof(header));
+
+        for (size_t i = 0; i < pages.GetSize(); i++)
+        {
+            const uint64_t pageIndex = pages[i];
+            FileMappingHelper::WriteAll(file, &pageIndex, sizeof(pageIndex));
+            // page is read-only again (the kernel only reads it), so it's written consistently unless it's modified
+            // right now, then it's dirty for the next checkpoint anyway
+            FileMappingHelper::WriteAll(file, m_base + pageIndex * m_pageSize, m_pageSize);
+        }
+
+        ++m_sequence;
+        return pages.GetSize();
+    }
+
+    size_t WriteIncrementalCheckpoint(const std::filesystem::path& path)
+    {
+        HANDLE file = FileMappingHelper::OpenFile(path, true);
+        try
+        {
+            const size_t pages = WriteIncrementalCheckpoint(file);
+            FileMappingHelper::CloseFile(file);
+            return pages;
+        }
+        catch (...)
+        {
+            FileMappingHelper::CloseFile(file);
+            throw;
+        }
+    }
+
+private:
+    static bool HandleFault(void* context, void* address, const bool isWrite)
+    {
+        return isWrite && static_cast<DirtyPageTracker*>(context)->MarkDirty(static_cast<const std::byte*>(address));
+    }
+
+    bool MarkDirty(const std::byte* address)
+    {
+        std::lock_guard lock(m_mutex);
+        const size_t page = static_cast<size_t>(address - m_base) / m_pageSize;
+        if (page >= m_armedPages || page >= m_dirty.GetSize())
+        {
+            return false; // not ours, e.g. access to uncommitted memory
+        }
+
+        if (!m_dirty.Test(page))
+        {
+            m_dirty.Set(page);
+            SetProtection(page, 1, true);
+        }
+        // otherwise it was handled by another thread already, just retry the access
+        return true;
+    }
+
+    [[nodiscard]] size_t CalculateUsedPages() const noexcept
+    {
+        return (m_vector->GetSize() * sizeof(T) + m_pageSize - 1) / m_pageSize;
+    }
+
+    bool SetProtection(const size_t firstPage, const size_t pageCount, const bool isWritable)
+    {
+        if (pageCount == 0)
+        {
+            return true;
+        }
+#if WIN32
+        DWORD oldProtection = 0;
+        return VirtualProtect(m_base + firstPage * m_pageSize, pageCount * m_pageSize, isWritable ? PAGE_READWRITE : PAGE_READONLY, &oldProtection);
+#else
+#error Not implemented
+#endif
+    }
+
+private:
+    VectorType* m_vector;
+    std::byte* m_base = nullptr;
+    size_t m_pageSize;
+    size_t m_armedPages = 0;            // pages [0, m_armedPages) are tracked (read-only unless dirty)
+    GrowingBitVectorVM<ReservePolicy> m_dirty;
+    uint64_t m_sequence = 0;
+    std::mutex m_mutex;                 // shared by fault handler and checkpointing thread
+};
+
+
+namespace detail
+{
+
+[[nodiscard]] inline DeltaHeader ReadDeltaHeader(HANDLE delta)
+{
+    DeltaHeader header = {};
+    FileMappingHelper::ReadAll(delta, &header, sizeof(header));
+    if (header.magic != DeltaMagic || header.version != DeltaFormatVersion)
+    {
+        throw std::runtime_error{ "File is not an incremental checkpoint" };
+    }
+    return header;
+}
+
+} // namespace detail
+
+
+// Applies deltas (in order) to the base file of PersistentGrowingVectorVM format, creates the base if it doesn't exist.
+// Throws std::runtime_error if a file is not a delta (or the base is not a vector file), was written for another
+// element type, or the chain is broken (see above). All delta headers are checked before the base is modified.
+inline void ReplayCheckpoints(const std::filesystem::path& basePath, std::initializer_list<std::filesystem::path> deltaPaths)
+{
+    using FileFormat = PersistentGrowingVectorVM<std::byte>;
+    constexpr size_t HeaderBytes = FileFormat::HeaderBytes;
+
+    const bool isNewBase = !std::filesystem::exists(basePath);
+    HANDLE base = FileMappingHelper::OpenFile(basePath, isNewBase);
+    HANDLE delta = INVALID_HANDLE_VALUE;
+    try
+    {
+        PersistentFileHeader baseHeader = {};
+        if (!isNewBase)
+        {
+            FileMappingHelper::ReadAll(base, &baseHeader, sizeof(baseHeader));
+            if (baseHeader.magic != FileFormat::Magic || baseHeader.version != FileFormat::FormatVersion || baseHeader.headerBytes != HeaderBytes)
+            {
+                throw std::runtime_error{ "Base is not a persistent vector file" };
+            }
+        }
+
+        // the sequence an existing base was brought to is unknown, so its first delta can have any sequence
+        uint64_t expectedSequence = 0;
+        bool isSequenceKnown = isNewBase;
+        for (const auto& deltaPath : deltaPaths)
+        {
+            delta = FileMappingHelper::OpenFile(deltaPath, false);
+            const DeltaHeader header = detail::ReadDeltaHeader(delta);
+            FileMappingHelper::CloseFile(delta);
+            delta = INVALID_HANDLE_VALUE;
+
+            if (isSequenceKnown && header.sequence != expectedSequence)
+            {
+                throw std::runtime_error{ "Checkpoints are out of order or some of them is missing" };
+            }
+            if (isNewBase && baseHeader.magic == 0)
+            {
+                baseHeader = { FileFormat::Magic, FileFormat::FormatVersion, FileFormat::HeaderBytes, header.elementSize, header.elementAlignment, header.typeTag, 0 };
+            }
+            if (baseHeader.elementSize != header.elementSize || baseHeader.elementAlignment != header.elementAlignment || baseHeader.typeTag != header.typeTag)
+            {
+                throw std::runtime_error{ "Checkpoint was written for another element type" };
+            }
+            expectedSequence = header.sequence + 1;
+            isSequenceKnown = true;
+        }
+
+        GrowingVectorVM<std::byte, CustomSizePolicyTag<DS_MB(16)>> page;
+        for (const auto& deltaPath : deltaPaths)
+        {
+            delta = FileMappingHelper::OpenFile(deltaPath, false);
+            const DeltaHeader header = detail::ReadDeltaHeader(delta);
+
+            page.Resize(header.pageSize);
+            for (uint64_t i = 0; i < header.pageCount; i++)
+            {
+                uint64_t pageIndex = 0;
+                FileMappingHelper::ReadAll(delta, &pageIndex, sizeof(pageIndex));
+                FileMappingHelper::ReadAll(delta, page.GetData(), header.pageSize);
+
+                FileMappingHelper::SetFilePosition(base, HeaderBytes + pageIndex * header.pageSize);
+                FileMappingHelper::WriteAll(base, page.GetData(), header.pageSize);
+            }
+            baseHeader.size = header.size;
+
+            FileMappingHelper::CloseFile(delta);
+            delta = INVALID_HANDLE_VALUE;
+        }
+
+        // the last page could be written beyond the size
+        if (!FileMappingHelper::SetFileSize(base, HeaderBytes + baseHeader.size * baseHeader.elementSize))
+        {
+            FileMappingHelper::ThrowLastError("Failed to truncate the base file");
+        }
+        FileMappingHelper::SetFilePosition(base, 0);
+        FileMappingHelper::WriteAll(base, &baseHeader, sizeof(baseHeader));
+    }
+    catch (...)
+    {
+        if (delta != INVALID_HANDLE_VALUE)
+        {
+            FileMappingHelper::CloseFile(delta);
+        }
+        FileMappingHelper::CloseFile(base);
+        if (isNewBase)
+        {
+            std::error_code error;
+            std::filesystem::remove(basePath, error); // half-written base is useless
+        }
+        throw;
+    }
+    FileMappingHelper::CloseFile(base);
+}
+
+} // namespace ds end
@@ -0,0 +1,139 @@
+#pragma once
+
+// Low-level memory events of all GrowingVectorVM instances: reserve, commit, decommit, release and overflow
+// (growth beyond the reservation or commit refused by the OS), with byte counts and rdtsc timestamps taken around
+// the system call. Meant for tail-latency investigations: was that spike a commit inside CommitOverallMemory?
+//
+// Two sinks, both compiled out by default, so the hot path is exactly as before:
+// - DS_ENABLE_MEMORY_EVENTS=1 (CMake option ENABLE_MEMORY_EVENTS): events go to the hook set via GetMemoryEventHook(),
+//   an unset hook costs one atomic load per event;
+// - DS_ENABLE_TRACELOGGING=1 (CMake option ENABLE_TRACELOGGING): events are also written to the ETW TraceLogging
+//   provider "GrowingVectorVM", so WPR/xperf/tracelog can attach to a running process without a rebuild
+//   (the Windows counterpart of USDT probes). Writing costs a single enabled check while no session listens.
+//   The provider is defined by src/GrowingVectorVMTraceLogging.cpp, which the CMake option adds to every target
+//   linking the library (without CMake, put DS_DEFINE_TRACELOGGING_PROVIDER() into exactly one .cpp file), and must
+//   be registered with RegisterTraceLoggingProvider() at startup.
+//
+// Usage:
+//    ds::GetMemoryEventHook().store([](const ds::MemoryEvent& event) noexcept { ... });
+//
+// Note: it doesn't include GrowingVectorVM.h, GrowingVectorVM.h includes it when any sink is enabled.
+
+#ifdef WIN32
+#include <windows.h>
+#include <intrin.h>                     // for __rdtsc
+#if DS_ENABLE_TRACELOGGING
+#include <TraceLoggingProvider.h>
+#endif
+#else
+#error Unsupported
+#endif
+
+#include <stdint.h>
+#include <atomic>
+
+
+namespace ds
+{
+
+enum class MemoryEventType : uint8_t
+{
+    Reserve,                            // bytes: reserved (and committed in CommitPagesWithReserve mode)
+    Commit,                             // bytes: newly committed
+    Decommit,                           // bytes: decommitted
+    Release,                            // bytes: reserved bytes given back
+    Overflow,                           // bytes: requested size which doesn't fit the reservation
+    CommitFailure                       // bytes: commit which was refused by the OS (commit limit reached)
+};
+
+struct MemoryEvent
+{
+    MemoryEventType type;
+    const void* reservation;            // base address of the vector memory
+    uint64_t bytes;
+    uint64_t startTicks;                // __rdtsc() before the system call
+    uint64_t endTicks;                  // __rdtsc() after it
+};
+
+// Called on the thread which caused the event, must be cheap and must not touch the vector
+using MemoryEventHook = void (*)(const MemoryEvent& event) noexcept;
+
+[[nodiscard]] inline std::atomic<MemoryEventHook>& GetMemoryEventHook() noexcept
+{
+    static std::atomic<MemoryEventHook> hook{ nullptr };
+    return hook;
+}
+
+
+#if DS_ENABLE_TRACELOGGING
+TRACELOGGING_DECLARE_PROVIDER(g_growingVectorTraceLoggingProvider);
+
+// Put it into exactly one .cpp file, unless src/GrowingVectorVMTraceLogging.cpp is built
+#define DS_DEFINE_TRACELOGGING_PROVIDER()                                                   \
+    TRACELOGGING_DEFINE_PROVIDER(g_growingVectorTraceLoggingProvider, "GrowingVectorVM",    \
+        (0x6f3c1a52, 0x8d4e, 0x4b7a, 0x9c, 0x21, 0x5e, 0x0f, 0x7d, 0x3a, 0x8b, 0x14))
+
+inline bool RegisterTraceLoggingProvider() noexcept
+{
+    return SUCCEEDED(TraceLoggingRegister(g_growingVectorTraceLoggingProvider));
+}
+
+inline void UnregisterTraceLoggingProvider() noexcept
+{
+    TraceLoggingUnregister(g_growingVectorTraceLoggingProvider);
+}
+#endif
+
+
+namespace detail
+{
+
+[[nodiscard]] inline uint64_t ReadTimestampCounter() noexcept
+{
+#if WIN32
+    return __rdtsc();
+#else
+#error Not implemented
+#endif
+}
+
+[[nodiscard]] constexpr const char* ToString(const MemoryEventType type) noexcept
+{
+    switch (type)
+    {
+    case MemoryEventType::Reserve:       return "Reserve";
+    case MemoryEventType::Commit:        return "Commit";
+    case MemoryEventType::Decommit:      return "Decommit";
+    case MemoryEventType::Release:       return "Release";
+    case MemoryEventType::Overflow:      return "Overflow";
+    case MemoryEventType::CommitFailure: return "CommitFailure";
+    }
+    return "Unknown";
+}
+
+inline void EmitMemoryEvent(const MemoryEventType type, const void* reservation, const uint64_t bytes, const uint64_t startTicks) noexcept
+{
+    const MemoryEvent event = { type, reservation, bytes, startTicks, ReadTimestampCounter() };
+
+#if DS_ENABLE_MEMORY_EVENTS
+    const MemoryEventHook hook = GetMemoryEventHook().load(std::memory_order_acquire);
+    if (hook != nullptr) [[unlikely]]
+    {
+        hook(event);
+    }
+#endif
+
+#if DS_ENABLE_TRACELOGGING
+    TraceLoggingWrite(g_growingVectorTraceLoggingProvider, "MemoryEvent",
+        TraceLoggingString(ToString(event.type), "Type"),
+        TraceLoggingPointer(event.reservation, "Reservation"),
+        TraceLoggingUInt64(event.bytes, "Bytes"),
+        TraceLoggingUInt64(event.startTicks, "StartTicks"),
+        TraceLoggingUInt64(event.endTicks, "EndTicks"));
+#endif
+    (void)event;
+}
+
+} // namespace detail end
+
+} // namespace ds end
@@ -0,0 +1,859 @@
+#pragma once
+
+// SIMD scan kernels over GrowingVectorVM (and raw contiguous ranges) for arithmetic element types.
+// Generic iterator path (std::find, std::count, ...) doesn't vectorize reliably through custom iterators,
+// so here is explicit SSE2/AVX2/AVX-512 code with runtime CPU dispatch.
+//
+// Notes:
+// - int32_t, float and double have dedicated SIMD paths, the rest of arithmetic types fall back to scalar code.
+// - GrowingVectorVM data is always page-aligned, so the head needs no peeling, only the ragged tail is processed separately.
+// - NaN values are not supported by MinMax (SIMD min/max and std::minmax_element disagree on them).
+
+#include "GrowingVectorVM.h"
+
+#include <intrin.h>                     // for __cpuid, __cpuidex
+#include <immintrin.h>                  // for SSE2/AVX2/AVX-512 intrinsics and _xgetbv
+#include <bit>                          // for std::countr_zero, std::popcount
+#include <algorithm>                    // for std::min
+#include <atomic>                       // for SIMD level override
+#include <utility>                      // for std::pair
+#include <type_traits>
+
+
+namespace ds
+{
+namespace simd
+{
+
+enum class SimdLevel : uint8_t
+{
+    Scalar = 0,
+    SSE2,
+    AVX2,
+    AVX512,
+};
+
+enum class CompareOp : uint8_t
+{
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+};
+
+// Sum is accumulated in a wider type to not overflow on big vectors (and to keep precision for float)
+template <typename T>
+using SumType = std::conditional_t<std::is_floating_point_v<T>, double,
+                    std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>;
+
+[[nodiscard]] inline SimdLevel DetectSimdLevel() noexcept
+{
+    int info[4] = {};
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool hasSSE2 = (info[3] & (1 << 26)) != 0;
+    const bool hasOSXSave = (info[2] & (1 << 27)) != 0;
+    const bool hasAVX = (info[2] & (1 << 28)) != 0;
+
+    if (!hasSSE2)
+    {
+        return SimdLevel::Scalar;
+    }
+
+    if (!hasOSXSave || !hasAVX || maxLeaf < 7)
+    {
+        return SimdLevel::SSE2;
+    }
+
+    // OS has to save YMM (bits 1-2) and for AVX-512 also opmask/ZMM state (bits 5-7)
+    const unsigned long long xcr0 = _xgetbv(0);
+    const bool osSavesYMM = (xcr0 & 0x6) == 0x6;
+    const bool osSavesZMM = (xcr0 & 0xE6) == 0xE6;
+
+    __cpuidex(info, 7, 0);
+    const bool hasAVX2 = (info[1] & (1 << 5)) != 0;
+    const bool hasAVX512F = (info[1] & (1 << 16)) != 0;
+
+    if (hasAVX512F && osSavesZMM)
+    {
+        return SimdLevel::AVX512;
+    }
+    if (hasAVX2 && osSavesYMM)
+    {
+        return SimdLevel::AVX2;
+    }
+    return SimdLevel::SSE2;
+}
+
+[[nodiscard]] inline SimdLevel GetDetectedSimdLevel() noexcept
+{
+    static const SimdLevel detected = DetectSimdLevel();
+    return detected;
+}
+
+inline std::atomic<SimdLevel>& SimdLevelOverrideStorage() noexcept
+{
+    static std::atomic<SimdLevel> level{ SimdLevel::AVX512 };
+    return level;
+}
+
+// Useful for tests and benchmarks: limits dispatch by the requested level (can't go higher than CPU supports)
+inline void SetSimdLevelLimit(const SimdLevel level) noexcept
+{
+    SimdLevelOverrideStorage().store(level, std::memory_order_relaxed);
+}
+
+[[nodiscard]] inline SimdLevel GetActiveSimdLevel() noexcept
+{
+    const SimdLevel limit = SimdLevelOverrideStorage().load(std::memory_order_relaxed);
+    const SimdLevel detected = GetDetectedSimdLevel();
+    return limit < detected ? limit : detected;
+}
+
+
+////////////////// OPS //////////////////////////////
+// Every Ops type provides the same set of primitives over its native vector, so kernels are written once.
+// Masks are returned as plain bit masks with one bit per lane.
+
+template <typename T>
+struct ScalarOps
+{
+    using Vec = T;
+    using Acc = SumType<T>;
+    static constexpr size_t Lanes = 1;
+
+    static Vec Load(const T* p) noexcept { return *p; }
+    static Vec Set1(const T value) noexcept { return value; }
+    static uint64_t Eq(Vec a, Vec b) noexcept { return a == b; }
+    static uint64_t Lt(Vec a, Vec b) noexcept { return a < b; }
+    static uint64_t Le(Vec a, Vec b) noexcept { return a <= b; }
+    static uint64_t Gt(Vec a, Vec b) noexcept { return a > b; }
+    static uint64_t Ge(Vec a, Vec b) noexcept { return a >= b; }
+    static Vec Min(Vec a, Vec b) noexcept { return b < a ? b : a; }
+    static Vec Max(Vec a, Vec b) noexcept { return a < b ? b : a; }
+    static T ReduceMin(Vec v) noexcept { return v; }
+    static T ReduceMax(Vec v) noexcept { return v; }
+    static Acc AccZero() noexcept { return Acc{}; }
+    static Acc AccAdd(Acc acc, Vec v) noexcept { return acc + static_cast<Acc>(v); }
+    static Acc AccReduce(Acc acc) noexcept { return acc; }
+};
+
+template <typename T> struct SSE2Ops;
+template <typename T> struct AVX2Ops;
+template <typename T> struct AVX512Ops;
+
+template <typename T>
+constexpr bool HasSimdOps = std::is_same_v<T, int32_t> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+template <typename T, size_t N, typename Vec, typename Store>
+[[nodiscard]] inline T ReduceLanes(Vec v, Store store, const bool takeMin) noexcept
+{
+    alignas(64) T lanes[N];
+    store(lanes, v);
+    T result = lanes[0];
+    for (size_t i = 1; i < N; i++)
+    {
+        result = takeMin ? (lanes[i] < result ? lanes[i] : result) : (result < lanes[i] ? lanes[i] : result);
+    }
+    return result;
+}
+
+///// SSE2 /////
+template <>
+struct SSE2Ops<int32_t>
+{
+    using T = int32_t;
+    using Vec = __m128i;
+    using Acc = __m128i;   // 2 x int64
+    static constexpr size_t Lanes = 4;
+
+    static Vec Load(const T* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void Store(T* p, Vec v) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static Vec Set1(const T value) noexcept { return _mm_set1_epi32(value); }
+    static uint64_t ToMask(Vec m) noexcept { return static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(m))); }
+    static uint64_t Eq(Vec a, Vec b) noexcept { return ToMask(_mm_cmpeq_epi32(a, b)); }
+    static uint64_t Lt(Vec a, Vec b) noexcept { return ToMask(_mm_cmplt_epi32(a, b)); }
+    static uint64_t Le(Vec a, Vec b) noexcept { return ~Gt(a, b) & 0xF; }
+    static uint64_t Gt(Vec a, Vec b) noexcept { return ToMask(_mm_cmpgt_epi32(a, b)); }
+    static uint64_t Ge(Vec a, Vec b) noexcept { return ~Lt(a, b) & 0xF; }
+    // SSE2 has no pminsd/pmaxsd (SSE4.1), so blend manually
+    static Vec Min(Vec a, Vec b) noexcept
+    {
+        const __m128i greater = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+    }
+    static Vec Max(Vec a, Vec b) noexcept
+    {
+        const __m128i greater = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+    }
+    static T ReduceMin(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, true); }
+    static T ReduceMax(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, false); }
+    static Acc AccZero() noexcept { return _mm_setzero_si128(); }
+    static Acc AccAdd(Acc acc, Vec v) noexcept
+    {
+        const __m128i sign = _mm_srai_epi32(v, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+        return _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+    }
+    static int64_t AccReduce(Acc acc) noexcept
+    {
+        alignas(16) int64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        return lanes[0] + lanes[1];
+    }
+};
+
+template <>
+struct SSE2Ops<float>
+{
+    using T = float;
+    using Vec = __m128;
+    using Acc = __m128d;
+    static constexpr size_t Lanes = 4;
+
+    static Vec Load(const T* p) noexcept { return _mm_loadu_ps(p); }
+    static void Store(T* p, Vec v) noexcept { _mm_storeu_ps(p, v); }
+    static Vec Set1(const T value) noexcept { return _mm_set1_ps(value); }
+    static uint64_t Eq(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm_movemask_ps(_mm_cmpeq_ps(a, b))); }
+    static uint64_t Lt(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm_movemask_ps(_mm_cmplt_ps(a, b))); }
+    static uint64_t Le(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm_movemask_ps(_mm_cmple_ps(a, b))); }
+    static uint64_t Gt(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm_movemask_ps(_mm_cmpgt_ps(a, b))); }
+    static uint64_t Ge(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm_movemask_ps(_mm_cmpge_ps(a, b))); }
+    static Vec Min(Vec a, Vec b) noexcept { return _mm_min_ps(a, b); }
+    static Vec Max(Vec a, Vec b) noexcept { return _mm_max_ps(a, b); }
+    static T ReduceMin(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, true); }
+    static T ReduceMax(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, false); }
+    static Acc AccZero() noexcept { return _mm_setzero_pd(); }
+    static Acc AccAdd(Acc acc, Vec v) noexcept
+    {
+        acc = _mm_add_pd(acc, _mm_cvtps_pd(v));
+        return _mm_add_pd(acc, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    static double AccReduce(Acc acc) noexcept
+    {
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, acc);
+        return lanes[0] + lanes[1];
+    }
+};
+
+template <>
+struct SSE2Ops<double>
+{
+    using T = double;
+    using Vec = __m128d;
+    using Acc = __m128d;
+    static constexpr size_t Lanes = 2;
+
+    static Vec Load(const T* p) noexcept { return _mm_loadu_pd(p); }
+    static void Store(T* p, Vec v) noexcept { _mm_storeu_pd(p, v); }
+    static Vec Set1(const T value) noexcept { return _mm_set1_pd(value); }
+    static uint64_t Eq(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm_movemask_pd(_mm_cmpeq_pd(a, b))); }
+    static uint64_t Lt(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm_movemask_pd(_mm_cmplt_pd(a, b))); }
+    static uint64_t Le(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm_movemask_pd(_mm_cmple_pd(a, b))); }
+    static uint64_t Gt(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm_movemask_pd(_mm_cmpgt_pd(a, b))); }
+    static uint64_t Ge(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm_movemask_pd(_mm_cmpge_pd(a, b))); }
+    static Vec Min(Vec a, Vec b) noexcept { return _mm_min_pd(a, b); }
+    static Vec Max(Vec a, Vec b) noexcept { return _mm_max_pd(a, b); }
+    static T ReduceMin(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, true); }
+    static T ReduceMax(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, false); }
+    static Acc AccZero() noexcept { return _mm_setzero_pd(); }
+    static Acc AccAdd(Acc acc, Vec v) noexcept { return _mm_add_pd(acc, v); }
+    static double AccReduce(Acc acc) noexcept
+    {
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, acc);
+        return lanes[0] + lanes[1];
+    }
+};
+
+///// AVX2 /////
+template <>
+struct AVX2Ops<int32_t>
+{
+    using T = int32_t;
+    using Vec = __m256i;
+    using Acc = __m256i;   // 4 x int64
+    static constexpr size_t Lanes = 8;
+
+    static Vec Load(const T* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void Store(T* p, Vec v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static Vec Set1(const T value) noexcept { return _mm256_set1_epi32(value); }
+    static uint64_t ToMask(Vec m) noexcept { return static_cast<uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(m))); }
+    static uint64_t Eq(Vec a, Vec b) noexcept { return ToMask(_mm256_cmpeq_epi32(a, b)); }
+    static uint64_t Lt(Vec a, Vec b) noexcept { return ToMask(_mm256_cmpgt_epi32(b, a)); }
+    static uint64_t Le(Vec a, Vec b) noexcept { return ~Gt(a, b) & 0xFF; }
+    static uint64_t Gt(Vec a, Vec b) noexcept { return ToMask(_mm256_cmpgt_epi32(a, b)); }
+    static uint64_t Ge(Vec a, Vec b) noexcept { return ~Lt(a, b) & 0xFF; }
+    static Vec Min(Vec a, Vec b) noexcept { return _mm256_min_epi32(a, b); }
+    static Vec Max(Vec a, Vec b) noexcept { return _mm256_max_epi32(a, b); }
+    static T ReduceMin(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, true); }
+    static T ReduceMax(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, false); }
+    static Acc AccZero() noexcept { return _mm256_setzero_si256(); }
+    static Acc AccAdd(Acc acc, Vec v) noexcept
+    {
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        return _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    static int64_t AccReduce(Acc acc) noexcept
+    {
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    static constexpr size_t GatherLanes = 4;
+    static void GatherStep(const T* base, const size_t* indices, T* out) noexcept
+    {
+        const __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_i64gather_epi32(reinterpret_cast<const int*>(base), offsets, sizeof(T)));
+    }
+};
+
+template <>
+struct AVX2Ops<float>
+{
+    using T = float;
+    using Vec = __m256;
+    using Acc = __m256d;
+    static constexpr size_t Lanes = 8;
+
+    static Vec Load(const T* p) noexcept { return _mm256_loadu_ps(p); }
+    static void Store(T* p, Vec v) noexcept { _mm256_storeu_ps(p, v); }
+    static Vec Set1(const T value) noexcept { return _mm256_set1_ps(value); }
+    static uint64_t Eq(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ))); }
+    static uint64_t Lt(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ))); }
+    static uint64_t Le(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ))); }
+    static uint64_t Gt(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ))); }
+    static uint64_t Ge(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GE_OQ))); }
+    static Vec Min(Vec a, Vec b) noexcept { return _mm256_min_ps(a, b); }
+    static Vec Max(Vec a, Vec b) noexcept { return _mm256_max_ps(a, b); }
+    static T ReduceMin(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, true); }
+    static T ReduceMax(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, false); }
+    static Acc AccZero() noexcept { return _mm256_setzero_pd(); }
+    static Acc AccAdd(Acc acc, Vec v) noexcept
+    {
+        acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        return _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+    static double AccReduce(Acc acc) noexcept
+    {
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, acc);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    static constexpr size_t GatherLanes = 4;
+    static void GatherStep(const T* base, const size_t* indices, T* out) noexcept
+    {
+        const __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices));
+        _mm_storeu_ps(out, _mm256_i64gather_ps(base, offsets, sizeof(T)));
+    }
+};
+
+template <>
+struct AVX2Ops<double>
+{
+    using T = double;
+    using Vec = __m256d;
+    using Acc = __m256d;
+    static constexpr size_t Lanes = 4;
+
+    static Vec Load(const T* p) noexcept { return _mm256_loadu_pd(p); }
+    static void Store(T* p, Vec v) noexcept { _mm256_storeu_pd(p, v); }
+    static Vec Set1(const T value) noexcept { return _mm256_set1_pd(value); }
+    static uint64_t Eq(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ))); }
+    static uint64_t Lt(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LT_OQ))); }
+    static uint64_t Le(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LE_OQ))); }
+    static uint64_t Gt(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ))); }
+    static uint64_t Ge(Vec a, Vec b) noexcept { return static_cast<uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GE_OQ))); }
+    static Vec Min(Vec a, Vec b) noexcept { return _mm256_min_pd(a, b); }
+    static Vec Max(Vec a, Vec b) noexcept { return _mm256_max_pd(a, b); }
+    static T ReduceMin(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, true); }
+    static T ReduceMax(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, false); }
+    static Acc AccZero() noexcept { return _mm256_setzero_pd(); }
+    static Acc AccAdd(Acc acc, Vec v) noexcept { return _mm256_add_pd(acc, v); }
+    static double AccReduce(Acc acc) noexcept
+    {
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, acc);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    static constexpr size_t GatherLanes = 4;
+    static void GatherStep(const T* base, const size_t* indices, T* out) noexcept
+    {
+        const __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices));
+        _mm256_storeu_pd(out, _mm256_i64gather_pd(base, offsets, sizeof(T)));
+    }
+};
+
+///// AVX-512 (F subset only) /////
+template <>
+struct AVX512Ops<int32_t>
+{
+    using T = int32_t;
+    using Vec = __m512i;
+    using Acc = __m512i;   // 8 x int64
+    static constexpr size_t Lanes = 16;
+
+    static Vec Load(const T* p) noexcept { return _mm512_loadu_si512(p); }
+    static void Store(T* p, Vec v) noexcept { _mm512_storeu_si512(p, v); }
+    static Vec Set1(const T value) noexcept { return _mm512_set1_epi32(value); }
+    static uint64_t Eq(Vec a, Vec b) noexcept { return _mm512_cmpeq_epi32_mask(a, b); }
+    static uint64_t Lt(Vec a, Vec b) noexcept { return _mm512_cmplt_epi32_mask(a, b); }
+    static uint64_t Le(Vec a, Vec b) noexcept { return _mm512_cmple_epi32_mask(a, b); }
+    static uint64_t Gt(Vec a, Vec b) noexcept { return _mm512_cmpgt_epi32_mask(a, b); }
+    static uint64_t Ge(Vec a, Vec b) noexcept { return _mm512_cmpge_epi32_mask(a, b); }
+    static Vec Min(Vec a, Vec b) noexcept { return _mm512_min_epi32(a, b); }
+    static Vec Max(Vec a, Vec b) noexcept { return _mm512_max_epi32(a, b); }
+    static T ReduceMin(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, true); }
+    static T ReduceMax(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, false); }
+    static Acc AccZero() noexcept { return _mm512_setzero_si512(); }
+    static Acc AccAdd(Acc acc, Vec v) noexcept
+    {
+        acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        return _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+    static int64_t AccReduce(Acc acc) noexcept
+    {
+        alignas(64) int64_t lanes[8];
+        _mm512_store_si512(lanes, acc);
+        int64_t result = 0;
+        for (const int64_t lane : lanes)
+        {
+            result += lane;
+        }
+        return result;
+    }
+
+    static constexpr size_t GatherLanes = 8;
+    static void GatherStep(const T* base, const size_t* indices, T* out) noexcept
+    {
+        const __m512i offsets = _mm512_loadu_si512(indices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm512_i64gather_epi32(offsets, base, sizeof(T)));
+    }
+};
+
+template <>
+struct AVX512Ops<float>
+{
+    using T = float;
+    using Vec = __m512;
+    using Acc = __m512d;
+    static constexpr size_t Lanes = 16;
+
+    static Vec Load(const T* p) noexcept { return _mm512_loadu_ps(p); }
+    static void Store(T* p, Vec v) noexcept { _mm512_storeu_ps(p, v); }
+    static Vec Set1(const T value) noexcept { return _mm512_set1_ps(value); }
+    static uint64_t Eq(Vec a, Vec b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    static uint64_t Lt(Vec a, Vec b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static uint64_t Le(Vec a, Vec b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+    static uint64_t Gt(Vec a, Vec b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static uint64_t Ge(Vec a, Vec b) noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+    static Vec Min(Vec a, Vec b) noexcept { return _mm512_min_ps(a, b); }
+    static Vec Max(Vec a, Vec b) noexcept { return _mm512_max_ps(a, b); }
+    static T ReduceMin(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, true); }
+    static T ReduceMax(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, false); }
+    static Acc AccZero() noexcept { return _mm512_setzero_pd(); }
+    static Acc AccAdd(Acc acc, Vec v) noexcept
+    {
+        const __m512d bits = _mm512_castps_pd(v);
+        acc = _mm512_add_pd(acc, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_castpd512_pd256(bits))));
+        return _mm512_add_pd(acc, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(bits, 1))));
+    }
+    static double AccReduce(Acc acc) noexcept
+    {
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, acc);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+    static constexpr size_t GatherLanes = 8;
+    static void GatherStep(const T* base, const size_t* indices, T* out) noexcept
+    {
+        const __m512i offsets = _mm512_loadu_si512(indices);
+        _mm256_storeu_ps(out, _mm512_i64gather_ps(offsets, base, sizeof(T)));
+    }
+};
+
+template <>
+struct AVX512Ops<double>
+{
+    using T = double;
+    using Vec = __m512d;
+    using Acc = __m512d;
+    static constexpr size_t Lanes = 8;
+
+    static Vec Load(const T* p) noexcept { return _mm512_loadu_pd(p); }
+    static void Store(T* p, Vec v) noexcept { _mm512_storeu_pd(p, v); }
+    static Vec Set1(const T value) noexcept { return _mm512_set1_pd(value); }
+    static uint64_t Eq(Vec a, Vec b) noexcept { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+    static uint64_t Lt(Vec a, Vec b) noexcept { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    static uint64_t Le(Vec a, Vec b) noexcept { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+    static uint64_t Gt(Vec a, Vec b) noexcept { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+    static uint64_t Ge(Vec a, Vec b) noexcept { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+    static Vec Min(Vec a, Vec b) noexcept { return _mm512_min_pd(a, b); }
+    static Vec Max(Vec a, Vec b) noexcept { return _mm512_max_pd(a, b); }
+    static T ReduceMin(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, true); }
+    static T ReduceMax(Vec v) noexcept { return ReduceLanes<T, Lanes>(v, Store, false); }
+    static Acc AccZero() noexcept { return _mm512_setzero_pd(); }
+    static Acc AccAdd(Acc acc, Vec v) noexcept { return _mm512_add_pd(acc, v); }
+    static double AccReduce(Acc acc) noexcept
+    {
+        alignas(64) double lanes[8];
+        _mm512_store_pd(lanes, acc);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+    static constexpr size_t GatherLanes = 8;
+    static void GatherStep(const T* base, const size_t* indices, T* out) noexcept
+    {
+        const __m512i offsets = _mm512_loadu_si512(indices);
+        _mm512_storeu_pd(out, _mm512_i64gather_pd(offsets, base, sizeof(T)));
+    }
+};
+
+
+////////////////// KERNELS //////////////////////////////
+// Main loops go over full vectors, the ragged tail (less than one vector) is handled with ScalarOps.
+
+template <typename Ops, typename T>
+[[nodiscard]] uint64_t CompareMask(const CompareOp op, typename Ops::Vec a, typename Ops::Vec b) noexcept
+{
+    constexpr uint64_t fullMask = Ops::Lanes == 64 ? ~0ull : ((1ull << Ops::Lanes) - 1);
+    switch (op)
+    {
+    case CompareOp::Equal:          return Ops::Eq(a, b);
+    case CompareOp::NotEqual:       return ~Ops::Eq(a, b) & fullMask;
+    case CompareOp::Less:           return Ops::Lt(a, b);
+    case CompareOp::LessEqual:      return Ops::Le(a, b);
+    case CompareOp::Greater:        return Ops::Gt(a, b);
+    case CompareOp::GreaterEqual:   return Ops::Ge(a, b);
+    }
+    return 0;
+}
+
+template <typename Ops, typename T>
+[[nodiscard]] size_t FindIndexImpl(const T* data, const size_t count, const T value) noexcept
+{
+    constexpr size_t Step = Ops::Lanes * 4;
+    const auto needle = Ops::Set1(value);
+
+    size_t i = 0;
+    for (; i + Step <= count; i += Step)
+    {
+        const uint64_t m0 = Ops::Eq(Ops::Load(data + i), needle);
+        const uint64_t m1 = Ops::Eq(Ops::Load(data + i + Ops::Lanes), needle);
+        const uint64_t m2 = Ops::Eq(Ops::Load(data + i + Ops::Lanes * 2), needle);
+        const uint64_t m3 = Ops::Eq(Ops::Load(data + i + Ops::Lanes * 3), needle);
+        if ((m0 | m1 | m2 | m3) != 0) [[unlikely]]
+        {
+            const uint64_t masks[4] = { m0, m1, m2, m3 };
+            for (size_t block = 0; block < 4; block++)
+            {
+                if (masks[block] != 0)
+                {
+                    return i + block * Ops::Lanes + std::countr_zero(masks[block]);
+                }
+            }
+        }
+    }
+
+    for (; i + Ops::Lanes <= count; i += Ops::Lanes)
+    {
+        const uint64_t mask = Ops::Eq(Ops::Load(data + i), needle);
+        if (mask != 0)
+        {
+            return i + std::countr_zero(mask);
+        }
+    }
+
+    for (; i < count; ++i)
+    {
+        if (data[i] == value)
+        {
+            return i;
+        }
+    }
+
+    return count;
+}
+
+template <typename Ops, typename T>
+[[nodiscard]] size_t CountImpl(const T* data, const size_t count, const T value) noexcept
+{
+    const auto needle = Ops::Set1(value);
+
+    size_t result = 0;
+    size_t i = 0;
+    for (; i + Ops::Lanes <= count; i += Ops::Lanes)
+    {
+        result += std::popcount(Ops::Eq(Ops::Load(data + i), needle));
+    }
+
+    for (; i < count; ++i)
+    {
+        result += data[i] == value ? 1 : 0;
+    }
+
+    return result;
+}
+
+template <typename Ops, typename T>
+[[nodiscard]] std::pair<T, T> MinMaxImpl(const T* data, const size_t count) noexcept
+{
+    assert(count != 0);
+
+    size_t i = 0;
+    T minValue = data[0];
+    T maxValue = data[0];
+    if (count >= Ops::Lanes * 2)
+    {
+        auto min0 = Ops::Load(data);
+        auto max0 = min0;
+        auto min1 = Ops::Load(data + Ops::Lanes);
+        auto max1 = min1;
+        for (i = Ops::Lanes * 2; i + Ops::Lanes * 2 <= count; i += Ops::Lanes * 2)
+        {
+            const auto v0 = Ops::Load(data + i);
+            const auto v1 = Ops::Load(data + i + Ops::Lanes);
+            min0 = Ops::Min(min0, v0);
+            max0 = Ops::Max(max0, v0);
+            min1 = Ops::Min(min1, v1);
+            max1 = Ops::Max(max1, v1);
+        }
+        minValue = Ops::ReduceMin(Ops::Min(min0, min1));
+        maxValue = Ops::ReduceMax(Ops::Max(max0, max1));
+    }
+
+    for (; i < count; ++i)
+    {
+        minValue = data[i] < minValue ? data[i] : minValue;
+        maxValue = maxValue < data[i] ? data[i] : maxValue;
+    }
+
+    return { minValue, maxValue };
+}
+
+template <typename Ops, typename T>
+[[nodiscard]] SumType<T> SumImpl(const T* data, const size_t count) noexcept
+{
+    // two independent accumulators to hide add latency (mostly for floating point)
+    auto acc0 = Ops::AccZero();
+    auto acc1 = Ops::AccZero();
+
+    size_t i = 0;
+    for (; i + Ops::Lanes * 2 <= count; i += Ops::Lanes * 2)
+    {
+        acc0 = Ops::AccAdd(acc0, Ops::Load(data + i));
+        acc1 = Ops::AccAdd(acc1, Ops::Load(data + i + Ops::Lanes));
+    }
+
+    SumType<T> result = Ops::AccReduce(acc0) + Ops::AccReduce(acc1);
+    for (; i < count; ++i)
+    {
+        result += static_cast<SumType<T>>(data[i]);
+    }
+
+    return result;
+}
+
+template <typename Ops, typename T>
+void GatherImpl(const T* data, const size_t* indices, const size_t indexCount, T* out) noexcept
+{
+    size_t i = 0;
+    if constexpr (requires { Ops::GatherLanes; })
+    {
+        for (; i + Ops::GatherLanes <= indexCount; i += Ops::GatherLanes)
+        {
+            Ops::GatherStep(data, indices + i, out + i);
+        }
+    }
+
+    for (; i < indexCount; ++i)
+    {
+        out[i] = data[indices[i]];
+    }
+}
+
+// Writes indices of matching elements into out (which must fit count elements), returns amount of written indices
+template <typename Ops, typename T>
+[[nodiscard]] size_t FilterIndicesImpl(const T* data, const size_t count, const CompareOp op, const T threshold, size_t* out) noexcept
+{
+    const auto pivot = Ops::Set1(threshold);
+
+    size_t written = 0;
+    size_t i = 0;
+    for (; i + Ops::Lanes <= count; i += Ops::Lanes)
+    {
+        uint64_t mask = CompareMask<Ops, T>(op, Ops::Load(data + i), pivot);
+        while (mask != 0)
+        {
+            out[written++] = i + std::countr_zero(mask);
+            mask &= mask - 1;
+        }
+    }
+
+    for (; i < count; ++i)
+    {
+        if (CompareMask<ScalarOps<T>, T>(op, data[i], threshold) != 0)
+        {
+            out[written++] = i;
+        }
+    }
+
+    return written;
+}
+
+template <typename Ops>
+struct OpsTag
+{
+    using Type = Ops;
+};
+
+template <typename T, typename Func>
+decltype(auto) DispatchBySimdLevel(Func&& func)
+{
+    static_assert(std::is_arithmetic_v<T>, "SIMD kernels are implemented for arithmetic types only");
+
+    if constexpr (HasSimdOps<T>)
+    {
+        switch (GetActiveSimdLevel())
+        {
+        case SimdLevel::AVX512: return func(OpsTag<AVX512Ops<T>>{});
+        case SimdLevel::AVX2:   return func(OpsTag<AVX2Ops<T>>{});
+        case SimdLevel::SSE2:   return func(OpsTag<SSE2Ops<T>>{});
+        case SimdLevel::Scalar: break;
+        }
+    }
+
+    return func(OpsTag<ScalarOps<T>>{});
+}
+
+////////////////// RAW RANGE API //////////////////////////////
+
+// Returns index of the first element equal to value or count if nothing found
+template <typename T>
+[[nodiscard]] size_t FindIndex(const T* data, const size_t count, const T value)
+{
+    return DispatchBySimdLevel<T>([&](auto tag) { return FindIndexImpl<typename decltype(tag)::Type>(data, count, value); });
+}
+
+template <typename T>
+[[nodiscard]] size_t Count(const T* data, const size_t count, const T value)
+{
+    return DispatchBySimdLevel<T>([&](auto tag) { return CountImpl<typename decltype(tag)::Type>(data, count, value); });
+}
+
+template <typename T>
+[[nodiscard]] std::pair<T, T> MinMax(const T* data, const size_t count)
+{
+    if (count == 0)
+    {
+        throw std::out_of_range{ "MinMax on empty range" };
+    }
+    return DispatchBySimdLevel<T>([&](auto tag) { return MinMaxImpl<typename decltype(tag)::Type>(data, count); });
+}
+
+template <typename T>
+[[nodiscard]] SumType<T> Sum(const T* data, const size_t count)
+{
+    return DispatchBySimdLevel<T>([&](auto tag) { return SumImpl<typename decltype(tag)::Type>(data, count); });
+}
+
+// out[i] = data[indices[i]], indices must be valid for data
+template <typename T>
+void Gather(const T* data, const size_t* indices, const size_t indexCount, T* out)
+{
+    DispatchBySimdLevel<T>([&](auto tag) { GatherImpl<typename decltype(tag)::Type>(data, indices, indexCount, out); });
+}
+
+template <typename T>
+[[nodiscard]] size_t FilterIndices(const T* data, const size_t count, const CompareOp op, const T threshold, size_t* out)
+{
+    return DispatchBySimdLevel<T>([&](auto tag) { return FilterIndicesImpl<typename decltype(tag)::Type>(data, count, op, threshold, out); });
+}
+
+} // namespace simd end
+
+
+////////////////// CONTAINER API //////////////////////////////
+
+template<typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+[[nodiscard]] typename GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>::const_iterator
+    Find(const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& container, const T value)
+{
+    return container.CBegin() + simd::FindIndex(container.GetData(), container.GetSize(), value);
+}
+
+template<typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+[[nodiscard]] size_t Count(const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& container, const T value)
+{
+    return simd::Count(container.GetData(), container.GetSize(), value);
+}
+
+template<typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+[[nodiscard]] bool Contains(const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& container, const T value)
+{
+    return simd::FindIndex(container.GetData(), container.GetSize(), value) != container.GetSize();
+}
+
+// Note: throws std::out_of_range on empty container
+template<typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+[[nodiscard]] std::pair<T, T> MinMax(const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& container)
+{
+    return simd::MinMax(container.GetData(), container.GetSize());
+}
+
+template<typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+[[nodiscard]] simd::SumType<T> Sum(const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& container)
+{
+    return simd::Sum(container.GetData(), container.GetSize());
+}
+
+// Appends container[indices[i]] for every index to out
+template<typename T, typename ReservePolicy, bool CommitPagesWithReserve, typename IndexReservePolicy, bool IndexCommitPagesWithReserve, typename OutReservePolicy, bool OutCommitPagesWithReserve>
+void Gather(
+    const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& container,
+    const GrowingVectorVM<size_t, IndexReservePolicy, IndexCommitPagesWithReserve>& indices,
+    GrowingVectorVM<T, OutReservePolicy, OutCommitPagesWithReserve>& out)
+{
+    const size_t offset = out.GetSize();
+    out.Resize(offset + indices.GetSize(), T{});
+    if (!indices.Empty())
+    {
+        simd::Gather(container.GetData(), indices.GetData(), indices.GetSize(), out.GetData() + offset);
+    }
+}
+
+// Appends indices of elements which satisfy (element op threshold) to out
+template<typename T, typename ReservePolicy, bool CommitPagesWithReserve, typename OutReservePolicy, bool OutCommitPagesWithReserve>
+void FilterIndices(
+    const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& container,
+    const simd::CompareOp op,
+    const T threshold,
+    GrowingVectorVM<size_t, OutReservePolicy, OutCommitPagesWithReserve>& out)
+{
+    // Process by chunks through a small stack buffer to not reserve the worst case in the output
+    constexpr size_t ChunkSize = 1024;
+    size_t buffer[ChunkSize];
+
+    const T* data = container.GetData();
+    for (size_t chunkBegin = 0; chunkBegin < container.GetSize(); chunkBegin += ChunkSize)
+    {
+        const size_t chunkSize = std::min(ChunkSize, container.GetSize() - chunkBegin);
+        const size_t found = simd::FilterIndices(data + chunkBegin, chunkSize, op, threshold, buffer);
+        for (size_t i = 0; i < found; i++)
+        {
+            out.PushBack(chunkBegin + buffer[i]);
+        }
+    }
+}
+
+} // namespace ds end
@@ -0,0 +1,324 @@
+#pragma once
+
+// Registry of GrowingVectorVM instances to give memory back under memory pressure.
+// TrimAll(targetBytes) decommits committed-but-unused tails (slack, see ShrinkToFit()) of registered vectors, the
+// largest slack first, until targetBytes are given back. MemoryPressureWatcher signals when the system runs low on
+// physical memory, so the commit-ahead of growing vectors can be given back before the machine starts paging (or the
+// job goes over its limit).
+//
+// Vectors are registered only with DS_ENABLE_VECTOR_REGISTRY=1 (CMake option ENABLE_VECTOR_REGISTRY) and only when
+// the caller marks them with SetTrimmable(true), then marking, destruction, move and swap of them take a mutex.
+// Vectors used internally by the library (snapshots, trackers, spillers, rank caches) are never registered, they may
+// be used by other threads or under own locks.
+//
+// TrimAll() modifies vectors: registered vectors must not be used by other threads while it runs, the same as
+// for any other non-const call. Call it on the thread owning the vectors, at a point where none of them is in the
+// middle of an operation. The watcher runs its handler on its own thread, so the handler should only pass the request
+// on (set a flag, signal an event, post a task) to the owning thread.
+//
+// Usage:
+//    std::atomic<size_t> g_trimRequest = 0;
+//    cache.SetTrimmable(true);
+//    ds::MemoryPressureWatcher::GetInstance().Start(DS_MB(512), [](size_t bytes) noexcept { g_trimRequest = bytes; });
+//    ...
+//    if (const size_t bytes = g_trimRequest.exchange(0); bytes > 0)   // on the owning thread
+//    {
+//        ds::TrimAll(bytes);
+//    }
+//
+// Note: it doesn't include GrowingVectorVM.h, GrowingVectorVM.h includes it when the registry is enabled.
+
+#ifdef WIN32
+#include <windows.h>
+#include <memoryapi.h>                  // for CreateMemoryResourceNotification
+#else
+#error Unsupported
+#endif
+
+#include <stdint.h>
+#include <algorithm>                    // for std::sort
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+namespace ds
+{
+
+namespace detail
+{
+
+template <typename Vector>
+size_t GetSlackBytesOf(const void* vector) noexcept
+{
+    return static_cast<const Vector*>(vector)->GetSlackBytes();
+}
+
+template <typename Vector>
+size_t ShrinkToFitOf(void* vector) noexcept
+{
+    return static_cast<Vector*>(vector)->ShrinkToFit();
+}
+
+class VectorRegistry
+{
+public:
+    using GetSlackBytesFunction = size_t (*)(const void* vector) noexcept;
+    using ShrinkToFitFunction = size_t (*)(void* vector) noexcept;
+
+    [[nodiscard]] static VectorRegistry& GetInstance()
+    {
+        static VectorRegistry registry;
+        return registry;
+    }
+
+    // A vector which can't be registered (out of memory) just isn't trimmed
+    void Register(void* vector, const GetSlackBytesFunction getSlackBytes, const ShrinkToFitFunction shrinkToFit) noexcept
+    {
+        std::lock_guard lock(m_mutex);
+        try
+        {
+            m_vectors[vector] = { getSlackBytes, shrinkToFit };
+        }
+        catch (const std::bad_alloc&)
+        {
+        }
+    }
+
+    void Unregister(void* vector) noexcept
+    {
+        std::lock_guard lock(m_mutex);
+        m_vectors.erase(vector);
+    }
+
+    size_t TrimAll(const size_t targetBytes) noexcept
+    {
+        std::lock_guard lock(m_mutex);
+        try
+        {
+            m_candidates.clear();
+            m_candidates.reserve(m_vectors.size());
+        }
+        catch (const std::bad_alloc&)
+        {
+            return TrimInAnyOrder(targetBytes); // no memory to sort, trim what comes first
+        }
+
+        for (const auto& [vector, functions] : m_vectors)
+        {
+            const size_t slackBytes = functions.getSlackBytes(vector);
+            if (slackBytes > 0)
+            {
+                m_candidates.push_back({ slackBytes, vector, functions.shrinkToFit });
+            }
+        }
+        std::sort(m_candidates.begin(), m_candidates.end(), [](const Candidate& left, const Candidate& right)
+        {
+            return left.slackBytes > right.slackBytes;
+        });
+
+        size_t freedBytes = 0;
+        for (const Candidate& candidate : m_candidates)
+        {
+            if (freedBytes >= targetBytes)
+            {
+                break;
+            }
+            freedBytes += candidate.shrinkToFit(candidate.vector);
+        }
+        return freedBytes;
+    }
+
+    [[nodiscard]] size_t GetVectorCount() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_vectors.size();
+    }
+
+    [[nodiscard]] size_t GetSlackBytes() const
+    {
+        std::lock_guard lock(m_mutex);
+        size_t slackBytes = 0;
+        for (const auto& [vector, functions] : m_vectors)
+        {
+            slackBytes += functions.getSlackBytes(vector);
+        }
+        return slackBytes;
+    }
+
+private:
+    struct Functions
+    {
+        GetSlackBytesFunction getSlackBytes;
+        ShrinkToFitFunction shrinkToFit;
+    };
+
+    struct Candidate
+    {
+        size_t slackBytes;
+        void* vector;
+        ShrinkToFitFunction shrinkToFit;
+    };
+
+    VectorRegistry() = default;
+    VectorRegistry(const VectorRegistry&) = delete;
+    VectorRegistry& operator=(const VectorRegistry&) = delete;
+
+    size_t TrimInAnyOrder(const size_t targetBytes) noexcept
+    {
+        size_t freedBytes = 0;
+        for (auto it = m_vectors.begin(); it != m_vectors.end() && freedBytes < targetBytes; ++it)
+        {
+            freedBytes += it->second.shrinkToFit(it->first);
+        }
+        return freedBytes;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<void*, Functions> m_vectors;
+    std::vector<Candidate> m_candidates;    // kept to not allocate under memory pressure
+};
+
+} // namespace detail end
+
+
+// Decommits slack of registered vectors, the largest first, until at least targetBytes are decommitted.
+// Returns decommitted bytes (less than targetBytes if there is not enough slack).
+inline size_t TrimAll(const size_t targetBytes = SIZE_MAX) noexcept
+{
+    return detail::VectorRegistry::GetInstance().TrimAll(targetBytes);
+}
+
+// Slack of all registered vectors, what TrimAll() can give back at most
+[[nodiscard]] inline size_t GetTotalSlackBytes()
+{
+    return detail::VectorRegistry::GetInstance().GetSlackBytes();
+}
+
+
+// Called on the watcher thread on memory pressure, must not touch vectors (see above)
+using MemoryPressureHandler = void (*)(size_t targetBytes) noexcept;
+
+// Background thread which calls the handler when the notification is signaled.
+// Without an explicit notification it watches the system low memory notification (CreateMemoryResourceNotification),
+// which stays signaled while the memory is low, so the handler is called every cooldown until it's not.
+class MemoryPressureWatcher
+{
+public:
+    [[nodiscard]] static MemoryPressureWatcher& GetInstance()
+    {
+        static MemoryPressureWatcher watcher;
+        return watcher;
+    }
+
+    // notification: any waitable handle (e.g. an event signaled by own monitoring), nullptr for the low memory one.
+    // The handle is not owned by the watcher and must be valid until Stop().
+    void Start(const size_t targetBytes, const MemoryPressureHandler handler, HANDLE notification = nullptr,
+        const uint32_t cooldownMs = 1000)
+    {
+        if (handler == nullptr)
+        {
+            throw std::invalid_argument{ "Memory pressure handler is required" };
+        }
+
+        std::lock_guard lock(m_mutex);
+        if (m_thread.joinable())
+        {
+            throw std::logic_error{ "Memory pressure watcher is started already" };
+        }
+
+#if WIN32
+        m_ownsNotification = notification == nullptr;
+        m_notification = m_ownsNotification ? CreateMemoryResourceNotification(LowMemoryResourceNotification) : notification;
+        m_stop = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+#else
+#error Not implemented
+#endif
+        if (m_notification == nullptr || m_stop == nullptr)
+        {
+            CloseHandles();
+            throw std::runtime_error{ "Failed to create the memory pressure notification" };
+        }
+
+        m_thread = std::thread(&MemoryPressureWatcher::Run, this, targetBytes, handler, cooldownMs);
+    }
+
+    void Stop()
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_thread.joinable())
+        {
+            return;
+        }
+
+        SetEvent(m_stop);
+        m_thread.join();
+        CloseHandles();
+    }
+
+    [[nodiscard]] bool IsStarted() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_thread.joinable();
+    }
+
+    [[nodiscard]] size_t GetTriggerCount() const noexcept { return m_triggerCount.load(std::memory_order_relaxed); }
+
+private:
+    MemoryPressureWatcher() = default;
+
+    ~MemoryPressureWatcher() noexcept
+    {
+        Stop();
+    }
+
+    MemoryPressureWatcher(const MemoryPressureWatcher&) = delete;
+    MemoryPressureWatcher& operator=(const MemoryPressureWatcher&) = delete;
+
+    void Run(const size_t targetBytes, const MemoryPressureHandler handler, const uint32_t cooldownMs)
+    {
+#if WIN32
+        const HANDLE handles[] = { m_stop, m_notification };
+        while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
+        {
+            handler(targetBytes);
+            m_triggerCount.fetch_add(1, std::memory_order_relaxed);
+
+            if (WaitForSingleObject(m_stop, cooldownMs) != WAIT_TIMEOUT)
+            {
+                break;
+            }
+        }
+#else
+#error Not implemented
+#endif
+    }
+
+    void CloseHandles() noexcept
+    {
+        if (m_ownsNotification && m_notification != nullptr)
+        {
+            CloseHandle(m_notification);
+        }
+        if (m_stop != nullptr)
+        {
+            CloseHandle(m_stop);
+        }
+        m_notification = nullptr;
+        m_stop = nullptr;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::thread m_thread;
+    HANDLE m_notification = nullptr;
+    HANDLE m_stop = nullptr;
+    bool m_ownsNotification = false;
+    std::atomic<size_t> m_triggerCount = 0;
+};
+
+} // namespace ds end
@@ -0,0 +1,170 @@
+#pragma once
+
+// Residency introspection: GetCapacity() tells how much is committed (charged), but committed memory
+// isn't necessarily in RAM. QueryResidency() tells how many pages of an element range are in the working set,
+// how many of them are large pages and which committed ranges are not resident.
+//
+// Note: Windows doesn't tell apart a page which was paged out from a committed page which was never touched
+// (both are just not in the working set), so they are reported together as non-resident.
+//
+// Exact query asks the OS about every page, that's about 16 bytes of output and a page table walk per page.
+// For periodic reporting on huge vectors use SampleResidency(): it queries at most maxSamples evenly spread pages
+// and extrapolates.
+
+#include "GrowingVectorVM.h"
+
+#ifdef WIN32
+#include <psapi.h>                      // for QueryWorkingSetEx
+#else
+#error Unsupported
+#endif
+
+#include <array>
+#include <cstddef>                      // for std::byte
+
+
+namespace ds
+{
+
+struct ResidencyInfo
+{
+    size_t pageCount;                   // pages covering the range
+    size_t residentPages;               // in the working set
+    size_t largePages;                  // resident and backed by large pages
+    size_t nonResidentPages;            // committed, but paged out or never touched
+    size_t sampledPages;                // pages actually queried, equals pageCount unless sampled
+};
+
+
+namespace detail
+{
+
+// Queries pages [0, pageCount) * stride starting at begin, calls visitor(pageIndex, isResident, isLargePage) for each one
+template <typename Visitor>
+void QueryPageResidency(const std::byte* begin, const size_t pageSize, const size_t pageCount, const size_t stride, Visitor&& visitor)
+{
+#if WIN32
+    constexpr size_t BatchSize = 512;
+    std::array<PSAPI_WORKING_SET_EX_INFORMATION, BatchSize> batch;
+    for (size_t batchBegin = 0; batchBegin < pageCount; batchBegin += BatchSize)
+    {
+        const size_t batchCount = std::min(BatchSize, pageCount - batchBegin);
+        for (size_t i = 0; i < batchCount; i++)
+        {
+            batch[i].VirtualAddress = const_cast<std::byte*>(begin + (batchBegin + i) * stride * pageSize);
+        }
+        if (!QueryWorkingSetEx(GetCurrentProcess(), batch.data(), static_cast<DWORD>(batchCount * sizeof(PSAPI_WORKING_SET_EX_INFORMATION))))
+        {
+            throw std::runtime_error{ "Failed to query the working set" };
+        }
+        for (size_t i = 0; i < batchCount; i++)
+        {
+            visitor((batchBegin + i) * stride, batch[i].VirtualAttributes.Valid != 0, batch[i].VirtualAttributes.LargePage != 0);
+        }
+    }
+#else
+#error Not implemented
+#endif
+}
+
+template <typename Vector>
+[[nodiscard]] const std::byte* CalculateResidencyRange(const Vector& vec, const size_t first, const size_t last, size_t* outPageCount)
+{
+    if (first > last || last > vec.GetSize())
+    {
+        throw std::out_of_range{ "Range is out of the vector" };
+    }
+    *outPageCount = 0;
+    if (first == last)
+    {
+        return nullptr;
+    }
+
+    using value_type = typename Vector::value_type;
+    const size_t pageSize = vec.GetPageSize();
+    const std::byte* data = reinterpret_cast<const std::byte*>(vec.GetData());
+    const size_t firstPage = first * sizeof(value_type) / pageSize;
+    const size_t lastPage = (last * sizeof(value_type) + pageSize - 1) / pageSize;
+    *outPageCount = lastPage - firstPage;
+    return data + firstPage * pageSize;
+}
+
+} // namespace detail end
+
+
+// Residency of pages covering elements [first, last). onNonResidentRange(const void* begin, size_t bytes)
+// is called for every run of non-resident pages, in address order.
+template <typename Vector, typename RangeVisitor>
+[[nodiscard]] ResidencyInfo QueryResidency(const Vector& vec, const size_t first, const size_t last, RangeVisitor&& onNonResidentRange)
+{
+    ResidencyInfo info = {};
+    const std::byte* begin = detail::CalculateResidencyRange(vec, first, last, &info.pageCount);
+    const size_t pageSize = vec.GetPageSize();
+
+    size_t runBegin = 0;
+    size_t runLength = 0;
+    detail::QueryPageResidency(begin, pageSize, info.pageCount, 1, [&](const size_t page, const bool isResident, const bool isLargePage)
+    {
+        if (isResident)
+        {
+            info.residentPages++;
+            info.largePages += isLargePage ? 1 : 0;
+            if (runLength > 0)
+            {
+                onNonResidentRange(static_cast<const void*>(begin + runBegin * pageSize), runLength * pageSize);
+                runLength = 0;
+            }
+            return;
+        }
+
+        if (runLength == 0)
+        {
+            runBegin = page;
+        }
+        runLength++;
+    });
+    if (runLength > 0)
+    {
+        onNonResidentRange(static_cast<const void*>(begin + runBegin * pageSize), runLength * pageSize);
+    }
+
+    info.nonResidentPages = info.pageCount - info.residentPages;
+    info.sampledPages = info.pageCount;
+    return info;
+}
+
+template <typename Vector>
+[[nodiscard]] ResidencyInfo QueryResidency(const Vector& vec, const size_t first, const size_t last)
+{
+    return QueryResidency(vec, first, last, [](const void*, size_t) {});
+}
+
+// Queries at most maxSamples pages evenly spread over the range, counts are extrapolated to the whole range
+template <typename Vector>
+[[nodiscard]] ResidencyInfo SampleResidency(const Vector& vec, const size_t first, const size_t last, const size_t maxSamples = 4096)
+{
+    ResidencyInfo info = {};
+    const std::byte* begin = detail::CalculateResidencyRange(vec, first, last, &info.pageCount);
+    if (info.pageCount == 0 || maxSamples == 0)
+    {
+        return info;
+    }
+
+    const size_t stride = (info.pageCount + maxSamples - 1) / maxSamples;
+    info.sampledPages = (info.pageCount + stride - 1) / stride;
+
+    size_t residentSamples = 0;
+    size_t largeSamples = 0;
+    detail::QueryPageResidency(begin, vec.GetPageSize(), info.sampledPages, stride, [&](size_t, const bool isResident, const bool isLargePage)
+    {
+        residentSamples += isResident ? 1 : 0;
+        largeSamples += isResident && isLargePage ? 1 : 0;
+    });
+
+    info.residentPages = static_cast<size_t>(static_cast<double>(residentSamples) * info.pageCount / info.sampledPages + 0.5);
+    info.largePages = static_cast<size_t>(static_cast<double>(largeSamples) * info.pageCount / info.sampledPages + 0.5);
+    info.nonResidentPages = info.pageCount - info.residentPages;
+    return info;
+}
+
+} // namespace ds end
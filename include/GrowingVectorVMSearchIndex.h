@@ -0,0 +1,347 @@
+#pragma once
+
+// Static search tree (S-tree / B-tree blocked layout) over a sorted GrowingVectorVM of arithmetic type.
+// Binary search over a huge vector takes ~log2(n) cache misses, here every node is one cache line (64 bytes of keys),
+// so a lookup takes ~log_B(n) misses: for uint64_t B = 8, and 1 billion elements need 10 nodes instead of 30 probes.
+//
+// Layout: leaves are the source vector itself split into blocks of B elements (nothing is copied),
+// internal levels keep the last (max) key of every child and live in a sibling reservation, bottom level first.
+// Nodes are compared with AVX2 (count of keys less than the needle == index of the child), batched lookups
+// walk a group of needles level by level and prefetch the next nodes, so misses of different needles overlap.
+//
+// Source must stay sorted. Appending to it is fine (source data never relocates) - call Update() to extend the index
+// incrementally, any other modification requires Rebuild(). NaN values are not supported.
+
+#include "GrowingVectorVMKernels.h"
+
+#include <limits>                       // for padding keys
+#include <cstring>                      // for std::memmove
+
+
+namespace ds
+{
+
+namespace detail
+{
+
+template <typename T>
+[[nodiscard]] inline size_t NodeRankScalar(const T* node, const size_t count, const T key) noexcept
+{
+    size_t rank = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        rank += node[i] < key ? 1 : 0;
+    }
+    return rank;
+}
+
+// Count of keys less than needle in a full node of 64 bytes
+template <typename T>
+[[nodiscard]] inline size_t NodeRankAVX2(const T* node, const T key) noexcept
+{
+    if constexpr (std::is_same_v<T, float>)
+    {
+        const __m256 needle = _mm256_set1_ps(key);
+        const int low = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(node), needle, _CMP_LT_OQ));
+        const int high = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(node + 8), needle, _CMP_LT_OQ));
+        return std::popcount(static_cast<uint32_t>(low | (high << 8)));
+    }
+    else if constexpr (std::is_same_v<T, double>)
+    {
+        const __m256d needle = _mm256_set1_pd(key);
+        const int low = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(node), needle, _CMP_LT_OQ));
+        const int high = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(node + 4), needle, _CMP_LT_OQ));
+        return std::popcount(static_cast<uint32_t>(low | (high << 4)));
+    }
+    else if constexpr (sizeof(T) == 8)
+    {
+        // there is only signed 64-bit compare, so unsigned values are shifted by flipping the sign bit
+        const __m256i flip = _mm256_set1_epi64x(std::is_signed_v<T> ? 0 : std::numeric_limits<int64_t>::min());
+        const __m256i needle = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<int64_t>(key)), flip);
+        const __m256i low = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(node)), flip);
+        const __m256i high = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(node + 4)), flip);
+        const int lowMask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(needle, low)));
+        const int highMask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(needle, high)));
+        return std::popcount(static_cast<uint32_t>(lowMask | (highMask << 4)));
+    }
+    else
+    {
+        static_assert(sizeof(T) == 4);
+        const __m256i flip = _mm256_set1_epi32(std::is_signed_v<T> ? 0 : std::numeric_limits<int32_t>::min());
+        const __m256i needle = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int32_t>(key)), flip);
+        const __m256i low = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(node)), flip);
+        const __m256i high = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(node + 8)), flip);
+        const int lowMask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(needle, low)));
+        const int highMask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(needle, high)));
+        return std::popcount(static_cast<uint32_t>(lowMask | (highMask << 8)));
+    }
+}
+
+} // namespace detail
+
+
+template <typename T, typename ReservePolicy = RAMSizePolicyTag>
+class StaticSearchIndex
+{
+public:
+    static_assert(std::is_arithmetic_v<T>, "Search index is implemented for arithmetic types only");
+
+    using SourceContainer = GrowingVectorVM<T, ReservePolicy>;
+
+    static constexpr size_t NodeBytes = 64;
+    static constexpr size_t NodeSize = NodeBytes / sizeof(T) > 0 ? NodeBytes / sizeof(T) : 1;  // B
+    static constexpr size_t MaxLevels = 64;
+    static constexpr size_t BatchGroupSize = 16;    // needles walked together in batched lookups
+    static constexpr bool HasSimdNodes = (sizeof(T) == 4 || sizeof(T) == 8);
+
+    explicit StaticSearchIndex(const SourceContainer& source)
+        : m_source(&source)
+    {
+        Update();
+    }
+
+    StaticSearchIndex(StaticSearchIndex&&) noexcept = default;
+    StaticSearchIndex(const StaticSearchIndex&) = delete;
+    StaticSearchIndex& operator=(const StaticSearchIndex&) = delete;
+    StaticSearchIndex& operator=(StaticSearchIndex&&) = delete;
+
+    [[nodiscard]] size_t GetIndexedSize() const noexcept { return m_indexedSize; }
+    [[nodiscard]] size_t GetLevelCount() const noexcept { return m_levelCount; }
+    [[nodiscard]] bool IsStale() const noexcept { return m_source->GetSize() != m_indexedSize; }
+
+    // Extends the index to the elements appended to the source since the last update.
+    // Only the last node of every level is recomputed, levels are shifted in place when some of them gets a new node.
+    void Update()
+    {
+        const size_t newSize = m_source->GetSize();
+        if (newSize < m_indexedSize)
+        {
+            throw std::logic_error{ "Source was shrunk, Rebuild() is required" };
+        }
+        if (newSize == m_indexedSize)
+        {
+            return;
+        }
+
+        LevelInfo newLevels[MaxLevels];
+        size_t newLevelCount = 0;
+        size_t totalKeys = 0;
+        for (size_t childCount = DivideRoundUp(newSize, NodeSize); childCount > 1; childCount = DivideRoundUp(childCount, NodeSize))
+        {
+            assert(newLevelCount < MaxLevels);
+            newLevels[newLevelCount] = { totalKeys, childCount };
+            totalKeys += DivideRoundUp(childCount, NodeSize) * NodeSize;
+            newLevelCount++;
+        }
+
+        if (totalKeys > m_levels.GetSize())
+        {
+            m_levels.Resize(totalKeys); // can throw, index stays as it was
+        }
+
+        // levels grow only, so moving them to the right starting from the top one doesn't overwrite anything
+        T* const levels = m_levels.GetData();
+        for (size_t level = m_levelCount; level-- > 0;)
+        {
+            if (newLevels[level].offset != m_levelInfo[level].offset)
+            {
+                std::memmove(levels + newLevels[level].offset, levels + m_levelInfo[level].offset, GetPaddedKeyCount(m_levelInfo[level]) * sizeof(T));
+            }
+        }
+
+        const T* const source = m_source->GetData();
+        size_t firstDirty = m_indexedSize / NodeSize; // the last leaf block could be partial before
+        for (size_t level = 0; level < newLevelCount; level++)
+        {
+            if (level >= m_levelCount)
+            {
+                firstDirty = 0;
+            }
+
+            const LevelInfo& info = newLevels[level];
+            T* const keys = levels + info.offset;
+            for (size_t key = firstDirty; key < info.keyCount; key++)
+            {
+                if (level == 0)
+                {
+                    keys[key] = source[std::min((key + 1) * NodeSize, newSize) - 1];
+                }
+                else
+                {
+                    const LevelInfo& below = newLevels[level - 1];
+                    keys[key] = levels[below.offset + std::min((key + 1) * NodeSize, below.keyCount) - 1];
+                }
+            }
+            for (size_t key = info.keyCount; key < GetPaddedKeyCount(info); key++)
+            {
+                keys[key] = PaddingKey;
+            }
+
+            firstDirty /= NodeSize;
+        }
+
+        std::copy(newLevels, newLevels + newLevelCount, m_levelInfo);
+        m_levelCount = newLevelCount;
+        m_indexedSize = newSize;
+    }
+
+    void Rebuild()
+    {
+        m_levels.Clear();
+        m_levelCount = 0;
+        m_indexedSize = 0;
+        Update();
+    }
+
+    // Same as std::lower_bound over the indexed prefix of the source, returns index (GetIndexedSize() if not found)
+    [[nodiscard]] size_t LowerBound(const T key) const
+    {
+        if (m_indexedSize == 0)
+        {
+            return 0;
+        }
+
+        const bool useSimd = IsSimdEnabled();
+        const T* const levels = m_levels.GetData();
+        size_t child = 0;
+        for (size_t level = m_levelCount; level-- > 0;)
+        {
+            const LevelInfo& info = m_levelInfo[level];
+            child = child * NodeSize + NodeRank(levels + info.offset + child * NodeSize, key, useSimd);
+            if (child >= info.keyCount)
+            {
+                return m_indexedSize; // bigger than everything
+            }
+        }
+
+        return SearchLeaf(child, key, useSimd);
+    }
+
+    // Batched lookups: needles are processed in groups, each level is visited for the whole group
+    // and the next nodes are prefetched, so memory latency of different needles overlaps.
+    void LowerBoundBatch(const T* keys, const size_t count, size_t* results) const
+    {
+        const bool useSimd = IsSimdEnabled();
+        const T* const levels = m_levels.GetData();
+        const T* const source = m_source->GetData();
+
+        for (size_t groupStart = 0; groupStart < count; groupStart += BatchGroupSize)
+        {
+            const size_t groupSize = std::min(BatchGroupSize, count - groupStart);
+            const T* const groupKeys = keys + groupStart;
+            size_t* const groupResults = results + groupStart;
+
+            size_t children[BatchGroupSize] = {};
+            bool done[BatchGroupSize] = {};
+            for (size_t level = m_levelCount; level-- > 0;)
+            {
+                const LevelInfo& info = m_levelInfo[level];
+                for (size_t i = 0; i < groupSize; i++)
+                {
+                    if (done[i])
+                    {
+                        continue;
+                    }
+
+                    const size_t child = children[i] * NodeSize + NodeRank(levels + info.offset + children[i] * NodeSize, groupKeys[i], useSimd);
+                    if (child >= info.keyCount)
+                    {
+                        done[i] = true;
+                        groupResults[i] = m_indexedSize;
+                        continue;
+                    }
+                    children[i] = child;
+
+                    const T* next = level > 0 ? levels + m_levelInfo[level - 1].offset + child * NodeSize : source + child * NodeSize;
+                    _mm_prefetch(reinterpret_cast<const char*>(next), _MM_HINT_T0);
+                }
+            }
+
+            for (size_t i = 0; i < groupSize; i++)
+            {
+                if (!done[i])
+                {
+                    groupResults[i] = m_indexedSize == 0 ? 0 : SearchLeaf(children[i], groupKeys[i], useSimd);
+                }
+            }
+        }
+    }
+
+    template <typename ResultsContainer>
+    void LowerBoundBatch(const SourceContainer& keys, ResultsContainer& results) const
+    {
+        const size_t offset = results.GetSize();
+        results.Resize(offset + keys.GetSize());
+        LowerBoundBatch(keys.GetData(), keys.GetSize(), results.GetData() + offset);
+    }
+
+    [[nodiscard]] bool Contains(const T key) const
+    {
+        const size_t index = LowerBound(key);
+        return index < m_indexedSize && (*m_source)[index] == key;
+    }
+
+private:
+    struct LevelInfo
+    {
+        size_t offset;      // in m_levels
+        size_t keyCount;    // real keys (== amount of children), the last node is padded with PaddingKey
+    };
+
+    // Not less than any key, so padding is never counted: max() would be less than an infinite key
+    static constexpr T PaddingKey = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+
+    [[nodiscard]] static constexpr size_t DivideRoundUp(const size_t value, const size_t divider) noexcept
+    {
+        return (value + divider - 1) / divider;
+    }
+
+    [[nodiscard]] static size_t GetPaddedKeyCount(const LevelInfo& info) noexcept
+    {
+        return DivideRoundUp(info.keyCount, NodeSize) * NodeSize;
+    }
+
+    [[nodiscard]] static bool IsSimdEnabled() noexcept
+    {
+        return HasSimdNodes && simd::GetActiveSimdLevel() >= simd::SimdLevel::AVX2;
+    }
+
+    [[nodiscard]] static size_t NodeRank(const T* node, const T key, const bool useSimd) noexcept
+    {
+        if constexpr (HasSimdNodes)
+        {
+            if (useSimd)
+            {
+                return detail::NodeRankAVX2(node, key);
+            }
+        }
+        return detail::NodeRankScalar(node, NodeSize, key);
+    }
+
+    [[nodiscard]] size_t SearchLeaf(const size_t block, const T key, const bool useSimd) const noexcept
+    {
+        const size_t blockStart = block * NodeSize;
+        const T* const data = m_source->GetData() + blockStart;
+        const size_t blockSize = std::min(NodeSize, m_indexedSize - blockStart);
+        // the last block could be partial and there is no padding in the source
+        const size_t rank = blockSize == NodeSize ? NodeRank(data, key, useSimd) : detail::NodeRankScalar(data, blockSize, key);
+        return blockStart + rank;
+    }
+
+private:
+    const SourceContainer* m_source;
+    GrowingVectorVM<T, ReservePolicy> m_levels;     // internal levels, the one above leaves goes first
+    LevelInfo m_levelInfo[MaxLevels] = {};
+    size_t m_levelCount = 0;
+    size_t m_indexedSize = 0;
+};
+
+
+// Builds search index for sorted source. Index keeps pointer to the source, so the source has to outlive it.
+template <typename T, typename ReservePolicy>
+[[nodiscard]] StaticSearchIndex<T, ReservePolicy> BuildSearchIndex(const GrowingVectorVM<T, ReservePolicy>& source)
+{
+    return StaticSearchIndex<T, ReservePolicy>(source);
+}
+
+} // namespace ds end
@@ -0,0 +1,470 @@
+#pragma once
+
+// Binary serialization of GrowingVectorVM for trivially copyable types.
+//
+// File layout: HeaderBytes of header (format, element size/alignment, type tag, size, checksum of the payload)
+// and then raw elements. Payload starts at page boundary, so it can be either
+//  - read by LoadFrom() straight into freshly committed pages of the vector (one ReadFile per GB), or
+//  - mapped by MappedVectorView copy-on-write: zero-copy, pages are loaded on first access and written pages
+//    become private copies, the file is never modified.
+//
+// SaveTo()/LoadFrom() with a handle work from the current file position; MappedVectorView expects the data
+// at the beginning of the file (that's what path overloads produce).
+//
+// ReadAppend()/WriteRange() are raw (no header) ingest/egress: data goes between the file and the vector memory
+// directly, without intermediate buffers and per-element PushBack. Vector memory is page aligned, so unbuffered
+// files (FILE_FLAG_NO_BUFFERING, the O_DIRECT of Windows) work too as long as the range starts at a page.
+
+#include "PersistentGrowingVectorVM.h"
+
+#include <cstring>                      // for std::memcpy
+#include <filesystem>                   // for std::filesystem::path
+#include <numeric>                      // for std::lcm
+#include <stdexcept>                    // for std::runtime_error, std::logic_error
+#include <type_traits>
+
+
+namespace ds
+{
+
+struct SerializedVectorHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t headerBytes;
+    uint64_t elementSize;
+    uint64_t elementAlignment;
+    uint64_t typeTag;
+    uint64_t size;              // amount of elements
+    uint64_t checksum;          // of the payload, see CalculateChecksum
+};
+
+static constexpr uint64_t SerializedVectorMagic = 0x545253564756564Eull;  // "NVVGVSRT"
+static constexpr uint32_t SerializedVectorFormatVersion = 1;
+static constexpr size_t SerializedVectorHeaderBytes = 4096;              // keeps payload page aligned
+
+static_assert(sizeof(SerializedVectorHeader) <= SerializedVectorHeaderBytes);
+
+namespace detail
+{
+
+inline uint64_t RotateLeft(const uint64_t value, const int bits) noexcept
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t ChecksumRound(uint64_t accumulator, const uint64_t input) noexcept
+{
+    constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+    accumulator += input * Prime2;
+    return RotateLeft(accumulator, 31) * Prime1;
+}
+
+inline void ValidateRange(const size_t first, const size_t last, const size_t size)
+{
+    if (first > last || last > size)
+    {
+        throw std::out_of_range{ "Range is out of the vector" };
+    }
+}
+
+} // namespace detail
+
+// xxHash64-like checksum: 4 independent lanes, so it runs at memory speed instead of being a dependency chain.
+// Not a cryptographic hash, only detects truncated or damaged files.
+[[nodiscard]] inline uint64_t CalculateChecksum(const void* data, const size_t bytes) noexcept
+{
+    constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+
+    const auto* current = static_cast<const std::byte*>(data);
+    const std::byte* const end = current + bytes;
+
+    uint64_t lanes[4] = { Prime1 + Prime2, Prime2, 0, 0 - Prime1 };
+    for (; end - current >= 32; current += 32)
+    {
+        for (size_t lane = 0; lane < 4; lane++)
+        {
+            uint64_t input = 0;
+            std::memcpy(&input, current + lane * 8, sizeof(input));
+            lanes[lane] = detail::ChecksumRound(lanes[lane], input);
+        }
+    }
+
+    uint64_t result = detail::RotateLeft(lanes[0], 1) + detail::RotateLeft(lanes[1], 7) + detail::RotateLeft(lanes[2], 12) + detail::RotateLeft(lanes[3], 18);
+    for (; current < end; ++current)
+    {
+        result = detail::ChecksumRound(result, static_cast<uint64_t>(*current));
+    }
+    result ^= bytes;
+    result ^= result >> 33;
+    result *= Prime2;
+    result ^= result >> 29;
+    return result;
+}
+
+template <typename T>
+[[nodiscard]] SerializedVectorHeader MakeSerializedVectorHeader(const T* data, const size_t size) noexcept
+{
+    return { SerializedVectorMagic, SerializedVectorFormatVersion, SerializedVectorHeaderBytes, sizeof(T), alignof(T),
+        PersistentTypeTag<T>::value, size, CalculateChecksum(data, size * sizeof(T)) };
+}
+
+// Throws std::runtime_error if the header doesn't describe a vector of T
+template <typename T>
+void ValidateSerializedVectorHeader(const SerializedVectorHeader& header)
+{
+    if (header.magic != SerializedVectorMagic || header.version != SerializedVectorFormatVersion || header.headerBytes != SerializedVectorHeaderBytes)
+    {
+        throw std::runtime_error{ "File is not a serialized vector or has unsupported format version" };
+    }
+    if (header.elementSize != sizeof(T) || header.elementAlignment != alignof(T) || header.typeTag != PersistentTypeTag<T>::value)
+    {
+        throw std::runtime_error{ "File was written for another element type" };
+    }
+}
+
+
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+void SaveTo(HANDLE file, const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& vec)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be saved as is");
+
+    alignas(SerializedVectorHeader) std::byte headerBlock[SerializedVectorHeaderBytes] = {};
+    const SerializedVectorHeader header = MakeSerializedVectorHeader(vec.GetData(), vec.GetSize());
+    std::memcpy(headerBlock, &header, sizeof(header));
+
+    FileMappingHelper::WriteAll(file, headerBlock, sizeof(headerBlock));
+    FileMappingHelper::WriteAll(file, vec.GetData(), vec.GetSize() * sizeof(T));
+}
+
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+void SaveTo(const std::filesystem::path& path, const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& vec)
+{
+    HANDLE file = FileMappingHelper::OpenFile(path, true);
+    try
+    {
+        SaveTo(file, vec);
+    }
+    catch (...)
+    {
+        FileMappingHelper::CloseFile(file);
+        throw;
+    }
+    FileMappingHelper::CloseFile(file);
+}
+
+// Replaces content of the vector. Throws std::runtime_error if the file was written for another type,
+// is truncated or damaged (checksum mismatch), the vector is left empty then.
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+void LoadFrom(HANDLE file, GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& vec)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be loaded as is");
+
+    alignas(SerializedVectorHeader) std::byte headerBlock[SerializedVectorHeaderBytes];
+    FileMappingHelper::ReadAll(file, headerBlock, sizeof(headerBlock));
+    SerializedVectorHeader header;
+    std::memcpy(&header, headerBlock, sizeof(header));
+    ValidateSerializedVectorHeader<T>(header);
+    // checked before anything is committed, a damaged size must not reserve or commit memory
+    const size_t leftBytes = FileMappingHelper::GetFileSize(file) - FileMappingHelper::GetFilePosition(file);
+    if (header.size > leftBytes / sizeof(T))
+    {
+        throw std::runtime_error{ "File is truncated" };
+    }
+
+    vec.Clear();
+    try
+    {
+        // pages are committed by resize, for trivial types nothing is written to them before the read
+        vec.Resize(static_cast<size_t>(header.size));
+        FileMappingHelper::ReadAll(file, vec.GetData(), vec.GetSize() * sizeof(T));
+        if (CalculateChecksum(vec.GetData(), vec.GetSize() * sizeof(T)) != header.checksum)
+        {
+            throw std::runtime_error{ "Checksum mismatch, file is damaged" };
+        }
+    }
+    catch (...)
+    {
+        vec.Clear();
+        throw;
+    }
+}
+
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+void LoadFrom(const std::filesystem::path& path, GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& vec)
+{
+    HANDLE file = FileMappingHelper::OpenFile(path, false);
+    try
+    {
+        LoadFrom(file, vec);
+    }
+    catch (...)
+    {
+        FileMappingHelper::CloseFile(file);
+        throw;
+    }
+    FileMappingHelper::CloseFile(file);
+}
+
+
+// Reads up to maxBytes (whole elements only) from the current file position directly behind the end of the vector,
+// returns amount of appended elements. Pages for maxBytes are committed upfront, so pass a sane limit.
+// Unbuffered file requires size of the vector to be page aligned, maxBytes is rounded down to pages then.
+// Throws std::runtime_error if the file ends in the middle of an element (whole elements are appended anyway).
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+size_t ReadAppend(HANDLE file, GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& vec, const size_t maxBytes, const bool unbuffered = false)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be read as is");
+
+    const size_t oldSize = vec.GetSize();
+    size_t requestBytes = maxBytes / sizeof(T) * sizeof(T);
+    if (unbuffered)
+    {
+        const size_t pageSize = vec.GetPageSize();
+        if (oldSize * sizeof(T) % pageSize != 0)
+        {
+            throw std::logic_error{ "Unbuffered read requires page aligned end of the vector" };
+        }
+        // every read has to be a multiple of page, and file can't stop in the middle of an element
+        const size_t step = std::lcm(pageSize, sizeof(T));
+        requestBytes = requestBytes / step * step;
+    }
+    if (requestBytes == 0)
+    {
+        return 0;
+    }
+
+    // for trivial types nothing is written to committed pages
+    vec.Resize(oldSize + requestBytes / sizeof(T));
+    std::byte* tail = reinterpret_cast<std::byte*>(vec.GetData()) + oldSize * sizeof(T);
+
+    size_t readBytes = 0;
+    try
+    {
+        readBytes = FileMappingHelper::ReadUpTo(file, tail, requestBytes);
+    }
+    catch (...)
+    {
+        vec.Resize(oldSize);
+        throw;
+    }
+
+    const size_t readElements = readBytes / sizeof(T);
+    vec.Resize(oldSize + readElements);
+    if (readElements * sizeof(T) != readBytes)
+    {
+        throw std::runtime_error{ "File ends in the middle of an element" };
+    }
+    return readElements;
+}
+
+// Appends the whole file, returns amount of appended elements
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+size_t ReadAppend(const std::filesystem::path& path, GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& vec, const bool unbuffered = false)
+{
+    HANDLE file = FileMappingHelper::OpenFile(path, false, unbuffered);
+    try
+    {
+        // the last read is allowed to cross the end of the file, so a trailing partial element is detected
+        const size_t step = unbuffered ? std::lcm(vec.GetPageSize(), sizeof(T)) : sizeof(T);
+        const size_t fileBytes = (FileMappingHelper::GetFileSize(file) + step - 1) / step * step;
+        const size_t appended = ReadAppend(file, vec, fileBytes, unbuffered);
+        FileMappingHelper::CloseFile(file);
+        return appended;
+    }
+    catch (...)
+    {
+        FileMappingHelper::CloseFile(file);
+        throw;
+    }
+}
+
+// Writes elements [first, last) to the current file position.
+// Unbuffered file requires first to start a page and the write is padded up to the whole page
+// (with whatever follows last in the vector), truncate the file afterwards - path overload does it.
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+void WriteRange(HANDLE file, const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& vec, const size_t first, const size_t last, const bool unbuffered = false)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written as is");
+
+    detail::ValidateRange(first, last, vec.GetSize());
+    if (first == last)
+    {
+        return;
+    }
+
+    const std::byte* data = reinterpret_cast<const std::byte*>(vec.GetData()) + first * sizeof(T);
+    size_t bytes = (last - first) * sizeof(T);
+    if (unbuffered)
+    {
+        const size_t pageSize = vec.GetPageSize();
+        if (first * sizeof(T) % pageSize != 0)
+        {
+            throw std::logic_error{ "Unbuffered write requires range starting at a page" };
+        }
+        // memory is committed by pages, so the padding is readable
+        bytes = (bytes + pageSize - 1) / pageSize * pageSize;
+    }
+    FileMappingHelper::WriteAll(file, data, bytes);
+}
+
+// Overwrites the file with elements [first, last)
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+void WriteRange(const std::filesystem::path& path, const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& vec, const size_t first, const size_t last, const bool unbuffered = false)
+{
+    detail::ValidateRange(first, last, vec.GetSize()); // before the file is overwritten
+
+    HANDLE file = FileMappingHelper::OpenFile(path, true, unbuffered);
+    try
+    {
+        WriteRange(file, vec, first, last, unbuffered);
+        if (unbuffered && !FileMappingHelper::SetFileSize(file, (last - first) * sizeof(T)))
+        {
+            FileMappingHelper::ThrowLastError("Failed to truncate the file");
+        }
+    }
+    catch (...)
+    {
+        FileMappingHelper::CloseFile(file);
+        throw;
+    }
+    FileMappingHelper::CloseFile(file);
+}
+
+
+// Copy-on-write mapping of a file written by SaveTo. Checksum is not validated on open (that would read
+// the whole file), call VerifyChecksum() for that.
+template <typename T>
+class MappedVectorView
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be mapped as is");
+
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    // Throws std::runtime_error if the file was written for another type or is truncated
+    [[nodiscard]] static MappedVectorView Open(const std::filesystem::path& path)
+    {
+        return MappedVectorView(path);
+    }
+
+    ~MappedVectorView() noexcept
+    {
+        if (m_view != nullptr)
+        {
+            FileMappingHelper::UnmapView(m_view);
+        }
+    }
+
+    MappedVectorView(MappedVectorView&& other) noexcept
+        : m_view(std::exchange(other.m_view, nullptr))
+        , m_header(other.m_header)
+    {
+    }
+
+    MappedVectorView(const MappedVectorView&) = delete;
+    MappedVectorView& operator=(const MappedVectorView&) = delete;
+    MappedVectorView& operator=(MappedVectorView&&) = delete;
+
+    [[nodiscard]] inline size_type GetSize() const noexcept { return static_cast<size_type>(m_header.size); }
+    [[nodiscard]] inline bool Empty() const noexcept { return GetSize() == 0; }
+
+    [[nodiscard]] inline pointer GetData() noexcept { return reinterpret_cast<pointer>(static_cast<std::byte*>(m_view) + SerializedVectorHeaderBytes); }
+    [[nodiscard]] inline const_pointer GetData() const noexcept { return reinterpret_cast<const_pointer>(static_cast<const std::byte*>(m_view) + SerializedVectorHeaderBytes); }
+
+    [[nodiscard]] inline reference operator[](const size_type index) noexcept
+    {
+        assert(index < GetSize());
+        return GetData()[index];
+    }
+    [[nodiscard]] inline const_reference operator[](const size_type index) const noexcept
+    {
+        assert(index < GetSize());
+        return GetData()[index];
+    }
+
+    [[nodiscard]] const_reference At(const size_type index) const
+    {
+        if (index >= GetSize())
+        {
+            throw std::out_of_range{ "Index is out of range" };
+        }
+        return GetData()[index];
+    }
+
+    [[nodiscard]] inline iterator Begin() noexcept { return GetData(); }
+    [[nodiscard]] inline const_iterator Begin() const noexcept { return GetData(); }
+    [[nodiscard]] inline iterator End() noexcept { return GetData() + GetSize(); }
+    [[nodiscard]] inline const_iterator End() const noexcept { return GetData() + GetSize(); }
+
+    // Reads the whole mapping, so it's as expensive as a load. Modified elements fail the check too.
+    [[nodiscard]] bool VerifyChecksum() const noexcept
+    {
+        return CalculateChecksum(GetData(), GetSize() * sizeof(T)) == m_header.checksum;
+    }
+
+private:
+    explicit MappedVectorView(const std::filesystem::path& path)
+    {
+        HANDLE file = FileMappingHelper::OpenFile(path, false);
+        try
+        {
+            const size_t fileBytes = FileMappingHelper::GetFileSize(file);
+            if (fileBytes < SerializedVectorHeaderBytes)
+            {
+                throw std::runtime_error{ "File is too small to be a serialized vector" };
+            }
+            FileMappingHelper::ReadAll(file, &m_header, sizeof(m_header));
+            ValidateSerializedVectorHeader<T>(m_header);
+            if (m_header.size > (fileBytes - SerializedVectorHeaderBytes) / sizeof(T))
+            {
+                throw std::runtime_error{ "File is truncated" };
+            }
+
+            m_view = MapFileCopyOnWrite(file, SerializedVectorHeaderBytes + m_header.size * sizeof(T));
+            if (m_view == nullptr)
+            {
+                FileMappingHelper::ThrowLastError("Failed to map the file");
+            }
+        }
+        catch (...)
+        {
+            FileMappingHelper::CloseFile(file);
+            throw;
+        }
+        // the view keeps the file alive
+        FileMappingHelper::CloseFile(file);
+    }
+
+    [[nodiscard]] static void* MapFileCopyOnWrite(HANDLE file, const size_t bytes)
+    {
+#if WIN32
+        HANDLE section = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (section == nullptr)
+        {
+            return nullptr;
+        }
+
+        void* view = MapViewOfFile(section, FILE_MAP_COPY, 0, 0, bytes);
+        CloseHandle(section);
+        return view;
+#else
+#error Not implemented
+#endif
+    }
+
+private:
+    void* m_view = nullptr;
+    SerializedVectorHeader m_header = {};
+};
+
+} // namespace ds end
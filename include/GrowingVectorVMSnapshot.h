@@ -0,0 +1,398 @@
+#pragma once
+
+// Consistent point-in-time snapshot of live vectors to files, while the writer keeps mutating them.
+// There is no fork() on Windows, so copy-on-write is done in user space:
+// - SnapshotToFileAsync() makes all pages of the vectors read-only (one VirtualProtect per vector) and returns,
+//   that's the only pause for the caller;
+// - the first write to a protected page faults, the fault handler copies the original page aside and unprotects it;
+// - background thread saves pages in order (original copy if there is one, live page otherwise) and unprotects them.
+// Completion is reported through SnapshotHandle (pollable, also has native event handle for WaitForMultipleObjects).
+//
+// Every snapshot file has PersistentGrowingVectorVM format, so it can be opened with PersistentGrowingVectorVM::Open.
+//
+// While a snapshot is in progress the vectors must not be destroyed or shrunk (ShrinkToFit/Resize decommit pages),
+// growing them is fine. Writing into snapshotted memory by the kernel (e.g. ReadFile into the vector) fails with
+// ERROR_NOACCESS until the page is saved, see PageFaultRouter.
+
+#include "PersistentGrowingVectorVM.h"
+#include "PageFaultRouter.h"
+
+#include <atomic>
+#include <chrono>                       // for pause measurement
+#include <cstring>                      // for std::memcpy
+#include <exception>                    // for std::exception_ptr
+#include <initializer_list>
+#include <memory>                       // for std::unique_ptr
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace ds
+{
+
+// Type-erased description of the vector memory to save
+struct SnapshotSource
+{
+    const std::byte* data;
+    size_t bytes;
+    PersistentFileHeader header;        // header of the resulting file
+};
+
+struct SnapshotTarget
+{
+    std::filesystem::path path;
+    SnapshotSource source;
+};
+
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+[[nodiscard]] SnapshotSource MakeSnapshotSource(const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& vec)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be saved as is");
+
+    using FileFormat = PersistentGrowingVectorVM<T, ReservePolicy>;
+    SnapshotSource source;
+    source.data = reinterpret_cast<const std::byte*>(vec.GetData());
+    source.bytes = vec.GetSize() * sizeof(T);
+    source.header = { FileFormat::Magic, FileFormat::FormatVersion, FileFormat::HeaderBytes, sizeof(T), alignof(T), PersistentTypeTag<T>::value, vec.GetSize() };
+    return source;
+}
+
+namespace detail
+{
+
+class SnapshotJob
+{
+public:
+    static constexpr uint32_t PageProtected = ~uint32_t{ 0 };      // original content is in the vector, page is read-only
+    static constexpr uint32_t PageSaved = PageProtected - 1;        // page is written to the file and unprotected
+    static constexpr size_t ChunkPages = 64;                        // pages copied under the lock at once
+
+    SnapshotJob(const SnapshotTarget* targets, const size_t count)
+        : m_pageSize(PlatformHelper::CalculateVirtualPageSize(false))
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+
+        m_event = CreateCompletionEvent();
+        if (m_event == nullptr)
+        {
+            throw std::bad_alloc{};
+        }
+
+        // everything is allocated before pages are protected, fault handler allocates only page copies
+        m_regions.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            Region region;
+            region.path = targets[i].path;
+            region.source = targets[i].source;
+            region.pageCount = (region.source.bytes + m_pageSize - 1) / m_pageSize;
+            region.pageStates.assign(region.pageCount, PageProtected);
+            m_regions.push_back(std::move(region));
+        }
+
+        size_t protectedRegions = 0;
+        try
+        {
+            for (Region& region : m_regions)
+            {
+                if (region.pageCount == 0)
+                {
+                    ++protectedRegions;
+                    continue;
+                }
+
+                PageFaultRouter::GetInstance().Register(region.source.data, region.pageCount * m_pageSize, &SnapshotJob::HandleFault, this);
+                if (!SetProtection(region.source.data, region.pageCount * m_pageSize, false))
+                {
+                    PageFaultRouter::GetInstance().Unregister(region.source.data);
+                    throw std::logic_error{ "Failed to protect vector memory for snapshot" };
+                }
+                ++protectedRegions;
+            }
+        }
+        catch (...)
+        {
+            for (size_t i = 0; i < protectedRegions; i++)
+            {
+                ReleaseRegion(m_regions[i]);
+            }
+            CloseEvent(m_event);
+            throw;
+        }
+
+        m_pauseNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+        m_thread = std::thread(&SnapshotJob::Run, this);
+    }
+
+    ~SnapshotJob() noexcept
+    {
+        Join();
+        CloseEvent(m_event);
+    }
+
+    SnapshotJob(const SnapshotJob&) = delete;
+    SnapshotJob& operator=(const SnapshotJob&) = delete;
+
+    void Join() noexcept
+    {
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    [[nodiscard]] bool IsDone() const noexcept { return m_isDone.load(std::memory_order_acquire); }
+    [[nodiscard]] HANDLE GetEvent() const noexcept { return m_event; }
+    [[nodiscard]] size_t GetCopiedPageCount() const noexcept { return m_copiedPages.load(std::memory_order_relaxed); }
+    [[nodiscard]] size_t GetSavedPageCount() const noexcept { return m_savedPages.load(std::memory_order_relaxed); }
+    [[nodiscard]] double GetPauseNs() const noexcept { return m_pauseNs; }
+    [[nodiscard]] std::exception_ptr GetError() const noexcept { return m_error; }
+
+private:
+    struct Region
+    {
+        std::filesystem::path path;
+        SnapshotSource source;
+        size_t pageCount = 0;
+        std::vector<uint32_t> pageStates;       // PageProtected, PageSaved or index of the original copy
+        bool isReleased = false;
+    };
+
+    static bool HandleFault(void* context, void* address, const bool isWrite)
+    {
+        return isWrite && static_cast<SnapshotJob*>(context)->CopyPageOnWrite(static_cast<const std::byte*>(address));
+    }
+
+    bool CopyPageOnWrite(const std::byte* address)
+    {
+        std::lock_guard lock(m_mutex);
+        for (Region& region : m_regions)
+        {
+            const std::byte* begin = region.source.data;
+            if (region.isReleased || address < begin || address >= begin + region.pageCount * m_pageSize)
+            {
+                continue;
+            }
+
+            const size_t page = static_cast<size_t>(address - begin) / m_pageSize;
+            if (region.pageStates[page] == PageProtected)
+            {
+                const std::byte* pageStart = begin + page * m_pageSize;
+                const size_t copyOffset = m_copies.GetSize();
+                try
+                {
+                    m_copies.Resize(copyOffset + m_pageSize); // VM commit only, no heap inside exception dispatch
+                }
+                catch (...)
+                {
+                    return false; // exceptions can't leave exception dispatch, let the access violation go
+                }
+                std::memcpy(m_copies.GetData() + copyOffset, pageStart, m_pageSize);
+                region.pageStates[page] = static_cast<uint32_t>(copyOffset / m_pageSize);
+                m_copiedPages.fetch_add(1, std::memory_order_relaxed);
+
+                SetProtection(pageStart, m_pageSize, true);
+            }
+            // otherwise the page was handled by another thread already, just retry the access
+            return true;
+        }
+        return false;
+    }
+
+    void Run() noexcept
+    {
+        try
+        {
+            GrowingVectorVM<std::byte, CustomSizePolicyTag<DS_MB(16)>> buffer;
+            buffer.Resize(ChunkPages * m_pageSize);
+
+            for (Region& region : m_regions)
+            {
+                HANDLE file = FileMappingHelper::OpenFile(region.path, true);
+                try
+                {
+                    SaveRegion(region, file, buffer.GetData());
+                }
+                catch (...)
+                {
+                    FileMappingHelper::CloseFile(file);
+                    throw;
+                }
+                FileMappingHelper::CloseFile(file);
+            }
+        }
+        catch (...)
+        {
+            m_error = std::current_exception();
+        }
+
+        // on error there could be still protected pages
+        for (Region& region : m_regions)
+        {
+            ReleaseRegion(region);
+        }
+
+        m_isDone.store(true, std::memory_order_release);
+        SignalEvent(m_event);
+    }
+
+    void SaveRegion(Region& region, HANDLE file, std::byte* buffer)
+    {
+        using FileFormat = PersistentGrowingVectorVM<std::byte>;
+        alignas(PersistentFileHeader) std::byte header[FileFormat::HeaderBytes] = {};
+        std::memcpy(header, &region.source.header, sizeof(PersistentFileHeader));
+        FileMappingHelper::WriteAll(file, header, sizeof(header));
+
+        for (size_t firstPage = 0; firstPage < region.pageCount; firstPage += ChunkPages)
+        {
+            const size_t pageCount = std::min(ChunkPages, region.pageCount - firstPage);
+            {
+                std::lock_guard lock(m_mutex);
+                for (size_t i = 0; i < pageCount; i++)
+                {
+                    const uint32_t state = region.pageStates[firstPage + i];
+                    const std::byte* source = state == PageProtected
+                        ? region.source.data + (firstPage + i) * m_pageSize
+                        : m_copies.GetData() + static_cast<size_t>(state) * m_pageSize;
+                    std::memcpy(buffer + i * m_pageSize, source, m_pageSize);
+                    region.pageStates[firstPage + i] = PageSaved;
+                }
+                // saved pages don't need trapping anymore
+                SetProtection(region.source.data + firstPage * m_pageSize, pageCount * m_pageSize, true);
+            }
+
+            const size_t chunkOffset = firstPage * m_pageSize;
+            FileMappingHelper::WriteAll(file, buffer, std::min(pageCount * m_pageSize, region.source.bytes - chunkOffset));
+            m_savedPages.fetch_add(pageCount, std::memory_order_relaxed);
+        }
+    }
+
+    void ReleaseRegion(Region& region) noexcept
+    {
+        if (region.isReleased)
+        {
+            return;
+        }
+
+        if (region.pageCount > 0)
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                SetProtection(region.source.data, region.pageCount * m_pageSize, true);
+                region.isReleased = true;
+            }
+            PageFaultRouter::GetInstance().Unregister(region.source.data);
+        }
+        region.isReleased = true;
+    }
+
+    static bool SetProtection(const void* address, const size_t bytes, const bool isWritable)
+    {
+#if WIN32
+        DWORD oldProtection = 0;
+        return VirtualProtect(const_cast<void*>(address), bytes, isWritable ? PAGE_READWRITE : PAGE_READONLY, &oldProtection);
+#else
+#error Not implemented
+#endif
+    }
+
+    [[nodiscard]] static HANDLE CreateCompletionEvent()
+    {
+#if WIN32
+        return CreateEventW(nullptr, TRUE /*manual reset*/, FALSE, nullptr);
+#else
+#error Not implemented
+#endif
+    }
+
+    static void SignalEvent(HANDLE event)
+    {
+#if WIN32
+        SetEvent(event);
+#else
+#error Not implemented
+#endif
+    }
+
+    static void CloseEvent(HANDLE event)
+    {
+#if WIN32
+        CloseHandle(event);
+#else
+#error Not implemented
+#endif
+    }
+
+private:
+    size_t m_pageSize;
+    std::vector<Region> m_regions;
+    GrowingVectorVM<std::byte> m_copies;            // originals of pages written during the snapshot
+    std::mutex m_mutex;                             // page states and copies, shared by fault handler and saving thread
+
+    std::thread m_thread;
+    HANDLE m_event = nullptr;
+    std::atomic<bool> m_isDone{ false };
+    std::atomic<size_t> m_copiedPages{ 0 };
+    std::atomic<size_t> m_savedPages{ 0 };
+    double m_pauseNs = 0.0;
+    std::exception_ptr m_error;
+};
+
+} // namespace detail
+
+
+class SnapshotHandle
+{
+public:
+    explicit SnapshotHandle(std::unique_ptr<detail::SnapshotJob> job) noexcept
+        : m_job(std::move(job))
+    {
+    }
+
+    SnapshotHandle(SnapshotHandle&&) noexcept = default;
+    SnapshotHandle& operator=(SnapshotHandle&&) noexcept = default;
+
+    // Destruction waits for the snapshot to finish (vectors must stay alive till then anyway)
+    ~SnapshotHandle() = default;
+
+    // Non-blocking poll
+    [[nodiscard]] bool IsDone() const noexcept { return m_job->IsDone(); }
+
+    // Blocks till the snapshot is written, rethrows the error of the background thread if any
+    void Wait()
+    {
+        m_job->Join();
+        if (m_job->GetError())
+        {
+            std::rethrow_exception(m_job->GetError());
+        }
+    }
+
+    // Manual-reset event signaled on completion, for WaitForSingleObject/WaitForMultipleObjects
+    [[nodiscard]] HANDLE GetNativeHandle() const noexcept { return m_job->GetEvent(); }
+
+    // Pages which were written by the user during the snapshot and had to be copied
+    [[nodiscard]] size_t GetCopiedPageCount() const noexcept { return m_job->GetCopiedPageCount(); }
+    [[nodiscard]] size_t GetSavedPageCount() const noexcept { return m_job->GetSavedPageCount(); }
+    // Time the caller was blocked in SnapshotToFileAsync
+    [[nodiscard]] double GetPauseNs() const noexcept { return m_job->GetPauseNs(); }
+
+private:
+    std::unique_ptr<detail::SnapshotJob> m_job;
+};
+
+
+// All targets are frozen at the same moment, so several vectors are consistent with each other
+[[nodiscard]] inline SnapshotHandle SnapshotToFileAsync(std::initializer_list<SnapshotTarget> targets)
+{
+    return SnapshotHandle(std::make_unique<detail::SnapshotJob>(targets.begin(), targets.size()));
+}
+
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve>
+[[nodiscard]] SnapshotHandle SnapshotToFileAsync(const std::filesystem::path& path, const GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>& vec)
+{
+    return SnapshotToFileAsync({ SnapshotTarget{ path, MakeSnapshotSource(vec) } });
+}
+
+} // namespace ds end
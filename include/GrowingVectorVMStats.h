@@ -0,0 +1,291 @@
+#pragma once
+
+// Process-wide memory statistics of all GrowingVectorVM instances: reservations, commits, decommits, releases,
+// currently reserved and committed bytes (also per reserve policy, to see which ones waste RAM) and
+// a histogram of commit call latency.
+//
+// Counting is compiled in only with DS_ENABLE_MEMORY_STATS=1 (CMake option ENABLE_MEMORY_STATS), otherwise
+// GrowingVectorVM has no trace of it and the snapshot is all zeros. Counters are relaxed atomics, so a snapshot
+// taken while other threads allocate is not a consistent cut, every single value is correct though.
+//
+// Usage:
+//    ds::MemoryStatsSnapshot stats = ds::GetMemoryStats();
+//    ds::WritePrometheusMetrics(GetStdHandle(STD_OUTPUT_HANDLE));
+//
+// Note: it doesn't include GrowingVectorVM.h, GrowingVectorVM.h includes it when counting is enabled.
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#error Unsupported
+#endif
+
+#include <stdint.h>
+#include <algorithm>                    // for std::min
+#include <array>
+#include <atomic>
+#include <bit>                          // for std::bit_width
+#include <chrono>
+#include <cstdio>                       // for std::snprintf
+#include <string>
+
+
+namespace ds
+{
+
+#if DS_ENABLE_MEMORY_STATS
+static constexpr bool IsMemoryStatsEnabled = true;
+#else
+static constexpr bool IsMemoryStatsEnabled = false;
+#endif
+
+// Order matches CalculatePolicyStatsIndex() in GrowingVectorVM.h
+static constexpr size_t MemoryStatsPolicyCount = 8;
+static constexpr const char* MemoryStatsPolicyNames[MemoryStatsPolicyCount] = { "4GB", "8GB", "16GB", "RAM", "RAMDouble", "ContainerLimit", "Runtime", "Custom" };
+
+// Bucket i counts commits which took up to 2^i microseconds, the last one everything slower
+static constexpr size_t CommitLatencyBucketCount = 17;
+
+struct PolicyMemoryStats
+{
+    uint64_t vectors;                   // alive reservations
+    uint64_t reservedBytes;
+    uint64_t committedBytes;
+};
+
+struct MemoryStatsSnapshot
+{
+    uint64_t reservations;
+    uint64_t releases;
+    uint64_t commitCalls;
+    uint64_t commitBytes;
+    uint64_t decommitCalls;
+    uint64_t decommitBytes;
+    uint64_t reservedBytes;             // currently reserved
+    uint64_t committedBytes;            // currently committed
+    uint64_t largestReservationBytes;
+    uint64_t commitLatencySumNs;
+    std::array<uint64_t, CommitLatencyBucketCount> commitLatencyBuckets;    // not cumulative
+    std::array<PolicyMemoryStats, MemoryStatsPolicyCount> policies;
+};
+
+
+namespace detail
+{
+
+class MemoryStatsCounters
+{
+public:
+    [[nodiscard]] static MemoryStatsCounters& GetInstance() noexcept
+    {
+        static MemoryStatsCounters counters;
+        return counters;
+    }
+
+    void RecordReserve(const size_t policy, const uint64_t reservedBytes, const uint64_t committedBytes) noexcept
+    {
+        m_reservations.fetch_add(1, std::memory_order_relaxed);
+        m_reservedBytes.fetch_add(reservedBytes, std::memory_order_relaxed);
+        m_committedBytes.fetch_add(committedBytes, std::memory_order_relaxed);
+        m_policies[policy].vectors.fetch_add(1, std::memory_order_relaxed);
+        m_policies[policy].reservedBytes.fetch_add(reservedBytes, std::memory_order_relaxed);
+        m_policies[policy].committedBytes.fetch_add(committedBytes, std::memory_order_relaxed);
+
+        uint64_t largest = m_largestReservationBytes.load(std::memory_order_relaxed);
+        while (largest < reservedBytes && !m_largestReservationBytes.compare_exchange_weak(largest, reservedBytes, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void RecordRelease(const size_t policy, const uint64_t reservedBytes, const uint64_t committedBytes) noexcept
+    {
+        m_releases.fetch_add(1, std::memory_order_relaxed);
+        m_reservedBytes.fetch_sub(reservedBytes, std::memory_order_relaxed);
+        m_committedBytes.fetch_sub(committedBytes, std::memory_order_relaxed);
+        m_policies[policy].vectors.fetch_sub(1, std::memory_order_relaxed);
+        m_policies[policy].reservedBytes.fetch_sub(reservedBytes, std::memory_order_relaxed);
+        m_policies[policy].committedBytes.fetch_sub(committedBytes, std::memory_order_relaxed);
+    }
+
+    void RecordCommit(const size_t policy, const uint64_t bytes, const std::chrono::steady_clock::duration latency) noexcept
+    {
+        const uint64_t nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+        const size_t bucket = std::min<size_t>(std::bit_width(nanoseconds == 0 ? 0 : (nanoseconds - 1) / 1000), CommitLatencyBucketCount - 1);
+
+        m_commitCalls.fetch_add(1, std::memory_order_relaxed);
+        m_commitBytes.fetch_add(bytes, std::memory_order_relaxed);
+        m_committedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        m_policies[policy].committedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        m_commitLatencySumNs.fetch_add(nanoseconds, std::memory_order_relaxed);
+        m_commitLatencyBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void RecordDecommit(const size_t policy, const uint64_t bytes) noexcept
+    {
+        m_decommitCalls.fetch_add(1, std::memory_order_relaxed);
+        m_decommitBytes.fetch_add(bytes, std::memory_order_relaxed);
+        m_committedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        m_policies[policy].committedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] MemoryStatsSnapshot TakeSnapshot() const noexcept
+    {
+        MemoryStatsSnapshot snapshot = {};
+        snapshot.reservations = m_reservations.load(std::memory_order_relaxed);
+        snapshot.releases = m_releases.load(std::memory_order_relaxed);
+        snapshot.commitCalls = m_commitCalls.load(std::memory_order_relaxed);
+        snapshot.commitBytes = m_commitBytes.load(std::memory_order_relaxed);
+        snapshot.decommitCalls = m_decommitCalls.load(std::memory_order_relaxed);
+        snapshot.decommitBytes = m_decommitBytes.load(std::memory_order_relaxed);
+        snapshot.reservedBytes = m_reservedBytes.load(std::memory_order_relaxed);
+        snapshot.committedBytes = m_committedBytes.load(std::memory_order_relaxed);
+        snapshot.largestReservationBytes = m_largestReservationBytes.load(std::memory_order_relaxed);
+        snapshot.commitLatencySumNs = m_commitLatencySumNs.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < CommitLatencyBucketCount; i++)
+        {
+            snapshot.commitLatencyBuckets[i] = m_commitLatencyBuckets[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < MemoryStatsPolicyCount; i++)
+        {
+            snapshot.policies[i].vectors = m_policies[i].vectors.load(std::memory_order_relaxed);
+            snapshot.policies[i].reservedBytes = m_policies[i].reservedBytes.load(std::memory_order_relaxed);
+            snapshot.policies[i].committedBytes = m_policies[i].committedBytes.load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+private:
+    MemoryStatsCounters() = default;
+
+    MemoryStatsCounters(const MemoryStatsCounters&) = delete;
+    MemoryStatsCounters& operator=(const MemoryStatsCounters&) = delete;
+
+    struct PolicyCounters
+    {
+        std::atomic<uint64_t> vectors = 0;
+        std::atomic<uint64_t> reservedBytes = 0;
+        std::atomic<uint64_t> committedBytes = 0;
+    };
+
+private:
+    std::atomic<uint64_t> m_reservations = 0;
+    std::atomic<uint64_t> m_releases = 0;
+    std::atomic<uint64_t> m_commitCalls = 0;
+    std::atomic<uint64_t> m_commitBytes = 0;
+    std::atomic<uint64_t> m_decommitCalls = 0;
+    std::atomic<uint64_t> m_decommitBytes = 0;
+    std::atomic<uint64_t> m_reservedBytes = 0;
+    std::atomic<uint64_t> m_committedBytes = 0;
+    std::atomic<uint64_t> m_largestReservationBytes = 0;
+    std::atomic<uint64_t> m_commitLatencySumNs = 0;
+    std::array<std::atomic<uint64_t>, CommitLatencyBucketCount> m_commitLatencyBuckets = {};
+    std::array<PolicyCounters, MemoryStatsPolicyCount> m_policies = {};
+};
+
+inline void AppendMetric(std::string& text, const char* name, const char* type, const char* help, const uint64_t value)
+{
+    text += "# HELP ";
+    text += name;
+    text += ' ';
+    text += help;
+    text += "\n# TYPE ";
+    text += name;
+    text += ' ';
+    text += type;
+    text += '\n';
+    text += name;
+    text += ' ';
+    text += std::to_string(value);
+    text += '\n';
+}
+
+} // namespace detail end
+
+
+[[nodiscard]] inline MemoryStatsSnapshot GetMemoryStats() noexcept
+{
+    return detail::MemoryStatsCounters::GetInstance().TakeSnapshot();
+}
+
+// Prometheus text exposition format (version 0.0.4)
+[[nodiscard]] inline std::string FormatPrometheusMetrics(const MemoryStatsSnapshot& stats)
+{
+    std::string text;
+    detail::AppendMetric(text, "ds_vm_reservations_total", "counter", "Address ranges reserved by GrowingVectorVM", stats.reservations);
+    detail::AppendMetric(text, "ds_vm_releases_total", "counter", "Address ranges released by GrowingVectorVM", stats.releases);
+    detail::AppendMetric(text, "ds_vm_commit_calls_total", "counter", "Commit calls made on growth", stats.commitCalls);
+    detail::AppendMetric(text, "ds_vm_commit_bytes_total", "counter", "Bytes committed on growth", stats.commitBytes);
+    detail::AppendMetric(text, "ds_vm_decommit_calls_total", "counter", "Decommit calls", stats.decommitCalls);
+    detail::AppendMetric(text, "ds_vm_decommit_bytes_total", "counter", "Bytes decommitted", stats.decommitBytes);
+    detail::AppendMetric(text, "ds_vm_reserved_bytes", "gauge", "Currently reserved address space", stats.reservedBytes);
+    detail::AppendMetric(text, "ds_vm_committed_bytes", "gauge", "Currently committed memory", stats.committedBytes);
+    detail::AppendMetric(text, "ds_vm_largest_reservation_bytes", "gauge", "Largest single reservation made so far", stats.largestReservationBytes);
+
+    text += "# HELP ds_vm_policy_reserved_bytes Currently reserved address space per reserve policy\n";
+    text += "# TYPE ds_vm_policy_reserved_bytes gauge\n";
+    for (size_t i = 0; i < MemoryStatsPolicyCount; i++)
+    {
+        text += "ds_vm_policy_reserved_bytes{policy=\"";
+        text += MemoryStatsPolicyNames[i];
+        text += "\"} " + std::to_string(stats.policies[i].reservedBytes) + '\n';
+    }
+    text += "# HELP ds_vm_policy_committed_bytes Currently committed memory per reserve policy\n";
+    text += "# TYPE ds_vm_policy_committed_bytes gauge\n";
+    for (size_t i = 0; i < MemoryStatsPolicyCount; i++)
+    {
+        text += "ds_vm_policy_committed_bytes{policy=\"";
+        text += MemoryStatsPolicyNames[i];
+        text += "\"} " + std::to_string(stats.policies[i].committedBytes) + '\n';
+    }
+    text += "# HELP ds_vm_policy_vectors Alive vectors per reserve policy\n";
+    text += "# TYPE ds_vm_policy_vectors gauge\n";
+    for (size_t i = 0; i < MemoryStatsPolicyCount; i++)
+    {
+        text += "ds_vm_policy_vectors{policy=\"";
+        text += MemoryStatsPolicyNames[i];
+        text += "\"} " + std::to_string(stats.policies[i].vectors) + '\n';
+    }
+
+    text += "# HELP ds_vm_commit_latency_seconds Latency of commit calls made on growth\n";
+    text += "# TYPE ds_vm_commit_latency_seconds histogram\n";
+    uint64_t cumulative = 0;
+    char bound[32];
+    for (size_t i = 0; i + 1 < CommitLatencyBucketCount; i++)
+    {
+        cumulative += stats.commitLatencyBuckets[i];
+        std::snprintf(bound, sizeof(bound), "%g", static_cast<double>(uint64_t{ 1 } << i) * 1e-6);
+        text += "ds_vm_commit_latency_seconds_bucket{le=\"";
+        text += bound;
+        text += "\"} " + std::to_string(cumulative) + '\n';
+    }
+    cumulative += stats.commitLatencyBuckets[CommitLatencyBucketCount - 1];
+    text += "ds_vm_commit_latency_seconds_bucket{le=\"+Inf\"} " + std::to_string(cumulative) + '\n';
+    std::snprintf(bound, sizeof(bound), "%.9f", static_cast<double>(stats.commitLatencySumNs) * 1e-9);
+    text += "ds_vm_commit_latency_seconds_sum ";
+    text += bound;
+    text += "\nds_vm_commit_latency_seconds_count " + std::to_string(cumulative) + '\n';
+    return text;
+}
+
+// Dumps current statistics to a file, pipe or console handle. Returns false if writing failed.
+inline bool WritePrometheusMetrics(HANDLE output)
+{
+    const std::string text = FormatPrometheusMetrics(GetMemoryStats());
+#if WIN32
+    size_t written = 0;
+    while (written < text.size())
+    {
+        DWORD chunk = 0;
+        if (!WriteFile(output, text.data() + written, static_cast<DWORD>(text.size() - written), &chunk, nullptr) || chunk == 0)
+        {
+            return false;
+        }
+        written += chunk;
+    }
+    return true;
+#else
+#error Not implemented
+#endif
+}
+
+} // namespace ds end
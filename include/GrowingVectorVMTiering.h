@@ -0,0 +1,257 @@
+#pragma once
+
+// Spill-to-disk tiering for append-mostly vectors (event logs etc.) where only the newest tail is hot.
+//
+// ColdPageSpiller keeps resident data of the vector within a budget: Maintain() writes the oldest pages to a backing
+// file and decommits them. Addresses don't change, so existing pointers and iterators stay valid: the first access
+// to a spilled page faults, the page is committed again and read back from the file (see PageFaultRouter).
+// Pages brought back are read-only until written, so a clean page is dropped again without any I/O,
+// and they are the first candidates for the next spill.
+//
+// Restrictions:
+// - Maintain() has to be called by the owner (e.g. after a batch of appends), nothing is spilled in background.
+// - Writes into the cold part of the vector must not race with Maintain(), concurrent reads are fine.
+// - Kernel accesses to spilled pages (WriteFile from the vector memory etc.) fail instead of faulting them in.
+// - The vector must not be shrunk or moved while the spiller is alive, the spiller must die before the vector.
+
+#include "PersistentGrowingVectorVM.h"
+#include "PageFaultRouter.h"
+
+#include <filesystem>                   // for std::filesystem::path
+#include <mutex>
+
+
+namespace ds
+{
+
+template <typename T, typename ReservePolicy, bool CommitPagesWithReserve = false>
+class ColdPageSpiller
+{
+public:
+    using VectorType = GrowingVectorVM<T, ReservePolicy, CommitPagesWithReserve>;
+
+    // Backing file is created (overwritten if it exists) and removed by the destructor
+    ColdPageSpiller(VectorType& vec, const std::filesystem::path& backingFile, const size_t residentBudgetBytes)
+        : m_vector(&vec)
+        , m_path(backingFile)
+        , m_pageSize(vec.GetPageSize())
+        , m_budgetPages(residentBudgetBytes / vec.GetPageSize())
+    {
+        m_base = reinterpret_cast<std::byte*>(vec.Begin().operator->());
+        m_file = FileMappingHelper::OpenFile(m_path, true);
+        try
+        {
+            PageFaultRouter::GetInstance().Register(m_base, vec.GetReserve() * sizeof(T), &ColdPageSpiller::HandleFault, this);
+        }
+        catch (...)
+        {
+            CloseBackingFile();
+            throw;
+        }
+    }
+
+    // Spilled pages are brought back, so the vector is complete after the spiller is gone
+    ~ColdPageSpiller() noexcept
+    {
+        try
+        {
+            std::lock_guard lock(m_mutex);
+            for (size_t page = 0; page < m_states.GetSize(); page++)
+            {
+                if (m_states[page] == PageState::Spilled)
+                {
+                    FaultIn(page, true);
+                }
+                else if (m_states[page] == PageState::Clean)
+                {
+                    SetProtection(page, true);
+                }
+            }
+        }
+        catch (...)
+        {
+            assert(false && "Failed to read spilled pages back");
+        }
+        PageFaultRouter::GetInstance().Unregister(m_base);
+        CloseBackingFile();
+    }
+
+    ColdPageSpiller(const ColdPageSpiller&) = delete;
+    ColdPageSpiller& operator=(const ColdPageSpiller&) = delete;
+
+    void SetResidentBudget(const size_t residentBudgetBytes) noexcept { m_budgetPages = residentBudgetBytes / m_pageSize; }
+    [[nodiscard]] size_t GetResidentBudget() const noexcept { return m_budgetPages * m_pageSize; }
+
+    [[nodiscard]] size_t GetSpilledPageCount() const noexcept { return m_spilledPages; }
+    [[nodiscard]] size_t GetFaultInCount() const noexcept { return m_faultIns; }
+    [[nodiscard]] size_t GetResidentBytes() const noexcept { return (CalculateUsedPages() - m_spilledPages) * m_pageSize; }
+
+    // Spills the oldest pages until resident data fits the budget, returns amount of spilled pages.
+    // The last (partially filled) page is never spilled.
+    size_t Maintain()
+    {
+        std::lock_guard lock(m_mutex);
+
+        const size_t fullPages = m_vector->GetSize() * sizeof(T) / m_pageSize;
+        if (m_states.GetSize() < fullPages)
+        {
+            m_states.Resize(fullPages, PageState::Resident);
+        }
+
+        const size_t usedPages = CalculateUsedPages();
+        size_t spilled = 0;
+        while (usedPages - m_spilledPages > m_budgetPages)
+        {
+            const size_t excess = usedPages - m_spilledPages - m_budgetPages;
+            if (m_faultedHead < m_faulted.GetSize())
+            {
+                // pages read back are older than anything not spilled yet
+                const size_t page = m_faulted[m_faultedHead++];
+                SpillPages(page, 1, m_states[page] == PageState::Resident);
+                spilled++;
+            }
+            else if (m_nextCold < fullPages)
+            {
+                // never spilled pages go in one write
+                const size_t count = std::min(excess, fullPages - m_nextCold);
+                SpillPages(m_nextCold, count, true);
+                m_nextCold += count;
+                spilled += count;
+            }
+            else
+            {
+                break; // everything spillable is spilled
+            }
+        }
+
+        if (m_faultedHead == m_faulted.GetSize())
+        {
+            m_faulted.Clear();
+            m_faultedHead = 0;
+        }
+        return spilled;
+    }
+
+private:
+    enum class PageState : uint8_t
+    {
+        Resident,               // writable, file copy (if any) is stale
+        Clean,                  // read back from the file and not modified since, read-only
+        Spilled                 // decommitted, content is in the file
+    };
+
+    static bool HandleFault(void* context, void* address, const bool isWrite)
+    {
+        return static_cast<ColdPageSpiller*>(context)->Resolve(static_cast<const std::byte*>(address), isWrite);
+    }
+
+    bool Resolve(const std::byte* address, const bool isWrite)
+    {
+        std::lock_guard lock(m_mutex);
+        const size_t page = static_cast<size_t>(address - m_base) / m_pageSize;
+        if (page >= m_states.GetSize())
+        {
+            return false; // not ours, e.g. access to uncommitted memory
+        }
+
+        try
+        {
+            switch (m_states[page])
+            {
+            case PageState::Spilled:
+                FaultIn(page, isWrite);
+                m_faulted.PushBack(page);
+                return true;
+            case PageState::Clean:
+                if (isWrite)
+                {
+                    SetProtection(page, true);
+                    m_states[page] = PageState::Resident;
+                }
+                return true;
+            case PageState::Resident:
+                return true; // resolved by another thread already
+            }
+        }
+        catch (...)
+        {
+            // can't throw from the exception dispatch, let it crash as an access violation
+        }
+        return false;
+    }
+
+    void FaultIn(const size_t page, const bool isWrite)
+    {
+        void* address = m_base + page * m_pageSize;
+        if (PlatformHelper::CommitVirtualMemory(address, m_pageSize) == nullptr)
+        {
+            throw std::bad_alloc{};
+        }
+        FileMappingHelper::SetFilePosition(m_file, page * m_pageSize);
+        FileMappingHelper::ReadAll(m_file, address, m_pageSize);
+
+        if (!isWrite)
+        {
+            SetProtection(page, false);
+        }
+        m_states[page] = isWrite ? PageState::Resident : PageState::Clean;
+        m_spilledPages--;
+        m_faultIns++;
+    }
+
+    void SpillPages(const size_t firstPage, const size_t count, const bool shouldWrite)
+    {
+        void* address = m_base + firstPage * m_pageSize;
+        if (shouldWrite)
+        {
+            FileMappingHelper::SetFilePosition(m_file, firstPage * m_pageSize);
+            FileMappingHelper::WriteAll(m_file, address, count * m_pageSize);
+        }
+        PlatformHelper::DecommitVirtualMemory(address, count * m_pageSize);
+
+        for (size_t page = firstPage; page < firstPage + count; page++)
+        {
+            m_states[page] = PageState::Spilled;
+        }
+        m_spilledPages += count;
+    }
+
+    void SetProtection(const size_t page, const bool isWritable)
+    {
+#if WIN32
+        DWORD oldProtection = 0;
+        VirtualProtect(m_base + page * m_pageSize, m_pageSize, isWritable ? PAGE_READWRITE : PAGE_READONLY, &oldProtection);
+#else
+#error Not implemented
+#endif
+    }
+
+    [[nodiscard]] size_t CalculateUsedPages() const noexcept
+    {
+        return (m_vector->GetSize() * sizeof(T) + m_pageSize - 1) / m_pageSize;
+    }
+
+    void CloseBackingFile() noexcept
+    {
+        FileMappingHelper::CloseFile(m_file);
+        std::error_code error;
+        std::filesystem::remove(m_path, error);
+    }
+
+private:
+    VectorType* m_vector;
+    std::filesystem::path m_path;
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    std::byte* m_base = nullptr;
+    size_t m_pageSize;
+    size_t m_budgetPages;
+    GrowingVectorVM<PageState, ReservePolicy> m_states;     // for pages which can be spilled
+    size_t m_nextCold = 0;                                  // pages [0, m_nextCold) were spilled at least once
+    GrowingVectorVM<size_t, ReservePolicy> m_faulted;       // pages read back, FIFO
+    size_t m_faultedHead = 0;
+    size_t m_spilledPages = 0;
+    size_t m_faultIns = 0;
+    std::mutex m_mutex;                                     // shared by fault handler and Maintain()
+};
+
+} // namespace ds end
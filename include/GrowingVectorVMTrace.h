@@ -0,0 +1,297 @@
+#pragma once
+
+// Recording of mutating operations of all GrowingVectorVM instances to a compact binary file, so a production mix of
+// appends, inserts, erases and resizes can be replayed later against other policies (see benchmarks/trace_replay.cpp).
+//
+// Hooks are compiled in only with DS_ENABLE_OPERATION_TRACE=1 (CMake option ENABLE_OPERATION_TRACE), otherwise
+// GrowingVectorVM has no trace of them. With hooks compiled in, an operation costs one atomic load until
+// a recorder is started.
+//
+// Usage:
+//    ds::TraceRecorder recorder("vectors.trace");
+//    recorder.Start();
+//    ...
+//    recorder.Stop();
+//
+// Vectors are identified by their address, so a record of a moved vector refers to the new address.
+// File: TraceFileHeader and then TraceRecord-s in the order operations happened.
+//
+// Note: it doesn't include GrowingVectorVM.h, GrowingVectorVM.h includes it when hooks are enabled.
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#error Unsupported
+#endif
+
+#include <stdint.h>
+#include <algorithm>                    // for std::min
+#include <atomic>
+#include <chrono>
+#include <filesystem>                   // for std::filesystem::path
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+
+namespace ds
+{
+
+enum class TraceOperation : uint8_t
+{
+    Create,                             // first: element size, count: reserved bytes
+    Destroy,
+    Append,                             // first: index of the new element
+    Insert,                             // first: index, count: amount of inserted elements
+    Erase,                              // first: index, count: amount of erased elements
+    Resize,                             // first: new size
+    Clear,
+    MoveConstruct,                      // first: source vector
+    MoveAssign,                         // first: source vector
+    Swap                                // first: other vector
+};
+
+struct TraceFileHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+};
+
+struct TraceRecord
+{
+    uint64_t timestampNs;               // since the recorder was started
+    uint64_t vector;
+    uint64_t first;
+    uint64_t count;
+    TraceOperation operation;
+    uint8_t reserved[7];
+};
+
+static constexpr uint64_t TraceMagic = 0x4543415254564756ull;   // "VGVTRACE"
+static constexpr uint32_t TraceFormatVersion = 1;
+
+using OperationTraceSink = void (*)(const void* vector, TraceOperation operation, uint64_t first, uint64_t count) noexcept;
+
+[[nodiscard]] inline std::atomic<OperationTraceSink>& GetOperationTraceSink() noexcept
+{
+    static std::atomic<OperationTraceSink> sink{ nullptr };
+    return sink;
+}
+
+
+namespace detail
+{
+
+inline void NotifyOperation(const void* vector, const TraceOperation operation, const uint64_t first, const uint64_t count) noexcept
+{
+    const OperationTraceSink sink = GetOperationTraceSink().load(std::memory_order_acquire);
+    if (sink != nullptr) [[unlikely]]
+    {
+        sink(vector, operation, first, count);
+    }
+}
+
+[[nodiscard]] inline bool WriteTraceBytes(HANDLE file, const void* data, const size_t bytes) noexcept
+{
+#if WIN32
+    const char* begin = static_cast<const char*>(data);
+    size_t written = 0;
+    while (written < bytes)
+    {
+        DWORD chunk = 0;
+        const DWORD toWrite = static_cast<DWORD>(std::min<size_t>(bytes - written, 1u << 30));
+        if (!WriteFile(file, begin + written, toWrite, &chunk, nullptr) || chunk == 0)
+        {
+            return false;
+        }
+        written += chunk;
+    }
+    return true;
+#else
+#error Not implemented
+#endif
+}
+
+} // namespace detail end
+
+
+// Only one recorder can be started at a time, records of all threads go to the same file.
+// Stop (or destroy) the recorder only when other threads don't modify vectors anymore.
+class TraceRecorder
+{
+public:
+    // File is created (overwritten if it exists)
+    explicit TraceRecorder(const std::filesystem::path& path)
+    {
+#if WIN32
+        m_file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+#error Not implemented
+#endif
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error{ "Failed to create the trace file" };
+        }
+
+        const TraceFileHeader header = { TraceMagic, TraceFormatVersion, sizeof(TraceRecord) };
+        if (!detail::WriteTraceBytes(m_file, &header, sizeof(header)))
+        {
+            CloseHandle(m_file);
+            throw std::runtime_error{ "Failed to write the trace file" };
+        }
+        m_buffer.reserve(BufferRecords);
+    }
+
+    ~TraceRecorder() noexcept
+    {
+        StopRecording();
+        CloseHandle(m_file);
+    }
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    void Start()
+    {
+        TraceRecorder* expected = nullptr;
+        if (!GetActiveRecorder().compare_exchange_strong(expected, this))
+        {
+            throw std::logic_error{ "Another trace recorder is started already" };
+        }
+        m_start = std::chrono::steady_clock::now();
+        GetOperationTraceSink().store(&TraceRecorder::Record, std::memory_order_release);
+    }
+
+    // Stops recording and writes everything buffered, throws std::runtime_error if any write failed
+    void Stop()
+    {
+        if (!StopRecording())
+        {
+            throw std::runtime_error{ "Failed to write the trace file" };
+        }
+    }
+
+    [[nodiscard]] uint64_t GetRecordCount() const noexcept { return m_recordCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t BufferRecords = 64 * 1024;
+
+    [[nodiscard]] static std::atomic<TraceRecorder*>& GetActiveRecorder() noexcept
+    {
+        static std::atomic<TraceRecorder*> recorder{ nullptr };
+        return recorder;
+    }
+
+    static void Record(const void* vector, const TraceOperation operation, const uint64_t first, const uint64_t count) noexcept
+    {
+        TraceRecorder* recorder = GetActiveRecorder().load(std::memory_order_acquire);
+        if (recorder != nullptr)
+        {
+            recorder->Append(vector, operation, first, count);
+        }
+    }
+
+    void Append(const void* vector, const TraceOperation operation, const uint64_t first, const uint64_t count) noexcept
+    {
+        std::lock_guard lock(m_mutex);
+        TraceRecord record = {};
+        record.timestampNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+        record.vector = reinterpret_cast<uintptr_t>(vector);
+        record.first = first;
+        record.count = count;
+        record.operation = operation;
+        m_buffer.push_back(record);
+        m_recordCount.fetch_add(1, std::memory_order_relaxed);
+
+        if (m_buffer.size() == BufferRecords)
+        {
+            Flush();
+        }
+    }
+
+    void Flush() noexcept
+    {
+        if (!m_buffer.empty() && !detail::WriteTraceBytes(m_file, m_buffer.data(), m_buffer.size() * sizeof(TraceRecord)))
+        {
+            m_hasFailed = true;
+        }
+        m_buffer.clear();
+    }
+
+    bool StopRecording() noexcept
+    {
+        TraceRecorder* expected = this;
+        if (GetActiveRecorder().compare_exchange_strong(expected, nullptr))
+        {
+            GetOperationTraceSink().store(nullptr, std::memory_order_release);
+        }
+
+        std::lock_guard lock(m_mutex); // waits for records in flight
+        Flush();
+        return !m_hasFailed;
+    }
+
+private:
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    std::chrono::steady_clock::time_point m_start;
+    std::vector<TraceRecord> m_buffer;
+    std::atomic<uint64_t> m_recordCount = 0;
+    bool m_hasFailed = false;
+    std::mutex m_mutex;
+};
+
+
+// Reads the whole trace, throws std::runtime_error if the file is not a trace
+[[nodiscard]] inline std::vector<TraceRecord> LoadTrace(const std::filesystem::path& path)
+{
+#if WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error{ "Failed to open the trace file" };
+    }
+
+    auto readAll = [file](void* destination, const size_t bytes)
+    {
+        size_t read = 0;
+        while (read < bytes)
+        {
+            DWORD chunk = 0;
+            const DWORD toRead = static_cast<DWORD>(std::min<size_t>(bytes - read, 1u << 30));
+            if (!ReadFile(file, static_cast<char*>(destination) + read, toRead, &chunk, nullptr) || chunk == 0)
+            {
+                return false;
+            }
+            read += chunk;
+        }
+        return true;
+    };
+
+    std::vector<TraceRecord> records;
+    TraceFileHeader header = {};
+    bool isValid = readAll(&header, sizeof(header)) && header.magic == TraceMagic && header.version == TraceFormatVersion
+        && header.recordSize == sizeof(TraceRecord);
+    if (isValid)
+    {
+        LARGE_INTEGER fileSize = {};
+        isValid = GetFileSizeEx(file, &fileSize) != 0;
+        if (isValid)
+        {
+            records.resize((static_cast<size_t>(fileSize.QuadPart) - sizeof(header)) / sizeof(TraceRecord));
+            isValid = readAll(records.data(), records.size() * sizeof(TraceRecord));
+        }
+    }
+    CloseHandle(file);
+
+    if (!isValid)
+    {
+        throw std::runtime_error{ "File is not an operation trace" };
+    }
+    return records;
+#else
+#error Not implemented
+#endif
+}
+
+} // namespace ds end
@@ -0,0 +1,343 @@
+#pragma once
+
+// Read-only vector which elements are computed on first touch, for huge derived tables (precomputed hashes etc.)
+// where only a fraction of entries is ever read. Construction is O(1), memory is proportional to touched chunks.
+//
+// Address range is reserved as a placeholder and nothing is mapped there. The first access to a chunk faults
+// (see PageFaultRouter), the chunk is filled by the callback through a second, writable view of the same
+// pagefile-backed section and only then mapped read-only into the placeholder. So other threads never see
+// a partially filled chunk: they either fault and wait for the fill or see the final data.
+// Chunk is the allocation granularity (64KB), the smallest piece a view can be mapped with.
+//
+// Fill callback:
+// - gets the destination, index of the first element and amount of elements, it must construct all of them;
+// - runs inside exception dispatch under the vector lock, so it must not throw and must not touch this vector;
+// - must be a pure function of the index: elements crossing a chunk border are filled with the first chunk.
+//
+// Requires Windows 10 1803+ for placeholders (VirtualAlloc2 + MapViewOfFile3).
+
+#include "PersistentGrowingVectorVM.h"
+#include "PageFaultRouter.h"
+#include "GrowingBitVectorVM.h"
+
+#include <functional>                   // for std::function
+#include <mutex>
+#include <type_traits>
+
+
+namespace ds
+{
+
+template <typename T, typename ReservePolicy = RAMSizePolicyTag>
+class LazyGrowingVectorVM
+{
+public:
+    static_assert(std::is_trivially_destructible_v<T>, "Chunks are dropped without running destructors");
+
+    using value_type = T;
+    using const_pointer = const T*;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using const_iterator = const T*;
+    using FillFunction = std::function<void(T* destination, size_type firstIndex, size_type count)>;
+
+    static constexpr size_t ChunkBytes = DS_KB(64);    // views have to start at allocation granularity
+
+    LazyGrowingVectorVM(const size_type size, FillFunction fill)
+        : m_fill(std::move(fill))
+        , m_pageSize(PlatformHelper::CalculateVirtualPageSize(false))
+    {
+        m_reservedBytes = CalculateAlignedSize(CalculateReserveBytesForPolicy<ReservePolicy>(), ChunkBytes);
+        if (size > GetReserve())
+        {
+            throw std::bad_alloc{};
+        }
+
+        m_section = CreateReservedSection(m_reservedBytes);
+        if (m_section == nullptr)
+        {
+            FileMappingHelper::ThrowLastError("Failed to create the section");
+        }
+        m_fillView = static_cast<std::byte*>(MapFillView(m_section, m_reservedBytes));
+        m_base = static_cast<std::byte*>(FileMappingHelper::ReservePlaceholder(m_reservedBytes));
+        if (m_fillView == nullptr || m_base == nullptr)
+        {
+            ReleaseResources();
+            FileMappingHelper::ThrowLastError("Failed to reserve the address range");
+        }
+
+        try
+        {
+            m_chunks.Resize(m_reservedBytes / ChunkBytes, false);
+            m_chunks.BuildRankIndex(); // sized once here, later builds don't allocate
+            PageFaultRouter::GetInstance().Register(m_base, m_reservedBytes, &LazyGrowingVectorVM::HandleFault, this);
+        }
+        catch (...)
+        {
+            ReleaseResources();
+            throw;
+        }
+        m_size = size;
+    }
+
+    ~LazyGrowingVectorVM() noexcept
+    {
+        PageFaultRouter::GetInstance().Unregister(m_base);
+        ReleaseResources();
+    }
+
+    // Fault handler keeps the pointer to this object, so it can't be moved
+    LazyGrowingVectorVM(const LazyGrowingVectorVM&) = delete;
+    LazyGrowingVectorVM& operator=(const LazyGrowingVectorVM&) = delete;
+
+    [[nodiscard]] inline size_type GetSize() const noexcept { return m_size; }
+    [[nodiscard]] inline bool Empty() const noexcept { return GetSize() == 0; }
+    [[nodiscard]] inline size_type GetReserve() const noexcept { return m_reservedBytes / sizeof(T); }
+    [[nodiscard]] inline size_type GetMaterializedChunkCount() const noexcept { return m_materializedChunks; }
+    [[nodiscard]] inline size_type GetMaterializedBytes() const noexcept { return m_materializedChunks * ChunkBytes; }
+
+    [[nodiscard]] inline const_pointer GetData() const noexcept { return reinterpret_cast<const_pointer>(m_base); }
+
+    [[nodiscard]] inline const_reference operator[](const size_type index) const noexcept
+    {
+        assert(index < GetSize());
+        return GetData()[index];
+    }
+
+    [[nodiscard]] const_reference At(const size_type index) const
+    {
+        if (index >= GetSize())
+        {
+            throw std::out_of_range{ "Index is out of range" };
+        }
+        return GetData()[index];
+    }
+
+    [[nodiscard]] inline const_iterator Begin() const noexcept { return GetData(); }
+    [[nodiscard]] inline const_iterator End() const noexcept { return GetData() + GetSize(); }
+
+    // Materialized memory is kept on shrink, new elements in already materialized chunks are filled right away
+    // (chunks materialized before a shrink were filled only up to the size of that time)
+    void Resize(const size_type newSize)
+    {
+        if (newSize > GetReserve())
+        {
+            // No extend mechanism is pre-designed, so that's strict limitation for end user.
+            throw std::bad_alloc{};
+        }
+
+        std::lock_guard lock(m_mutex);
+        if (newSize > m_size)
+        {
+            FillMaterializedChunks(m_size, newSize);
+        }
+        m_size = newSize;
+    }
+
+private:
+    static bool HandleFault(void* context, void* address, const bool isWrite)
+    {
+        // chunks are read-only, writing is a bug of the caller
+        return !isWrite && static_cast<LazyGrowingVectorVM*>(context)->Materialize(static_cast<const std::byte*>(address));
+    }
+
+    bool Materialize(const std::byte* address)
+    {
+        std::lock_guard lock(m_mutex);
+        const size_t chunk = static_cast<size_t>(address - m_base) / ChunkBytes;
+        if (m_chunks.Test(chunk))
+        {
+            return true; // materialized by another thread
+        }
+        if (chunk * ChunkBytes >= m_size * sizeof(T))
+        {
+            return false; // beyond the size, a real access violation
+        }
+
+        // elements intersecting the chunk, except the ones crossing the border with materialized neighbor
+        const size_t chunkBegin = chunk * ChunkBytes;
+        const size_t chunkEnd = chunkBegin + ChunkBytes;
+        size_t first = chunkBegin / sizeof(T);
+        size_t last = std::min(m_size, (chunkEnd + sizeof(T) - 1) / sizeof(T));
+        if (first * sizeof(T) < chunkBegin && m_chunks.Test(chunk - 1))
+        {
+            first++;
+        }
+        if (last * sizeof(T) > chunkEnd && chunk + 1 < m_chunks.GetSize() && m_chunks.Test(chunk + 1))
+        {
+            last--;
+        }
+
+        try
+        {
+            CommitFillRange(chunkBegin, ChunkBytes);
+            if (first < last)
+            {
+                Fill(first, last);
+            }
+            if (!MapChunk(chunk))
+            {
+                return false;
+            }
+        }
+        catch (...)
+        {
+            return false; // can't throw from the exception dispatch, let it crash as an access violation
+        }
+
+        m_chunks.Set(chunk);
+        m_chunks.BuildRankIndex();
+        m_materializedChunks++;
+        return true;
+    }
+
+    // Fills elements of [first, last) which intersect materialized chunks, the rest is filled on first touch
+    void FillMaterializedChunks(const size_t first, const size_t last)
+    {
+        const size_t endChunk = (last * sizeof(T) - 1) / ChunkBytes + 1;
+        size_t chunk = m_chunks.Select(m_chunks.Rank(first * sizeof(T) / ChunkBytes));
+        for (; chunk < endChunk; chunk = m_chunks.Select(m_chunks.Rank(chunk + 1)))
+        {
+            const size_t chunkBegin = chunk * ChunkBytes;
+            Fill(std::max(first, chunkBegin / sizeof(T)), std::min(last, (chunkBegin + ChunkBytes + sizeof(T) - 1) / sizeof(T)));
+        }
+    }
+
+    void Fill(const size_t first, const size_t last)
+    {
+        CommitFillRange(first * sizeof(T), (last - first) * sizeof(T));
+        m_fill(reinterpret_cast<T*>(m_fillView + first * sizeof(T)), first, last - first);
+    }
+
+    void CommitFillRange(const size_t offset, const size_t bytes)
+    {
+        const size_t firstByte = offset / m_pageSize * m_pageSize;
+        void* address = m_fillView + firstByte;
+        if (PlatformHelper::CommitVirtualMemory(address, CalculateAlignedSize(offset + bytes, m_pageSize) - firstByte) == nullptr)
+        {
+            throw std::bad_alloc{};
+        }
+    }
+
+    // Cuts the chunk out of the placeholder which contains it and maps it there
+    bool MapChunk(const size_t chunk)
+    {
+        // placeholder spans between the closest materialized chunks
+        const size_t rank = m_chunks.Rank(chunk);
+        const size_t placeholderBegin = rank == 0 ? 0 : m_chunks.Select(rank - 1) + 1;
+        const size_t placeholderEnd = m_chunks.Select(rank);
+
+        if (placeholderBegin < chunk && !SplitPlaceholder(placeholderBegin, chunk - placeholderBegin))
+        {
+            return false;
+        }
+        if (chunk + 1 < placeholderEnd && !SplitPlaceholder(chunk, 1))
+        {
+            return false;
+        }
+        return MapSectionRange(m_section, m_base + chunk * ChunkBytes, chunk * ChunkBytes, ChunkBytes) != nullptr;
+    }
+
+    bool SplitPlaceholder(const size_t firstChunk, const size_t chunkCount)
+    {
+#if WIN32
+        return VirtualFree(m_base + firstChunk * ChunkBytes, chunkCount * ChunkBytes, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER);
+#else
+#error Not implemented
+#endif
+    }
+
+    void ReleaseResources() noexcept
+    {
+        if (m_base != nullptr)
+        {
+            // every materialized chunk is a view, every run of others is a placeholder
+            for (size_t chunk = 0; chunk < m_chunks.GetSize(); )
+            {
+                if (m_chunks.Test(chunk))
+                {
+                    FileMappingHelper::UnmapView(m_base + chunk * ChunkBytes);
+                    chunk++;
+                    continue;
+                }
+                FileMappingHelper::ReleasePlaceholder(m_base + chunk * ChunkBytes);
+                while (chunk < m_chunks.GetSize() && !m_chunks.Test(chunk))
+                {
+                    chunk++;
+                }
+            }
+            if (m_chunks.Empty())
+            {
+                FileMappingHelper::ReleasePlaceholder(m_base);
+            }
+            m_base = nullptr;
+        }
+        if (m_fillView != nullptr)
+        {
+            FileMappingHelper::UnmapView(m_fillView);
+            m_fillView = nullptr;
+        }
+        if (m_section != nullptr)
+        {
+            CloseSection(m_section);
+            m_section = nullptr;
+        }
+    }
+
+    // Pagefile-backed section, its pages are committed (charged) only when committed through a view
+    [[nodiscard]] static HANDLE CreateReservedSection(const size_t bytes)
+    {
+#if WIN32
+        return CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE | SEC_RESERVE,
+            static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32), static_cast<DWORD>(bytes), nullptr);
+#else
+#error Not implemented
+#endif
+    }
+
+    [[nodiscard]] static void* MapFillView(HANDLE section, const size_t bytes)
+    {
+#if WIN32
+        return MapViewOfFile(section, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+#else
+#error Not implemented
+#endif
+    }
+
+    [[nodiscard]] static void* MapSectionRange(HANDLE section, void* placeholder, const size_t offset, const size_t bytes)
+    {
+#if WIN32
+        return MapViewOfFile3(section, GetCurrentProcess(), placeholder, offset, bytes, MEM_REPLACE_PLACEHOLDER, PAGE_READONLY, nullptr, 0);
+#else
+#error Not implemented
+#endif
+    }
+
+    static void CloseSection(HANDLE section)
+    {
+#if WIN32
+        CloseHandle(section);
+#else
+#error Not implemented
+#endif
+    }
+
+    [[nodiscard]] static constexpr size_t CalculateAlignedSize(const size_t bytes, const size_t alignment) noexcept
+    {
+        return (bytes + alignment - 1) / alignment * alignment;
+    }
+
+private:
+    FillFunction m_fill;
+    size_t m_pageSize;
+    HANDLE m_section = nullptr;
+    std::byte* m_fillView = nullptr;                // writable view of the whole section, never exposed
+    std::byte* m_base = nullptr;                    // placeholder with read-only views of materialized chunks
+    size_t m_reservedBytes = 0;
+    size_t m_size = 0;
+    size_t m_materializedChunks = 0;
+    GrowingBitVectorVM<ReservePolicy> m_chunks;     // materialized chunks
+    std::mutex m_mutex;                             // shared by fault handler and Resize()
+};
+
+} // namespace ds end
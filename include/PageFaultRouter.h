@@ -0,0 +1,174 @@
+#pragma once
+
+// Process-wide dispatcher of access violations to the owners of protected memory ranges.
+// Features which protect pages of a vector with VirtualProtect and react on the first access (background snapshot,
+// dirty tracking, lazy pages) share one vectored exception handler through this router.
+//
+// Caveats:
+// - Handlers run on the faulting thread inside exception dispatch, so they have to be short and must not fault themselves.
+// - Accesses done by the kernel (e.g. ReadFile into a protected buffer) don't raise exceptions, they fail with ERROR_NOACCESS.
+// - Ranges can't overlap, so one vector can be used by one such feature at a time.
+// - A fault can be dispatched after the owner unprotected the page and unregistered the range (the page was protected
+//   when the instruction faulted), such an access is retried when the page allows it by now.
+
+#include "GrowingVectorVM.h"
+
+#include <shared_mutex>                 // for std::shared_mutex
+#include <mutex>                        // for std::unique_lock
+#include <vector>
+
+
+namespace ds
+{
+
+class PageFaultRouter
+{
+public:
+    // Returns true if the fault is resolved and the faulting instruction has to be retried
+    using Handler = bool (*)(void* context, void* address, bool isWrite);
+
+    [[nodiscard]] static PageFaultRouter& GetInstance()
+    {
+        static PageFaultRouter router;
+        return router;
+    }
+
+    // Throws std::logic_error if the range intersects already registered one
+    void Register(const void* begin, const size_t bytes, Handler handler, void* context)
+    {
+        const uintptr_t first = reinterpret_cast<uintptr_t>(begin);
+        const uintptr_t last = first + bytes;
+
+        std::unique_lock lock(m_mutex);
+        for (const Range& range : m_ranges)
+        {
+            if (first < range.end && range.begin < last)
+            {
+                throw std::logic_error{ "Memory range is already tracked by another page fault handler" };
+            }
+        }
+
+        if (m_handlerHandle == nullptr)
+        {
+            m_handlerHandle = InstallHandler();
+            if (m_handlerHandle == nullptr)
+            {
+                throw std::bad_alloc{};
+            }
+        }
+        m_ranges.push_back({ first, last, handler, context });
+    }
+
+    // Waits for handlers which are running for this range at the moment
+    void Unregister(const void* begin) noexcept
+    {
+        std::unique_lock lock(m_mutex);
+        for (size_t i = 0; i < m_ranges.size(); i++)
+        {
+            if (m_ranges[i].begin == reinterpret_cast<uintptr_t>(begin))
+            {
+                m_ranges.erase(m_ranges.begin() + i);
+                return;
+            }
+        }
+    }
+
+private:
+    struct Range
+    {
+        uintptr_t begin;
+        uintptr_t end;
+        Handler handler;
+        void* context;
+    };
+
+    PageFaultRouter() = default;
+    ~PageFaultRouter()
+    {
+        if (m_handlerHandle != nullptr)
+        {
+            RemoveHandler(m_handlerHandle);
+        }
+    }
+
+    // Handler is called under the shared lock, so Unregister can't complete while it works with the context
+    [[nodiscard]] bool Dispatch(void* address, const bool isWrite)
+    {
+        const uintptr_t faultAddress = reinterpret_cast<uintptr_t>(address);
+
+        {
+            std::shared_lock lock(m_mutex);
+            for (const Range& range : m_ranges)
+            {
+                if (range.begin <= faultAddress && faultAddress < range.end && range.handler(range.context, address, isWrite))
+                {
+                    return true;
+                }
+            }
+        }
+        return IsAccessAllowed(address, isWrite);
+    }
+
+    // Protection of the page at the moment, not at the moment of the fault
+    [[nodiscard]] static bool IsAccessAllowed(const void* address, const bool isWrite) noexcept
+    {
+#if WIN32
+        MEMORY_BASIC_INFORMATION info = {};
+        if (VirtualQuery(address, &info, sizeof(info)) != sizeof(info) || info.State != MEM_COMMIT || (info.Protect & PAGE_GUARD) != 0)
+        {
+            return false;
+        }
+
+        const DWORD writable = PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+        const DWORD readable = writable | PAGE_READONLY | PAGE_EXECUTE_READ;
+        return (info.Protect & (isWrite ? writable : readable)) != 0;
+#else
+#error Not implemented
+#endif
+    }
+
+#if WIN32
+    static LONG CALLBACK HandleException(PEXCEPTION_POINTERS info)
+    {
+        const EXCEPTION_RECORD* record = info->ExceptionRecord;
+        if (record->ExceptionCode != EXCEPTION_ACCESS_VIOLATION || record->NumberParameters < 2)
+        {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+
+        // ExceptionInformation[0]: 0 - read, 1 - write, 8 - execute (nobody protects code)
+        if (record->ExceptionInformation[0] != 0 && record->ExceptionInformation[0] != 1)
+        {
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+        const bool isWrite = record->ExceptionInformation[0] == 1;
+        void* address = reinterpret_cast<void*>(record->ExceptionInformation[1]);
+        return GetInstance().Dispatch(address, isWrite) ? EXCEPTION_CONTINUE_EXECUTION : EXCEPTION_CONTINUE_SEARCH;
+    }
+#endif
+
+    [[nodiscard]] static void* InstallHandler()
+    {
+#if WIN32
+        return AddVectoredExceptionHandler(1 /*call first*/, &PageFaultRouter::HandleException);
+#else
+#error Not implemented
+#endif
+    }
+
+    static void RemoveHandler(void* handle)
+    {
+#if WIN32
+        RemoveVectoredExceptionHandler(handle);
+#else
+#error Not implemented
+#endif
+    }
+
+private:
+    std::shared_mutex m_mutex;
+    std::vector<Range> m_ranges;
+    void* m_handlerHandle = nullptr;
+};
+
+} // namespace ds end
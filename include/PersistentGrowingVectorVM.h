@@ -0,0 +1,612 @@
+#pragma once
+
+// File-backed variant of GrowingVectorVM for trivially copyable types.
+// Address range is reserved once (as a placeholder), then the file is extended and mapped into that range
+// chunk by chunk while the vector grows, so data never moves and pointers stay valid, same as in GrowingVectorVM.
+// Reopening the file maps it back and the data is usable immediately - no parsing, no copying.
+//
+// File layout: HeaderBytes of header (format, element size/alignment, type tag, size) and then raw elements.
+// Size lives in the mapped header, so Flush() is enough for a durability point. On close the file is truncated
+// to the used size (while opened it's bigger because of chunked growth).
+//
+// Requires Windows 10 1803+ for placeholders (VirtualAlloc2 + MapViewOfFile3).
+
+#include "GrowingVectorVM.h"
+
+#include <filesystem>                   // for std::filesystem::path
+#include <system_error>                 // for std::system_error
+#include <type_traits>
+#include <algorithm>                    // for std::max, std::fill
+
+#pragma comment(lib, "onecore.lib")     // for VirtualAlloc2, MapViewOfFile3
+
+
+namespace ds
+{
+
+struct PersistentFileHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t headerBytes;
+    uint64_t elementSize;
+    uint64_t elementAlignment;
+    uint64_t typeTag;
+    uint64_t size;              // amount of elements
+};
+
+// FNV-1a of the function signature which contains the full type name. It's stable for the same compiler
+// and good enough to catch opening a file with a wrong type, but it's not a portable format identifier.
+template <typename T>
+[[nodiscard]] constexpr uint64_t MakeTypeTag() noexcept
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const char* c = __FUNCSIG__; *c != '\0'; ++c)
+    {
+        hash ^= static_cast<uint8_t>(*c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Specialize it to have own stable tag for the type (e.g. when files are shared between different builds)
+template <typename T>
+struct PersistentTypeTag
+{
+    static constexpr uint64_t value = MakeTypeTag<T>();
+};
+
+
+struct FileMappingHelper
+{
+    [[noreturn]] static void ThrowLastError(const char* message)
+    {
+#if WIN32
+        throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), message);
+#else
+#error Not implemented
+#endif
+    }
+
+    // Unbuffered files bypass the file cache: buffers, offsets and sizes of reads/writes must be sector aligned
+    [[nodiscard]] static HANDLE OpenFile(const std::filesystem::path& path, const bool create, const bool unbuffered = false)
+    {
+#if WIN32
+        HANDLE file = CreateFileW(
+            path.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ,                        // the only writer is us
+            nullptr,
+            create ? CREATE_ALWAYS : OPEN_EXISTING,
+            unbuffered ? FILE_FLAG_NO_BUFFERING : FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            ThrowLastError("CreateFileW failed");
+        }
+        return file;
+#else
+#error Not implemented
+#endif
+    }
+
+    [[nodiscard]] static size_t GetFileSize(HANDLE file)
+    {
+#if WIN32
+        LARGE_INTEGER size = {};
+        if (!GetFileSizeEx(file, &size))
+        {
+            ThrowLastError("GetFileSizeEx failed");
+        }
+        return static_cast<size_t>(size.QuadPart);
+#else
+#error Not implemented
+#endif
+    }
+
+    static bool SetFileSize(HANDLE file, const size_t bytes)
+    {
+#if WIN32
+        LARGE_INTEGER position = {};
+        position.QuadPart = static_cast<LONGLONG>(bytes);
+        return SetFilePointerEx(file, position, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+#else
+#error Not implemented
+#endif
+    }
+
+    [[nodiscard]] static void* ReservePlaceholder(const size_t bytes)
+    {
+#if WIN32
+        return VirtualAlloc2(nullptr, nullptr, bytes, MEM_RESERVE | MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS, nullptr, 0);
+#else
+#error Not implemented
+#endif
+    }
+
+    // Maps [fileOffset, fileOffset + bytes) of the file at address, which has to be the start of a placeholder.
+    // Placeholder is split first if it's bigger than the view. On failure the placeholder is left as it was.
+    [[nodiscard]] static void* MapFileRange(HANDLE file, void* address, const size_t fileOffset, const size_t bytes, const size_t placeholderBytes)
+    {
+#if WIN32
+        const bool split = bytes < placeholderBytes;
+        if (split && !VirtualFree(address, bytes, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER))
+        {
+            return nullptr;
+        }
+
+        // section object is needed only to create the view, the view keeps it alive
+        HANDLE section = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        void* view = nullptr;
+        if (section != nullptr)
+        {
+            view = MapViewOfFile3(section, GetCurrentProcess(), address, fileOffset, bytes, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0);
+            const DWORD error = GetLastError();
+            CloseHandle(section);
+            SetLastError(error);
+        }
+
+        if (view == nullptr && split)
+        {
+            // the split placeholders are joined back, so the owner still releases (or maps) a single one
+            const DWORD error = GetLastError();
+            VirtualFree(address, placeholderBytes, MEM_RELEASE | MEM_COALESCE_PLACEHOLDERS);
+            SetLastError(error);
+        }
+        return view;
+#else
+#error Not implemented
+#endif
+    }
+
+    static void UnmapView(void* view)
+    {
+#if WIN32
+        UnmapViewOfFile(view);
+#else
+#error Not implemented
+#endif
+    }
+
+    static void ReleasePlaceholder(void* address)
+    {
+#if WIN32
+        VirtualFree(address, 0, MEM_RELEASE);
+#else
+#error Not implemented
+#endif
+    }
+
+    static bool FlushView(const void* address, const size_t bytes)
+    {
+#if WIN32
+        return FlushViewOfFile(address, bytes);
+#else
+#error Not implemented
+#endif
+    }
+
+    static bool FlushFile(HANDLE file)
+    {
+#if WIN32
+        return FlushFileBuffers(file);
+#else
+#error Not implemented
+#endif
+    }
+
+    // WriteFile takes DWORD size, so big buffers are written in pieces
+    static void WriteAll(HANDLE file, const void* data, size_t bytes)
+    {
+#if WIN32
+        const char* current = static_cast<const char*>(data);
+        while (bytes > 0)
+        {
+            const DWORD chunk = static_cast<DWORD>(std::min(bytes, DS_GB(1)));
+            DWORD written = 0;
+            if (!WriteFile(file, current, chunk, &written, nullptr) || written == 0)
+            {
+                ThrowLastError("WriteFile failed");
+            }
+            current += written;
+            bytes -= written;
+        }
+#else
+#error Not implemented
+#endif
+    }
+
+    // Reads until bytes are read or the file ends, returns amount of read bytes
+    static size_t ReadUpTo(HANDLE file, void* data, const size_t bytes)
+    {
+#if WIN32
+        char* current = static_cast<char*>(data);
+        size_t left = bytes;
+        while (left > 0)
+        {
+            const DWORD chunk = static_cast<DWORD>(std::min(left, DS_GB(1)));
+            DWORD read = 0;
+            if (!ReadFile(file, current, chunk, &read, nullptr))
+            {
+                ThrowLastError("ReadFile failed");
+            }
+            if (read == 0)
+            {
+                break;
+            }
+            current += read;
+            left -= read;
+        }
+        return bytes - left;
+#else
+#error Not implemented
+#endif
+    }
+
+    // Throws std::runtime_error if the file ends earlier
+    static void ReadAll(HANDLE file, void* data, const size_t bytes)
+    {
+        if (ReadUpTo(file, data, bytes) != bytes)
+        {
+            throw std::runtime_error{ "Unexpected end of file" };
+        }
+    }
+
+    static void SetFilePosition(HANDLE file, const size_t offset)
+    {
+#if WIN32
+        LARGE_INTEGER position = {};
+        position.QuadPart = static_cast<LONGLONG>(offset);
+        if (!SetFilePointerEx(file, position, nullptr, FILE_BEGIN))
+        {
+            ThrowLastError("SetFilePointerEx failed");
+        }
+#else
+#error Not implemented
+#endif
+    }
+
+    [[nodiscard]] static size_t GetFilePosition(HANDLE file)
+    {
+#if WIN32
+        LARGE_INTEGER position = {};
+        if (!SetFilePointerEx(file, LARGE_INTEGER{}, &position, FILE_CURRENT))
+        {
+            ThrowLastError("SetFilePointerEx failed");
+        }
+        return static_cast<size_t>(position.QuadPart);
+#else
+#error Not implemented
+#endif
+    }
+
+    static void CloseFile(HANDLE file)
+    {
+#if WIN32
+        CloseHandle(file);
+#else
+#error Not implemented
+#endif
+    }
+};
+
+
+template <typename T, typename ReservePolicy = RAMSizePolicyTag>
+class PersistentGrowingVectorVM
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be stored in a file as is");
+
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    constexpr static size_t ElementSize = sizeof(T);
+    static constexpr uint64_t Magic = 0x4D5656474E574F52ull;   // "ROWNGVVM"
+    static constexpr uint32_t FormatVersion = 1;
+    static constexpr size_t HeaderBytes = 4096;                 // keeps data page aligned
+    static constexpr size_t MappingGranularity = DS_KB(64);     // views have to start at allocation granularity
+    static constexpr size_t MinChunkBytes = DS_MB(1);
+    static constexpr size_t MaxViews = 64;                      // chunks grow geometrically, 64 is more than enough
+
+    static_assert(alignof(T) <= HeaderBytes);
+    static_assert(sizeof(PersistentFileHeader) <= HeaderBytes);
+
+    // Creates new file (existing one is overwritten)
+    [[nodiscard]] static PersistentGrowingVectorVM Create(const std::filesystem::path& path)
+    {
+        return PersistentGrowingVectorVM(path, true);
+    }
+
+    // Maps existing file, throws std::runtime_error if it was written for other type or in other format
+    [[nodiscard]] static PersistentGrowingVectorVM Open(const std::filesystem::path& path)
+    {
+        return PersistentGrowingVectorVM(path, false);
+    }
+
+    ~PersistentGrowingVectorVM() noexcept
+    {
+        Close();
+    }
+
+    PersistentGrowingVectorVM(PersistentGrowingVectorVM&& other) noexcept
+        : m_file(std::exchange(other.m_file, INVALID_HANDLE_VALUE))
+        , m_base(std::exchange(other.m_base, nullptr))
+        , m_reservedBytes(std::exchange(other.m_reservedBytes, 0))
+        , m_mappedBytes(std::exchange(other.m_mappedBytes, 0))
+        , m_viewCount(std::exchange(other.m_viewCount, 0))
+    {
+        std::copy(other.m_views, other.m_views + m_viewCount, m_views);
+    }
+
+    PersistentGrowingVectorVM(const PersistentGrowingVectorVM&) = delete;
+    PersistentGrowingVectorVM& operator=(const PersistentGrowingVectorVM&) = delete;
+    PersistentGrowingVectorVM& operator=(PersistentGrowingVectorVM&&) = delete;
+
+    [[nodiscard]] inline bool IsOpen() const noexcept { return m_base != nullptr; }
+    [[nodiscard]] inline size_type GetSize() const noexcept { return IsOpen() ? static_cast<size_type>(GetHeader()->size) : 0; }
+    [[nodiscard]] inline bool Empty() const noexcept { return GetSize() == 0; }
+    [[nodiscard]] inline size_type GetCapacity() const noexcept { return m_mappedBytes > HeaderBytes ? (m_mappedBytes - HeaderBytes) / ElementSize : 0; }
+    [[nodiscard]] inline size_type GetReserve() const noexcept { return (m_reservedBytes - HeaderBytes) / ElementSize; }
+
+    [[nodiscard]] inline pointer GetData() noexcept { return reinterpret_cast<pointer>(m_base + HeaderBytes); }
+    [[nodiscard]] inline const_pointer GetData() const noexcept { return reinterpret_cast<const_pointer>(m_base + HeaderBytes); }
+
+    [[nodiscard]] inline reference operator[](const size_type index) noexcept
+    {
+        assert(index < GetSize());
+        return GetData()[index];
+    }
+    [[nodiscard]] inline const_reference operator[](const size_type index) const noexcept
+    {
+        assert(index < GetSize());
+        return GetData()[index];
+    }
+
+    [[nodiscard]] reference At(const size_type index)
+    {
+        if (index >= GetSize())
+        {
+            throw std::out_of_range{ "Index is out of range" };
+        }
+        return GetData()[index];
+    }
+    [[nodiscard]] const_reference At(const size_type index) const
+    {
+        return const_cast<PersistentGrowingVectorVM*>(this)->At(index);
+    }
+
+    [[nodiscard]] inline reference Front() { return this->operator[](0); }
+    [[nodiscard]] inline const_reference Front() const { return this->operator[](0); }
+    [[nodiscard]] inline reference Back() { return this->operator[](GetSize() - 1); }
+    [[nodiscard]] inline const_reference Back() const { return this->operator[](GetSize() - 1); }
+
+    [[nodiscard]] inline iterator Begin() noexcept { return GetData(); }
+    [[nodiscard]] inline const_iterator Begin() const noexcept { return GetData(); }
+    [[nodiscard]] inline iterator End() noexcept { return GetData() + GetSize(); }
+    [[nodiscard]] inline const_iterator End() const noexcept { return GetData() + GetSize(); }
+    [[nodiscard]] inline const_iterator CBegin() const noexcept { return GetData(); }
+    [[nodiscard]] inline const_iterator CEnd() const noexcept { return GetData() + GetSize(); }
+
+    void PushBack(const T& value)
+    {
+        const size_type size = GetSize();
+        EnsureMappedBytes(HeaderBytes + (size + 1) * ElementSize); // can throw
+        GetData()[size] = value;
+        GetHeader()->size = size + 1;
+    }
+
+    template <typename... Args>
+    reference EmplaceBack(Args&&... args)
+    {
+        PushBack(T(std::forward<Args>(args)...));
+        return Back();
+    }
+
+    void PopBack()
+    {
+        assert(!Empty());
+        GetHeader()->size -= 1;
+    }
+
+    void Resize(const size_type newSize, const T& value = T{})
+    {
+        const size_type size = GetSize();
+        if (newSize > size)
+        {
+            EnsureMappedBytes(HeaderBytes + newSize * ElementSize); // can throw
+            std::fill(GetData() + size, GetData() + newSize, value);
+        }
+        GetHeader()->size = newSize;
+    }
+
+    void Clear() noexcept
+    {
+        if (IsOpen())
+        {
+            GetHeader()->size = 0;
+        }
+    }
+
+    // Durability point: everything written before the call (including size) is on disk after it
+    void Flush()
+    {
+        const size_t usedBytes = HeaderBytes + GetSize() * ElementSize;
+        size_t flushed = 0;
+        for (size_t i = 0; i < m_viewCount && flushed < usedBytes; i++)
+        {
+            const size_t bytes = std::min(m_views[i].bytes, usedBytes - flushed);
+            if (!FileMappingHelper::FlushView(m_views[i].address, bytes))
+            {
+                FileMappingHelper::ThrowLastError("FlushViewOfFile failed");
+            }
+            flushed += m_views[i].bytes;
+        }
+
+        if (!FileMappingHelper::FlushFile(m_file))
+        {
+            FileMappingHelper::ThrowLastError("FlushFileBuffers failed");
+        }
+    }
+
+    // Unmaps the data and truncates the file to the used size. Called by destructor.
+    void Close() noexcept
+    {
+        if (!IsOpen())
+        {
+            return;
+        }
+
+        const size_t usedBytes = HeaderBytes + GetSize() * ElementSize;
+        for (size_t i = 0; i < m_viewCount; i++)
+        {
+            FileMappingHelper::UnmapView(m_views[i].address);
+        }
+        if (m_mappedBytes < m_reservedBytes)
+        {
+            FileMappingHelper::ReleasePlaceholder(m_base + m_mappedBytes);
+        }
+
+        // file can't be truncated while mapped, so do it now, failure just leaves the file bigger
+        FileMappingHelper::SetFileSize(m_file, usedBytes);
+        FileMappingHelper::CloseFile(m_file);
+
+        m_file = INVALID_HANDLE_VALUE;
+        m_base = nullptr;
+        m_mappedBytes = 0;
+        m_reservedBytes = 0;
+        m_viewCount = 0;
+    }
+
+private:
+    struct View
+    {
+        char* address;
+        size_t bytes;
+    };
+
+    PersistentGrowingVectorVM(const std::filesystem::path& path, const bool create)
+    {
+        m_file = FileMappingHelper::OpenFile(path, create);
+
+        size_t fileBytes = HeaderBytes;
+        if (!create)
+        {
+            fileBytes = FileMappingHelper::GetFileSize(m_file);
+            if (fileBytes < HeaderBytes)
+            {
+                FileMappingHelper::CloseFile(m_file);
+                throw std::runtime_error{ "File is too small to be a persistent vector" };
+            }
+        }
+
+        m_reservedBytes = CalculateAlignedSize(HeaderBytes + CalculateReserveBytesForPolicy<ReservePolicy>(), MappingGranularity);
+        m_base = static_cast<char*>(FileMappingHelper::ReservePlaceholder(m_reservedBytes));
+        if (m_base == nullptr)
+        {
+            FileMappingHelper::CloseFile(m_file);
+            throw std::bad_alloc{};
+        }
+
+        try
+        {
+            EnsureMappedBytes(fileBytes);
+
+            PersistentFileHeader* header = GetHeader();
+            if (create)
+            {
+                *header = { Magic, FormatVersion, HeaderBytes, ElementSize, alignof(T), PersistentTypeTag<T>::value, 0 };
+            }
+            else
+            {
+                ValidateHeader(*header, fileBytes);
+            }
+        }
+        catch (...)
+        {
+            // don't truncate a file which wasn't ours
+            for (size_t i = 0; i < m_viewCount; i++)
+            {
+                FileMappingHelper::UnmapView(m_views[i].address);
+            }
+            if (m_mappedBytes < m_reservedBytes)
+            {
+                FileMappingHelper::ReleasePlaceholder(m_base + m_mappedBytes);
+            }
+            FileMappingHelper::CloseFile(m_file);
+            throw;
+        }
+    }
+
+    static void ValidateHeader(const PersistentFileHeader& header, const size_t fileBytes)
+    {
+        if (header.magic != Magic || header.version != FormatVersion || header.headerBytes != HeaderBytes)
+        {
+            throw std::runtime_error{ "File is not a persistent vector or has unsupported format version" };
+        }
+        if (header.elementSize != ElementSize || header.elementAlignment != alignof(T) || header.typeTag != PersistentTypeTag<T>::value)
+        {
+            throw std::runtime_error{ "File was written for another element type" };
+        }
+        if (HeaderBytes + header.size * ElementSize > fileBytes)
+        {
+            throw std::runtime_error{ "File is truncated" };
+        }
+    }
+
+    [[nodiscard]] static constexpr size_t CalculateAlignedSize(const size_t bytes, const size_t alignment) noexcept
+    {
+        return (bytes + alignment - 1) / alignment * alignment;
+    }
+
+    [[nodiscard]] PersistentFileHeader* GetHeader() noexcept { return reinterpret_cast<PersistentFileHeader*>(m_base); }
+    [[nodiscard]] const PersistentFileHeader* GetHeader() const noexcept { return reinterpret_cast<const PersistentFileHeader*>(m_base); }
+
+    // Extends the file and maps the next chunk, chunk is at least as big as everything mapped before
+    void EnsureMappedBytes(const size_t bytes)
+    {
+        if (bytes <= m_mappedBytes)
+        {
+            return;
+        }
+        if (bytes > m_reservedBytes || m_viewCount == MaxViews)
+        {
+            // No extend mechanism is pre-designed, so that's strict limitation for end user.
+            throw std::bad_alloc{};
+        }
+
+        size_t chunkBytes = std::max({ bytes - m_mappedBytes, m_mappedBytes, MinChunkBytes });
+        chunkBytes = std::min(CalculateAlignedSize(chunkBytes, MappingGranularity), m_reservedBytes - m_mappedBytes);
+
+        const size_t newFileBytes = m_mappedBytes + chunkBytes;
+        if (FileMappingHelper::GetFileSize(m_file) < newFileBytes && !FileMappingHelper::SetFileSize(m_file, newFileBytes))
+        {
+            FileMappingHelper::ThrowLastError("Failed to extend the file");
+        }
+
+        char* address = m_base + m_mappedBytes;
+        if (FileMappingHelper::MapFileRange(m_file, address, m_mappedBytes, chunkBytes, m_reservedBytes - m_mappedBytes) == nullptr)
+        {
+            FileMappingHelper::ThrowLastError("Failed to map the file");
+        }
+
+        m_views[m_viewCount++] = { address, chunkBytes };
+        m_mappedBytes += chunkBytes;
+    }
+
+private:
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    char* m_base = nullptr;             // header is here, data starts at m_base + HeaderBytes
+    size_t m_reservedBytes = 0;
+    size_t m_mappedBytes = 0;           // prefix of the reservation which is mapped to the file
+    View m_views[MaxViews] = {};
+    size_t m_viewCount = 0;
+};
+
+} // namespace ds end
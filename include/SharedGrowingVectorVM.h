@@ -0,0 +1,372 @@
+#pragma once
+
+// Cross-process GrowingVectorVM: one writer process appends, any amount of reader processes attach by name.
+// Backing storage is a named pagefile section created with SEC_RESERVE, so the whole reservation exists as
+// address space only and the writer commits pages on growth (same model as GrowingVectorVM, but shared).
+// Every process maps the full section up front, so growth is visible to readers without remapping.
+//
+// Published size is an atomic in the shared header: writer stores it with release after writing elements,
+// readers load it with acquire, so everything below the loaded size is fully written.
+// Elements are never removed (readers can't observe shrinking), in-place modification of published elements
+// is allowed but readers can see torn values then, synchronization is on the user side in that case.
+//
+// Section lives while at least one process has it opened, readers can keep reading after the writer exits.
+
+#include "PersistentGrowingVectorVM.h"  // for type tags and FileMappingHelper
+
+#include <atomic>                       // for published size
+
+
+namespace ds
+{
+
+struct SharedVectorHeader
+{
+    std::atomic<uint64_t> magic;        // stored the last with release, readers load it first with acquire
+    uint32_t version;
+    uint32_t headerBytes;
+    uint64_t elementSize;
+    uint64_t typeTag;
+    uint64_t reservedBytes;             // size of the whole section, including header
+    std::atomic<uint64_t> publishedSize;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared header relies on lock-free atomics");
+
+
+struct SharedMemoryHelper
+{
+    // Returns nullptr with ERROR_ALREADY_EXISTS as last error if section with such name exists already
+    [[nodiscard]] static HANDLE CreateReservedSection(const wchar_t* name, const size_t bytes)
+    {
+#if WIN32
+        HANDLE section = CreateFileMappingW(
+            INVALID_HANDLE_VALUE,                   // backed by pagefile
+            nullptr,
+            PAGE_READWRITE | SEC_RESERVE,           // pages are committed by the writer later
+            static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32),
+            static_cast<DWORD>(bytes & 0xFFFFFFFF),
+            name);
+        if (section != nullptr && GetLastError() == ERROR_ALREADY_EXISTS)
+        {
+            CloseHandle(section);
+            SetLastError(ERROR_ALREADY_EXISTS);
+            return nullptr;
+        }
+        return section;
+#else
+#error Not implemented
+#endif
+    }
+
+    [[nodiscard]] static HANDLE OpenSection(const wchar_t* name)
+    {
+#if WIN32
+        return OpenFileMappingW(FILE_MAP_READ, FALSE, name);
+#else
+#error Not implemented
+#endif
+    }
+
+    // Maps the whole section
+    [[nodiscard]] static void* MapSection(HANDLE section, const bool writable)
+    {
+#if WIN32
+        return MapViewOfFile(section, writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0);
+#else
+#error Not implemented
+#endif
+    }
+
+    // Commits pages of SEC_RESERVE section through the view, they become visible in all views
+    [[nodiscard]] static bool CommitViewRange(void* address, const size_t bytes)
+    {
+#if WIN32
+        return VirtualAlloc(address, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+#error Not implemented
+#endif
+    }
+
+    // The section exists (and can be opened) before its creator commits the header, reading it then is an access violation
+    [[nodiscard]] static bool IsCommitted(const void* address) noexcept
+    {
+#if WIN32
+        MEMORY_BASIC_INFORMATION info{};
+        return VirtualQuery(address, &info, sizeof(info)) == sizeof(info) && info.State == MEM_COMMIT;
+#else
+#error Not implemented
+#endif
+    }
+
+    static void CloseSection(HANDLE section, void* view)
+    {
+#if WIN32
+        if (view != nullptr)
+        {
+            UnmapViewOfFile(view);
+        }
+        if (section != nullptr)
+        {
+            CloseHandle(section);
+        }
+#else
+#error Not implemented
+#endif
+    }
+};
+
+
+// Writer side, owns the section
+template <typename T, typename ReservePolicy = RAMSizePolicyTag>
+class SharedGrowingVectorVM
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be shared between processes");
+
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    constexpr static size_t ElementSize = sizeof(T);
+    static constexpr uint64_t Magic = 0x4D5656474448534Eull;   // "NSHDGVVM"
+    static constexpr uint32_t FormatVersion = 1;
+    static constexpr size_t HeaderBytes = 4096;                 // keeps data page aligned
+    static constexpr size_t MinCommitBytes = DS_KB(64);
+
+    static_assert(alignof(T) <= HeaderBytes);
+
+    // Throws std::runtime_error if the section with such name exists already (single writer)
+    explicit SharedGrowingVectorVM(const wchar_t* name)
+    {
+        m_reservedBytes = HeaderBytes + CalculateReserveBytesForPolicy<ReservePolicy>();
+        m_reservedBytes = (m_reservedBytes + MinCommitBytes - 1) / MinCommitBytes * MinCommitBytes;
+
+        m_section = SharedMemoryHelper::CreateReservedSection(name, m_reservedBytes);
+        if (m_section == nullptr)
+        {
+            if (GetLastError() == ERROR_ALREADY_EXISTS)
+            {
+                throw std::runtime_error{ "Shared vector with such name exists already" };
+            }
+            FileMappingHelper::ThrowLastError("CreateFileMappingW failed");
+        }
+
+        m_base = static_cast<char*>(SharedMemoryHelper::MapSection(m_section, true));
+        if (m_base == nullptr || !SharedMemoryHelper::CommitViewRange(m_base, HeaderBytes))
+        {
+            SharedMemoryHelper::CloseSection(m_section, m_base);
+            throw std::bad_alloc{};
+        }
+        m_committedBytes = HeaderBytes;
+
+        SharedVectorHeader* header = new (m_base) SharedVectorHeader{};
+        header->version = FormatVersion;
+        header->headerBytes = HeaderBytes;
+        header->elementSize = ElementSize;
+        header->typeTag = PersistentTypeTag<T>::value;
+        header->reservedBytes = m_reservedBytes;
+        header->publishedSize.store(0, std::memory_order_relaxed);
+        // readers check magic first, so it goes the last
+        header->magic.store(Magic, std::memory_order_release);
+    }
+
+    ~SharedGrowingVectorVM() noexcept
+    {
+        SharedMemoryHelper::CloseSection(m_section, m_base);
+    }
+
+    SharedGrowingVectorVM(SharedGrowingVectorVM&& other) noexcept
+        : m_section(std::exchange(other.m_section, nullptr))
+        , m_base(std::exchange(other.m_base, nullptr))
+        , m_reservedBytes(std::exchange(other.m_reservedBytes, 0))
+        , m_committedBytes(std::exchange(other.m_committedBytes, 0))
+    {
+    }
+
+    SharedGrowingVectorVM(const SharedGrowingVectorVM&) = delete;
+    SharedGrowingVectorVM& operator=(const SharedGrowingVectorVM&) = delete;
+    SharedGrowingVectorVM& operator=(SharedGrowingVectorVM&&) = delete;
+
+    // Only writer changes the size, so relaxed load is enough here
+    [[nodiscard]] inline size_type GetSize() const noexcept { return static_cast<size_type>(GetHeader()->publishedSize.load(std::memory_order_relaxed)); }
+    [[nodiscard]] inline bool Empty() const noexcept { return GetSize() == 0; }
+    [[nodiscard]] inline size_type GetCapacity() const noexcept { return (m_committedBytes - HeaderBytes) / ElementSize; }
+    [[nodiscard]] inline size_type GetReserve() const noexcept { return (m_reservedBytes - HeaderBytes) / ElementSize; }
+
+    [[nodiscard]] inline pointer GetData() noexcept { return reinterpret_cast<pointer>(m_base + HeaderBytes); }
+    [[nodiscard]] inline const_pointer GetData() const noexcept { return reinterpret_cast<const_pointer>(m_base + HeaderBytes); }
+
+    [[nodiscard]] inline reference operator[](const size_type index) noexcept
+    {
+        assert(index < GetSize());
+        return GetData()[index];
+    }
+    [[nodiscard]] inline const_reference operator[](const size_type index) const noexcept
+    {
+        assert(index < GetSize());
+        return GetData()[index];
+    }
+
+    [[nodiscard]] inline iterator Begin() noexcept { return GetData(); }
+    [[nodiscard]] inline iterator End() noexcept { return GetData() + GetSize(); }
+    [[nodiscard]] inline const_iterator CBegin() const noexcept { return GetData(); }
+    [[nodiscard]] inline const_iterator CEnd() const noexcept { return GetData() + GetSize(); }
+
+    void PushBack(const T& value)
+    {
+        Append(&value, 1);
+    }
+
+    // Writes all values and publishes them at once
+    void Append(const T* values, const size_type count)
+    {
+        const size_type size = GetSize();
+        EnsureCommittedBytes(HeaderBytes + (size + count) * ElementSize); // can throw
+        std::copy(values, values + count, GetData() + size);
+        GetHeader()->publishedSize.store(size + count, std::memory_order_release);
+    }
+
+private:
+    [[nodiscard]] SharedVectorHeader* GetHeader() noexcept { return reinterpret_cast<SharedVectorHeader*>(m_base); }
+    [[nodiscard]] const SharedVectorHeader* GetHeader() const noexcept { return reinterpret_cast<const SharedVectorHeader*>(m_base); }
+
+    void EnsureCommittedBytes(const size_t bytes)
+    {
+        if (bytes <= m_committedBytes)
+        {
+            return;
+        }
+        if (bytes > m_reservedBytes)
+        {
+            // No extend mechanism is pre-designed, so that's strict limitation for end user.
+            throw std::bad_alloc{};
+        }
+
+        // commit geometrically to not call VirtualAlloc on every page
+        size_t newCommittedBytes = std::max(bytes, m_committedBytes * 2);
+        newCommittedBytes = (newCommittedBytes + MinCommitBytes - 1) / MinCommitBytes * MinCommitBytes;
+        newCommittedBytes = std::min(newCommittedBytes, m_reservedBytes);
+
+        if (!SharedMemoryHelper::CommitViewRange(m_base + m_committedBytes, newCommittedBytes - m_committedBytes))
+        {
+            throw std::bad_alloc{};
+        }
+        m_committedBytes = newCommittedBytes;
+    }
+
+private:
+    HANDLE m_section = nullptr;
+    char* m_base = nullptr;             // header is here, data starts at m_base + HeaderBytes
+    size_t m_reservedBytes = 0;
+    size_t m_committedBytes = 0;
+};
+
+
+// Reader side, read-only view of the section created by SharedGrowingVectorVM (usually in another process)
+template <typename T>
+class SharedGrowingVectorReaderVM
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be shared between processes");
+
+    using value_type = T;
+    using const_pointer = const T*;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using const_iterator = const T*;
+
+    template <typename ReservePolicy>
+    using WriterType = SharedGrowingVectorVM<T, ReservePolicy>;
+
+    // Throws std::system_error if there is no such section and std::runtime_error if it's not a shared vector of T
+    // or the writer hasn't initialized it yet (the section is opened while the writer is being constructed)
+    explicit SharedGrowingVectorReaderVM(const wchar_t* name)
+    {
+        m_section = SharedMemoryHelper::OpenSection(name);
+        if (m_section == nullptr)
+        {
+            FileMappingHelper::ThrowLastError("OpenFileMappingW failed");
+        }
+
+        m_base = static_cast<const char*>(SharedMemoryHelper::MapSection(m_section, false));
+        if (m_base == nullptr)
+        {
+            SharedMemoryHelper::CloseSection(m_section, nullptr);
+            FileMappingHelper::ThrowLastError("MapViewOfFile failed");
+        }
+
+        const SharedVectorHeader* header = GetHeader();
+        if (!SharedMemoryHelper::IsCommitted(header) || header->magic.load(std::memory_order_acquire) != WriterType<RAMSizePolicyTag>::Magic)
+        {
+            SharedMemoryHelper::CloseSection(m_section, const_cast<char*>(m_base));
+            throw std::runtime_error{ "Section is not a shared vector (or it's not initialized yet)" };
+        }
+
+        // written before magic, so they are visible after the acquire load above
+        const bool isValid = header->version == WriterType<RAMSizePolicyTag>::FormatVersion
+            && header->headerBytes == WriterType<RAMSizePolicyTag>::HeaderBytes
+            && header->elementSize == sizeof(T)
+            && header->typeTag == PersistentTypeTag<T>::value;
+        if (!isValid)
+        {
+            SharedMemoryHelper::CloseSection(m_section, const_cast<char*>(m_base));
+            throw std::runtime_error{ "Section is not a shared vector of this type" };
+        }
+    }
+
+    ~SharedGrowingVectorReaderVM() noexcept
+    {
+        SharedMemoryHelper::CloseSection(m_section, const_cast<char*>(m_base));
+    }
+
+    SharedGrowingVectorReaderVM(SharedGrowingVectorReaderVM&& other) noexcept
+        : m_section(std::exchange(other.m_section, nullptr))
+        , m_base(std::exchange(other.m_base, nullptr))
+    {
+    }
+
+    SharedGrowingVectorReaderVM(const SharedGrowingVectorReaderVM&) = delete;
+    SharedGrowingVectorReaderVM& operator=(const SharedGrowingVectorReaderVM&) = delete;
+    SharedGrowingVectorReaderVM& operator=(SharedGrowingVectorReaderVM&&) = delete;
+
+    // Everything below returned size is fully written and stays valid
+    [[nodiscard]] inline size_type GetSize() const noexcept { return static_cast<size_type>(GetHeader()->publishedSize.load(std::memory_order_acquire)); }
+    [[nodiscard]] inline bool Empty() const noexcept { return GetSize() == 0; }
+    [[nodiscard]] inline size_type GetReserve() const noexcept { return (GetHeader()->reservedBytes - GetHeader()->headerBytes) / sizeof(T); }
+
+    [[nodiscard]] inline const_pointer GetData() const noexcept { return reinterpret_cast<const_pointer>(m_base + GetHeader()->headerBytes); }
+
+    [[nodiscard]] inline const_reference operator[](const size_type index) const noexcept
+    {
+        assert(index < GetSize());
+        return GetData()[index];
+    }
+
+    [[nodiscard]] const_reference At(const size_type index) const
+    {
+        if (index >= GetSize())
+        {
+            throw std::out_of_range{ "Index is out of range" };
+        }
+        return GetData()[index];
+    }
+
+    // End is taken from the size published at the moment of the call
+    [[nodiscard]] inline const_iterator CBegin() const noexcept { return GetData(); }
+    [[nodiscard]] inline const_iterator CEnd() const noexcept { return GetData() + GetSize(); }
+
+private:
+    [[nodiscard]] const SharedVectorHeader* GetHeader() const noexcept { return reinterpret_cast<const SharedVectorHeader*>(m_base); }
+
+private:
+    HANDLE m_section = nullptr;
+    const char* m_base = nullptr;
+};
+
+} // namespace ds end
@@ -0,0 +1,14 @@
+// Definition of the TraceLogging provider declared in GrowingVectorVMEvents.h.
+// Added to every target linking GrowingVectorVM when the CMake option ENABLE_TRACELOGGING is on, builds which don't
+// use CMake put DS_DEFINE_TRACELOGGING_PROVIDER() into one of their own .cpp files instead.
+
+#include "GrowingVectorVMEvents.h"
+
+#if DS_ENABLE_TRACELOGGING
+namespace ds
+{
+
+DS_DEFINE_TRACELOGGING_PROVIDER();
+
+} // namespace ds end
+#endif
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+
+// Trivially copyable element of mixed field types, shared by the file format tests
+struct Point
+{
+    int32_t x;
+    int32_t y;
+    double weight;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "GrowingVectorVMKernels.h"
+
+// Restores SIMD dispatch on scope exit, so every test can walk through all supported levels
+struct SimdLevelLimitGuard
+{
+    ~SimdLevelLimitGuard()
+    {
+        ds::simd::SetSimdLevelLimit(ds::simd::SimdLevel::AVX512);
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <filesystem>
+
+// File in the temp directory, removed before the test and on scope exit
+struct TempFile
+{
+    std::filesystem::path path;
+
+    explicit TempFile(const char* name)
+        : path(std::filesystem::temp_directory_path() / name)
+    {
+        std::filesystem::remove(path);
+    }
+
+    ~TempFile()
+    {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+};
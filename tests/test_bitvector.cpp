@@ -0,0 +1,187 @@
+#include "GrowingBitVectorVM.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+using BitVector = ds::GrowingBitVectorVM<ds::_4GBSisePolicyTag>;
+
+TEST(GrowingBitVectorTest, PushBackSetTestFlip)
+{
+    BitVector bits;
+    EXPECT_TRUE(bits.Empty());
+
+    for (size_t i = 0; i < 1000; i++)
+    {
+        bits.PushBack(i % 3 == 0);
+    }
+    ASSERT_EQ(bits.GetSize(), 1000);
+    ASSERT_EQ(bits.GetWordCount(), (1000 + 63) / 64);
+
+    for (size_t i = 0; i < 1000; i++)
+    {
+        ASSERT_EQ(bits.Test(i), i % 3 == 0);
+    }
+
+    bits.Set(1);
+    bits.Reset(0);
+    bits.Flip(2);
+    bits[4] = true;
+    EXPECT_FALSE(bits[0]);
+    EXPECT_TRUE(bits[1]);
+    EXPECT_TRUE(bits[2]);
+    EXPECT_TRUE(bits[4]);
+
+    EXPECT_THROW({ auto _ = bits.Test(1000); }, std::out_of_range);
+
+    bits.Resize(10);
+    EXPECT_EQ(bits.GetSize(), 10);
+    bits.Resize(200, true);
+    EXPECT_EQ(bits.Count(), 190 + 4 /*1, 2, 3, 4*/ + 1 /*6*/ + 1 /*9*/);
+}
+
+TEST(GrowingBitVectorTest, RankSelectMatchNaive)
+{
+    std::mt19937 generator(7);
+    std::bernoulli_distribution distribution(0.3);
+
+    BitVector bits;
+    std::vector<bool> reference;
+    for (size_t i = 0; i < 20'000; i++)
+    {
+        const bool value = distribution(generator);
+        bits.PushBack(value);
+        reference.push_back(value);
+    }
+
+    auto check = [&]()
+    {
+        size_t rank = 0;
+        for (size_t i = 0; i <= reference.size(); i++)
+        {
+            ASSERT_EQ(bits.Rank(i), rank);
+            if (i < reference.size() && reference[i])
+            {
+                ASSERT_EQ(bits.Select(rank), i);
+                rank++;
+            }
+        }
+        ASSERT_EQ(bits.Count(), rank);
+        ASSERT_EQ(bits.Select(rank), bits.GetSize()); // no such bit
+    };
+    check(); // nothing is indexed, queries count words
+    EXPECT_FALSE(bits.IsRankIndexBuilt());
+    bits.BuildRankIndex();
+    EXPECT_TRUE(bits.IsRankIndexBuilt());
+    check();
+
+    // mutation in the middle invalidates only a part of the index
+    for (size_t i = 5'000; i < 5'100; i++)
+    {
+        bits.Flip(i);
+        reference[i] = !reference[i];
+    }
+    EXPECT_FALSE(bits.IsRankIndexBuilt());
+    check();
+    bits.BuildRankIndex();
+    check();
+
+    for (size_t i = 0; i < 700; i++)
+    {
+        bits.PushBack(true);
+        reference.push_back(true);
+    }
+    check();
+    bits.BuildRankIndex();
+    check();
+}
+
+TEST(GrowingBitVectorTest, ConcurrentConstQueries)
+{
+    BitVector bits;
+    for (size_t i = 0; i < 100'000; i++)
+    {
+        bits.PushBack(i % 5 == 0);
+    }
+    bits.Flip(50'000);
+
+    // const queries don't build the index, so readers don't race on it
+    const BitVector& reader = bits;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> mismatches = 0;
+    for (size_t t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&reader, &mismatches]()
+        {
+            for (size_t i = 0; i < 100'000; i += 997)
+            {
+                const size_t expected = (i + 4) / 5 - (i > 50'000 ? 1 : 0);
+                if (reader.Rank(i) != expected || reader.Select(reader.Rank(i)) < i)
+                {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(mismatches, 0);
+    EXPECT_FALSE(bits.IsRankIndexBuilt());
+}
+
+TEST(GrowingBitVectorTest, BulkOperations)
+{
+    BitVector a(1000, false);
+    BitVector b(1000, false);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        a.Set(i, i % 2 == 0);
+        b.Set(i, i % 3 == 0);
+    }
+
+    a &= b; // multiples of 6
+    EXPECT_EQ(a.Count(), 167);
+    a |= b; // multiples of 3
+    EXPECT_EQ(a.Count(), 334);
+    a ^= b;
+    EXPECT_EQ(a.Count(), 0);
+
+    BitVector c(999, true);
+    EXPECT_THROW(a.And(c), std::logic_error);
+}
+
+TEST(GrowingBitVectorTest, IteratorsStayValidOnGrowth)
+{
+    BitVector bits;
+    bits.PushBack(true);
+    bits.PushBack(false);
+
+    const auto begin = bits.CBegin();
+    const uint64_t* words = bits.GetWords();
+
+    // far beyond a single page of words
+    for (size_t i = 0; i < 1'000'000; i++)
+    {
+        bits.PushBack(i % 2 == 1);
+    }
+
+    EXPECT_EQ(words, bits.GetWords());
+    EXPECT_EQ(begin, bits.CBegin());
+    EXPECT_TRUE(*begin);
+    EXPECT_FALSE(*(begin + 1));
+    EXPECT_EQ(bits.CEnd() - begin, 1'000'002);
+
+    size_t setBits = 0;
+    for (auto it = bits.Begin(); it != bits.End(); ++it)
+    {
+        setBits += *it ? 1 : 0;
+    }
+    EXPECT_EQ(setBits, bits.Count());
+
+    *(bits.Begin() + 1) = true;
+    EXPECT_EQ(bits.Count(), setBits + 1);
+}
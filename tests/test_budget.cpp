@@ -0,0 +1,156 @@
+#include "GrowingVectorVM.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+
+using Numbers = ds::GrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+using CommittedNumbers = ds::GrowingVectorVM<uint64_t, ds::CustomSizePolicyTag<DS_KB(256)>, true>;
+using TinyNumbers = ds::GrowingVectorVM<uint64_t, ds::CustomSizePolicyTag<DS_KB(64)>>;
+
+constexpr size_t ElementsPerKB = DS_KB(1) / sizeof(uint64_t);
+
+// Sets the default budget for the scope
+struct DefaultBudgetScope
+{
+    explicit DefaultBudgetScope(ds::CommitBudget& budget) { ds::GetDefaultCommitBudget().store(&budget); }
+    ~DefaultBudgetScope() { ds::GetDefaultCommitBudget().store(nullptr); }
+};
+
+} // namespace
+
+
+TEST(CommitBudgetTest, FailFastRejectsCommitsAboveLimit)
+{
+    ds::CommitBudget budget(DS_KB(256));
+    {
+        Numbers vec;
+        vec.SetCommitBudget(&budget);
+
+        EXPECT_EQ(vec.TryReserve(128 * ElementsPerKB), ds::ReserveResult::Success);
+        EXPECT_EQ(budget.GetUsedBytes(), vec.GetStats().committedBytes);
+        EXPECT_EQ(vec.TryReserve(512 * ElementsPerKB), ds::ReserveResult::BudgetExceeded);
+        EXPECT_THROW(vec.Reserve(512 * ElementsPerKB), std::bad_alloc);
+        EXPECT_EQ(budget.GetUsedBytes(), vec.GetStats().committedBytes);
+        EXPECT_EQ(budget.GetRejectedCount(), 2);
+
+        vec.Resize(128 * ElementsPerKB, uint64_t{ 1 });
+        EXPECT_THROW(vec.Resize(512 * ElementsPerKB, uint64_t{ 1 }), std::bad_alloc);
+        EXPECT_EQ(vec.GetSize(), 128 * ElementsPerKB);
+    }
+    EXPECT_EQ(budget.GetUsedBytes(), 0);
+}
+
+TEST(CommitBudgetTest, TryReserveReportsReservationOverflow)
+{
+    TinyNumbers vec;
+    EXPECT_EQ(vec.TryReserve(128 * ElementsPerKB), ds::ReserveResult::ExceedsReservation);
+    EXPECT_EQ(vec.TryReserve(32 * ElementsPerKB), ds::ReserveResult::Success);
+}
+
+TEST(CommitBudgetTest, DefaultBudgetIsChargedByNewVectors)
+{
+    ds::CommitBudget budget(DS_MB(1));
+    ds::CommitBudget tenantBudget(DS_MB(1));
+    {
+        DefaultBudgetScope scope(budget);
+        CommittedNumbers committed; // commits the whole reservation right away
+        EXPECT_EQ(committed.GetCommitBudget(), &budget);
+        EXPECT_EQ(budget.GetUsedBytes(), DS_KB(256));
+
+        Numbers vec;
+        vec.Resize(64 * ElementsPerKB, uint64_t{ 1 });
+        EXPECT_EQ(budget.GetUsedBytes(), DS_KB(256) + vec.GetStats().committedBytes);
+
+        // frozen vectors give the slack back
+        vec.Resize(32 * ElementsPerKB, uint64_t{ 1 });
+        [[maybe_unused]] const auto view = vec.Freeze();
+        EXPECT_EQ(budget.GetUsedBytes(), DS_KB(256) + vec.GetStats().committedBytes);
+        vec.Unfreeze();
+
+        committed.SetCommitBudget(&tenantBudget);
+        EXPECT_EQ(tenantBudget.GetUsedBytes(), DS_KB(256));
+        EXPECT_EQ(budget.GetUsedBytes(), vec.GetStats().committedBytes);
+
+        Numbers moved = std::move(vec);
+        EXPECT_EQ(moved.GetCommitBudget(), &budget);
+    }
+    EXPECT_EQ(budget.GetUsedBytes(), 0);
+    EXPECT_EQ(tenantBudget.GetUsedBytes(), 0);
+
+    ds::CommitBudget tinyBudget(DS_KB(64));
+    DefaultBudgetScope scope(tinyBudget);
+    EXPECT_THROW(CommittedNumbers{}, std::bad_alloc);
+    EXPECT_EQ(tinyBudget.GetUsedBytes(), 0);
+}
+
+TEST(CommitBudgetTest, BlockWaitsForRefund)
+{
+    ds::CommitBudget budget(DS_KB(256), ds::CommitBudgetPolicy::Block);
+    auto holder = std::make_unique<Numbers>();
+    holder->SetCommitBudget(&budget);
+    holder->Resize(256 * ElementsPerKB, uint64_t{ 1 });
+
+    std::atomic<bool> isDone = false;
+    std::thread waiter([&budget, &isDone]
+    {
+        Numbers vec;
+        vec.SetCommitBudget(&budget);
+        vec.Resize(128 * ElementsPerKB, uint64_t{ 2 });
+        isDone = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(isDone);
+    holder.reset();
+    waiter.join();
+    EXPECT_TRUE(isDone);
+    EXPECT_EQ(budget.GetUsedBytes(), 0);
+
+    ds::CommitBudget timedBudget(DS_KB(64), ds::CommitBudgetPolicy::Block, nullptr, 10);
+    Numbers vec;
+    vec.SetCommitBudget(&timedBudget);
+    EXPECT_EQ(vec.TryReserve(128 * ElementsPerKB), ds::ReserveResult::BudgetExceeded);
+}
+
+namespace
+{
+
+Numbers* g_trimVictim = nullptr;
+size_t g_trimRequestedBytes = 0;
+
+void TrimVictim(const size_t bytes) noexcept
+{
+    g_trimRequestedBytes = bytes;
+    g_trimVictim->Clear();
+    try
+    {
+        [[maybe_unused]] const auto view = g_trimVictim->Freeze(); // decommits everything of the empty vector
+    }
+    catch (const std::exception&)
+    {
+    }
+}
+
+} // namespace
+
+TEST(CommitBudgetTest, TrimCallbackFreesMemory)
+{
+    ds::CommitBudget budget(DS_KB(256), ds::CommitBudgetPolicy::Trim, &TrimVictim);
+    Numbers victim;
+    victim.SetCommitBudget(&budget);
+    victim.Resize(192 * ElementsPerKB, uint64_t{ 1 });
+    g_trimVictim = &victim;
+
+    Numbers vec;
+    vec.SetCommitBudget(&budget);
+    vec.Resize(128 * ElementsPerKB, uint64_t{ 2 });
+
+    EXPECT_EQ(g_trimRequestedBytes, DS_KB(64));
+    EXPECT_TRUE(victim.IsFrozen());
+    EXPECT_EQ(budget.GetUsedBytes(), vec.GetStats().committedBytes);
+    g_trimVictim = nullptr;
+}
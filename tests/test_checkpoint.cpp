@@ -0,0 +1,168 @@
+#include "GrowingVectorVMCheckpoint.h"
+#include "TempFile.h"
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+
+using Vector = ds::GrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+using Tracker = ds::DirtyPageTracker<uint64_t, ds::_4GBSisePolicyTag>;
+
+} // namespace
+
+
+TEST(CheckpointTest, CollectsOnlyModifiedPages)
+{
+    Vector vec;
+    const size_t perPage = vec.GetPageSize() / sizeof(uint64_t);
+    vec.Resize(perPage * 10, uint64_t{ 0 });
+
+    Tracker tracker(vec, true);
+    ds::GrowingVectorVM<size_t, ds::_4GBSisePolicyTag> pages;
+    tracker.CollectDirtyPages(pages);
+    EXPECT_TRUE(pages.Empty());
+
+    vec[perPage * 3] = 1;
+    vec[perPage * 3 + 1] = 2;   // same page, no second fault
+    vec[perPage * 7 + 5] = 3;
+    EXPECT_EQ(vec[perPage * 8], 0); // reading doesn't make a page dirty
+
+    tracker.CollectDirtyPages(pages);
+    ASSERT_EQ(pages.GetSize(), 2);
+    EXPECT_EQ(pages[0], 3);
+    EXPECT_EQ(pages[1], 7);
+
+    // pages are re-armed, growth is reported as dirty
+    pages.Clear();
+    vec[perPage * 3] = 4;
+    vec.PushBack(5);
+    tracker.CollectDirtyPages(pages);
+    ASSERT_EQ(pages.GetSize(), 2);
+    EXPECT_EQ(pages[0], 3);
+    EXPECT_EQ(pages[1], 10);
+    EXPECT_EQ(vec[perPage * 3], 4);
+    EXPECT_EQ(vec.Back(), 5);
+}
+
+TEST(CheckpointTest, ReplayedChainMatchesVector)
+{
+    TempFile base("ds_checkpoint_base.bin");
+    TempFile first("ds_checkpoint_0.delta");
+    TempFile second("ds_checkpoint_1.delta");
+    TempFile third("ds_checkpoint_2.delta");
+
+    Vector vec;
+    const size_t perPage = vec.GetPageSize() / sizeof(uint64_t);
+    for (size_t i = 0; i < perPage * 50 + 3; i++)
+    {
+        vec.PushBack(i);
+    }
+
+    {
+        Tracker tracker(vec);
+        EXPECT_EQ(tracker.WriteIncrementalCheckpoint(first.path), 51); // everything is dirty at start
+
+        vec[10] = 100;
+        vec[perPage * 20] = 200;
+        EXPECT_EQ(tracker.WriteIncrementalCheckpoint(second.path), 2);
+
+        vec[perPage * 20 + 1] = 300;
+        for (size_t i = 0; i < perPage; i++)
+        {
+            vec.PushBack(i * 3);
+        }
+        EXPECT_EQ(tracker.WriteIncrementalCheckpoint(third.path), 3); // page 20, partial last page and a new one
+        EXPECT_EQ(tracker.GetCheckpointCount(), 3);
+    }
+    vec[0] = 7; // writable again after the tracker is gone
+
+    ds::ReplayCheckpoints(base.path, { first.path, second.path });
+    {
+        auto restored = ds::PersistentGrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>::Open(base.path);
+        ASSERT_EQ(restored.GetSize(), perPage * 50 + 3);
+        EXPECT_EQ(restored[10], 100);
+        EXPECT_EQ(restored[perPage * 20 + 1], perPage * 20 + 1);
+    }
+
+    // continues the chain on the existing base
+    ds::ReplayCheckpoints(base.path, { third.path });
+    auto restored = ds::PersistentGrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>::Open(base.path);
+    ASSERT_EQ(restored.GetSize(), vec.GetSize());
+    for (size_t i = 1; i < vec.GetSize(); i++)
+    {
+        ASSERT_EQ(restored[i], vec[i]);
+    }
+    EXPECT_EQ(restored[0], 0);
+}
+
+TEST(CheckpointTest, ReplayValidatesType)
+{
+    TempFile base("ds_checkpoint_typed_base.bin");
+    TempFile delta("ds_checkpoint_typed.delta");
+    {
+        auto vec = ds::PersistentGrowingVectorVM<double, ds::_4GBSisePolicyTag>::Create(base.path);
+        vec.PushBack(1.0);
+    }
+
+    Vector vec(1, uint64_t{ 42 });
+    Tracker tracker(vec);
+    tracker.WriteIncrementalCheckpoint(delta.path);
+    EXPECT_THROW(ds::ReplayCheckpoints(base.path, { delta.path }), std::runtime_error);
+    EXPECT_THROW(ds::ReplayCheckpoints(delta.path, { base.path }), std::runtime_error);
+}
+
+TEST(CheckpointTest, ReplayRejectsBrokenChain)
+{
+    TempFile base("ds_checkpoint_chain_base.bin");
+    TempFile first("ds_checkpoint_chain_0.delta");
+    TempFile second("ds_checkpoint_chain_1.delta");
+    TempFile third("ds_checkpoint_chain_2.delta");
+
+    Vector vec(100, uint64_t{ 1 });
+    {
+        Tracker tracker(vec);
+        tracker.WriteIncrementalCheckpoint(first.path);
+        vec[0] = 2;
+        tracker.WriteIncrementalCheckpoint(second.path);
+        vec[0] = 3;
+        tracker.WriteIncrementalCheckpoint(third.path);
+    }
+
+    // a new base starts from the first checkpoint, nothing is left behind on failure
+    EXPECT_THROW(ds::ReplayCheckpoints(base.path, { second.path, third.path }), std::runtime_error);
+    EXPECT_FALSE(std::filesystem::exists(base.path));
+    EXPECT_THROW(ds::ReplayCheckpoints(base.path, { first.path, third.path }), std::runtime_error);
+    EXPECT_THROW(ds::ReplayCheckpoints(base.path, { first.path, second.path, second.path }), std::runtime_error);
+
+    ds::ReplayCheckpoints(base.path, { first.path });
+    EXPECT_THROW(ds::ReplayCheckpoints(base.path, { second.path, first.path }), std::runtime_error);
+    {
+        // the base isn't touched when the chain is rejected
+        auto restored = ds::PersistentGrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>::Open(base.path);
+        EXPECT_EQ(restored[0], 1);
+    }
+    ds::ReplayCheckpoints(base.path, { second.path, third.path });
+    auto restored = ds::PersistentGrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>::Open(base.path);
+    EXPECT_EQ(restored[0], 3);
+}
+
+TEST(CheckpointTest, ReplayValidatesBase)
+{
+    TempFile base("ds_checkpoint_damaged_base.bin");
+    TempFile delta("ds_checkpoint_damaged.delta");
+    {
+        std::ofstream stream(base.path, std::ios::binary);
+        const std::string garbage(ds::PersistentGrowingVectorVM<uint64_t>::HeaderBytes, 'x');
+        stream.write(garbage.data(), garbage.size());
+    }
+
+    Vector vec(1, uint64_t{ 42 });
+    Tracker tracker(vec);
+    tracker.WriteIncrementalCheckpoint(delta.path);
+    EXPECT_THROW(ds::ReplayCheckpoints(base.path, { delta.path }), std::runtime_error);
+    EXPECT_EQ(std::filesystem::file_size(base.path), ds::PersistentGrowingVectorVM<uint64_t>::HeaderBytes);
+}
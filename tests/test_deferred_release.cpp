@@ -0,0 +1,97 @@
+#include "DeferredRelease.h"
+#include <gtest/gtest.h>
+
+namespace
+{
+
+using BigVector = ds::GrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+
+} // namespace
+
+
+TEST(DeferredReleaseTest, BigVectorsAreReleasedInBackground)
+{
+    auto& releaser = ds::DeferredReleaser::GetInstance();
+    releaser.Enable(DS_MB(8), 4);
+    ASSERT_TRUE(releaser.IsEnabled());
+    const size_t deferredBefore = releaser.GetDeferredCount();
+    const size_t synchronousBefore = releaser.GetSynchronousCount();
+
+    {
+        BigVector small(1000, uint64_t{ 1 }); // below the threshold
+    }
+    EXPECT_EQ(releaser.GetDeferredCount(), deferredBefore);
+
+    for (size_t i = 0; i < 10; i++)
+    {
+        BigVector big;
+        big.Resize(DS_MB(16) / sizeof(uint64_t), uint64_t{ 7 });
+        EXPECT_EQ(big.Back(), 7);
+    }
+    // queue is bounded, the rest was released synchronously
+    EXPECT_EQ(releaser.GetDeferredCount() - deferredBefore + releaser.GetSynchronousCount() - synchronousBefore, 10);
+    EXPECT_GE(releaser.GetDeferredCount() - deferredBefore, 1);
+
+    // moved-to vector hands its previous reservation over as well
+    BigVector target;
+    target.Resize(DS_MB(16) / sizeof(uint64_t), uint64_t{ 1 });
+    BigVector source(3, uint64_t{ 2 });
+    target = std::move(source);
+    EXPECT_EQ(target.GetSize(), 3);
+
+    ds::DrainReleases();
+    releaser.Disable();
+    EXPECT_FALSE(releaser.IsEnabled());
+
+    const size_t deferredAfter = releaser.GetDeferredCount();
+    {
+        BigVector big;
+        big.Resize(DS_MB(16) / sizeof(uint64_t), uint64_t{ 7 });
+    }
+    EXPECT_EQ(releaser.GetDeferredCount(), deferredAfter);
+    ds::DrainReleases(); // nothing to wait for
+}
+
+namespace
+{
+
+ds::ReservationRelease g_takenRelease{};
+
+bool TakeRelease(const ds::ReservationRelease& release) noexcept
+{
+    g_takenRelease = release;
+    return true;
+}
+
+} // namespace
+
+TEST(DeferredReleaseTest, BudgetIsRefundedAfterRelease)
+{
+    ds::CommitBudget budget(DS_MB(64));
+    {
+        BigVector vec;
+        vec.SetCommitBudget(&budget);
+        vec.Resize(DS_MB(16) / sizeof(uint64_t), uint64_t{ 1 });
+
+        ds::GetReleaseInterceptor().store(&TakeRelease);
+    }
+    ds::GetReleaseInterceptor().store(nullptr);
+
+    // still charged while the reservation waits for release
+    EXPECT_EQ(g_takenRelease.budget, &budget);
+    EXPECT_EQ(budget.GetUsedBytes(), g_takenRelease.committedBytes);
+    EXPECT_GE(g_takenRelease.committedBytes, DS_MB(16));
+    EXPECT_TRUE(ds::ReleaseReservation(g_takenRelease));
+    EXPECT_EQ(budget.GetUsedBytes(), 0);
+
+    auto& releaser = ds::DeferredReleaser::GetInstance();
+    releaser.Enable(DS_MB(8), 4);
+    {
+        BigVector vec;
+        vec.SetCommitBudget(&budget);
+        vec.Resize(DS_MB(16) / sizeof(uint64_t), uint64_t{ 1 });
+    }
+    ds::DrainReleases();
+    releaser.Disable();
+    EXPECT_EQ(budget.GetUsedBytes(), 0);
+}
@@ -0,0 +1,112 @@
+#include "GrowingVectorVMEvents.h"
+#include "GrowingVectorVM.h"
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+
+// Events of the vector under test only, other vectors may live in the process as well
+struct EventCollector
+{
+    static inline const void* reservation = nullptr;
+    static inline std::vector<ds::MemoryEvent> events;
+
+    EventCollector()
+    {
+        events.clear();
+        events.reserve(1024);
+        ds::GetMemoryEventHook().store(&EventCollector::Collect);
+    }
+
+    ~EventCollector()
+    {
+        ds::GetMemoryEventHook().store(nullptr);
+        reservation = nullptr;
+    }
+
+    static void Collect(const ds::MemoryEvent& event) noexcept
+    {
+        // reservation is unknown before the first event, take the first reserve
+        if (reservation == nullptr && event.type == ds::MemoryEventType::Reserve)
+        {
+            reservation = event.reservation;
+        }
+        if (event.reservation == reservation && events.size() < events.capacity())
+        {
+            events.push_back(event);
+        }
+    }
+
+    [[nodiscard]] static size_t Count(const ds::MemoryEventType type)
+    {
+        size_t count = 0;
+        for (const ds::MemoryEvent& event : events)
+        {
+            count += event.type == type ? 1 : 0;
+        }
+        return count;
+    }
+};
+
+using Numbers = ds::GrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+using TinyNumbers = ds::GrowingVectorVM<uint64_t, ds::CustomSizePolicyTag<DS_KB(64)>>;
+
+} // namespace
+
+
+TEST(MemoryEventsTest, LifetimeEventsAreReported)
+{
+    if constexpr (!DS_ENABLE_MEMORY_EVENTS)
+    {
+        GTEST_SKIP() << "Built without DS_ENABLE_MEMORY_EVENTS";
+    }
+
+    EventCollector collector;
+    {
+        Numbers vec;
+        vec.Resize(DS_MB(1) / sizeof(uint64_t), uint64_t{ 1 });
+        vec.Resize(1000, uint64_t{ 1 });
+        [[maybe_unused]] const auto view = vec.Freeze();
+        vec.Unfreeze();
+    }
+
+    const auto& events = EventCollector::events;
+    ASSERT_GE(events.size(), 4);
+    EXPECT_EQ(events.front().type, ds::MemoryEventType::Reserve);
+    EXPECT_EQ(events.front().bytes, DS_GB(4));
+    EXPECT_EQ(events.back().type, ds::MemoryEventType::Release);
+    EXPECT_EQ(events.back().bytes, DS_GB(4));
+    EXPECT_EQ(EventCollector::Count(ds::MemoryEventType::Decommit), 1);
+    EXPECT_EQ(EventCollector::Count(ds::MemoryEventType::Overflow), 0);
+
+    uint64_t committedBytes = 0;
+    for (const ds::MemoryEvent& event : events)
+    {
+        EXPECT_LE(event.startTicks, event.endTicks);
+        committedBytes += event.type == ds::MemoryEventType::Commit ? event.bytes : 0;
+    }
+    EXPECT_GE(committedBytes, DS_MB(1));
+}
+
+TEST(MemoryEventsTest, OverflowIsReported)
+{
+    if constexpr (!DS_ENABLE_MEMORY_EVENTS)
+    {
+        GTEST_SKIP() << "Built without DS_ENABLE_MEMORY_EVENTS";
+    }
+
+    EventCollector collector;
+    TinyNumbers vec;
+    EXPECT_THROW(vec.Resize(DS_KB(128) / sizeof(uint64_t), uint64_t{ 1 }), std::bad_alloc);
+
+    ASSERT_EQ(EventCollector::Count(ds::MemoryEventType::Overflow), 1);
+    for (const ds::MemoryEvent& event : EventCollector::events)
+    {
+        if (event.type == ds::MemoryEventType::Overflow)
+        {
+            EXPECT_EQ(event.bytes, DS_KB(128));
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#include "GrowingFlatMapVM.h"
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+using FlatMap = ds::GrowingFlatMapVM<uint32_t, uint64_t, std::less<uint32_t>, ds::_4GBSisePolicyTag>;
+
+namespace
+{
+
+void ExpectSameContent(FlatMap& map, const std::map<uint32_t, uint64_t>& reference)
+{
+    ASSERT_EQ(map.GetSize(), reference.size());
+    const auto& keys = map.GetKeys();
+    const auto& values = map.GetValues();
+    ASSERT_EQ(map.GetBufferedCount(), 0);
+    size_t i = 0;
+    for (const auto& [key, value] : reference)
+    {
+        ASSERT_EQ(keys[i], key);
+        ASSERT_EQ(values[i], value);
+        i++;
+    }
+}
+
+} // namespace
+
+TEST(GrowingFlatMapTest, RandomInsertsEraseMatchStdMap)
+{
+    std::mt19937 generator(5);
+    std::uniform_int_distribution<uint32_t> distribution(0, 20'000);
+
+    FlatMap map;
+    std::map<uint32_t, uint64_t> reference;
+    for (size_t i = 0; i < 30'000; i++)
+    {
+        const uint32_t key = distribution(generator);
+        if (i % 5 == 4)
+        {
+            ASSERT_EQ(map.Erase(key), reference.erase(key) == 1);
+            continue;
+        }
+
+        ASSERT_EQ(map.Insert(key, i), reference.emplace(key, i).second);
+        // lookups have to see buffered elements as well
+        ASSERT_EQ(map.At(key), reference.at(key));
+    }
+    EXPECT_FALSE(map.Contains(30'000));
+    EXPECT_THROW({ auto _ = map.At(30'000); }, std::out_of_range);
+
+    ExpectSameContent(map, reference);
+
+    for (uint32_t key = 0; key < 20'050; key += 7)
+    {
+        const auto expected = std::distance(reference.begin(), reference.lower_bound(key));
+        ASSERT_EQ(map.LowerBound(key), static_cast<size_t>(expected));
+    }
+}
+
+TEST(GrowingFlatMapTest, InsertBatchMergesFromTheBack)
+{
+    FlatMap map;
+    std::map<uint32_t, uint64_t> reference;
+    for (uint32_t key = 0; key < 1'000; key += 2)
+    {
+        map.Insert(key, key);
+        reference.emplace(key, key);
+    }
+
+    // sorted, interleaves with existing keys, has duplicates inside and with the map
+    std::vector<std::pair<uint32_t, uint64_t>> batch;
+    for (uint32_t key = 1; key < 2'000; key += 3)
+    {
+        batch.push_back({ key, key * 10 });
+        if (key % 11 == 0)
+        {
+            batch.push_back({ key, 0 }); // the first of equal keys wins
+        }
+    }
+    map.InsertBatch(batch.begin(), batch.end());
+    for (const auto& [key, value] : batch)
+    {
+        reference.emplace(key, value);
+    }
+    ExpectSameContent(map, reference);
+
+    // batch before all and after all keys
+    const std::pair<uint32_t, uint64_t> edges[] = { { 0, 1 }, { 5'000, 2 } };
+    map.InsertBatch(std::begin(edges), std::end(edges));
+    reference.emplace(5'000, 2);
+    ExpectSameContent(map, reference);
+}
+
+TEST(GrowingFlatMapTest, MergeThreshold)
+{
+    FlatMap map;
+    map.SetMergeThreshold(10);
+    for (uint32_t key = 100; key > 0; key--)
+    {
+        map.Insert(key, key);
+        ASSERT_LT(map.GetBufferedCount(), 10);
+    }
+    map.InsertOrAssign(50, 500);
+    EXPECT_EQ(map.At(50), 500);
+    EXPECT_EQ(map.GetKeys().Front(), 1);
+    EXPECT_EQ(map.GetKeys().Back(), 100);
+}
+
+TEST(GrowingFlatMapTest, FailedMergeKeepsKeysAndValuesInSync)
+{
+    // values hit the reservation first: 8K values vs 16K keys
+    using SmallMap = ds::GrowingFlatMapVM<uint32_t, uint64_t, std::less<uint32_t>, ds::CustomSizePolicyTag<DS_KB(64)>>;
+    SmallMap map;
+    std::vector<std::pair<uint32_t, uint64_t>> batch;
+    for (uint32_t key = 0; key < 4'000; key++)
+    {
+        batch.push_back({ key * 2, key });
+    }
+    map.InsertBatch(batch.begin(), batch.end());
+
+    batch.clear();
+    for (uint32_t key = 0; key < 6'000; key++)
+    {
+        batch.push_back({ key * 2 + 1, key });
+    }
+    EXPECT_THROW(map.InsertBatch(batch.begin(), batch.end()), std::bad_alloc);
+
+    EXPECT_EQ(map.GetKeys().GetSize(), 4'000);
+    EXPECT_EQ(map.GetValues().GetSize(), 4'000);
+    EXPECT_EQ(map.At(7'998), 3'999);
+    EXPECT_FALSE(map.Contains(1));
+}
@@ -0,0 +1,169 @@
+#include "GrowingHashMapVM.h"
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+
+using HashMap = ds::GrowingHashMapVM<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, ds::_4GBSisePolicyTag>;
+
+TEST(GrowingHashMapTest, InsertFindEraseMatchUnorderedMap)
+{
+    std::mt19937_64 generator(11);
+    std::uniform_int_distribution<uint64_t> distribution(0, 50'000);
+
+    HashMap map;
+    std::unordered_map<uint64_t, uint64_t> reference;
+    for (size_t i = 0; i < 200'000; i++)
+    {
+        const uint64_t key = distribution(generator);
+        switch (i % 4)
+        {
+        case 0:
+        case 1:
+        {
+            const auto [it, inserted] = map.Insert(key, i);
+            const auto [refIt, refInserted] = reference.insert({ key, i });
+            ASSERT_EQ(inserted, refInserted);
+            ASSERT_EQ(it->first, key);
+            ASSERT_EQ(it->second, refIt->second);
+            break;
+        }
+        case 2:
+            ASSERT_EQ(map.Erase(key), reference.erase(key) == 1);
+            break;
+        case 3:
+            map.InsertOrAssign(key, i);
+            reference[key] = i;
+            break;
+        }
+    }
+
+    ASSERT_EQ(map.GetSize(), reference.size());
+    EXPECT_LE(map.GetLoadFactor(), map.GetMaxLoadFactor());
+    for (const auto& [key, value] : reference)
+    {
+        ASSERT_EQ(map.At(key), value);
+    }
+
+    size_t visited = 0;
+    for (auto it = map.CBegin(); it != map.CEnd(); ++it)
+    {
+        ASSERT_EQ(reference.at(it->first), it->second);
+        visited++;
+    }
+    EXPECT_EQ(visited, reference.size());
+    EXPECT_FALSE(map.Contains(100'000));
+    EXPECT_THROW({ auto _ = map.At(100'000); }, std::out_of_range);
+}
+
+TEST(GrowingHashMapTest, GrowsInPlaceOneBucketPerInsert)
+{
+    HashMap map;
+    EXPECT_EQ(map.GetBucketCount(), HashMap::InitialBucketCount);
+
+    size_t previousBucketCount = map.GetBucketCount();
+    for (uint64_t i = 0; i < 100'000; i++)
+    {
+        map.Insert(i, i * 2);
+        // linear hashing, at most one split per insert
+        ASSERT_LE(map.GetBucketCount() - previousBucketCount, 1);
+        previousBucketCount = map.GetBucketCount();
+    }
+    EXPECT_GT(map.GetBucketCount(), 100'000 / HashMap::GroupSize);
+
+    for (uint64_t i = 0; i < 100'000; i++)
+    {
+        ASSERT_EQ(map[i], i * 2);
+    }
+}
+
+TEST(GrowingHashMapTest, NonTrivialValuesAndClear)
+{
+    ds::GrowingHashMapVM<std::string, std::string> map;
+    for (int i = 0; i < 5'000; i++)
+    {
+        map[std::to_string(i)] = std::string(40, static_cast<char>('a' + i % 26));
+    }
+    EXPECT_EQ(map.GetSize(), 5'000);
+    EXPECT_EQ(map.At("25"), std::string(40, 'z'));
+
+    const auto [it, inserted] = map.TryEmplace("25", "ignored");
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(it->second, std::string(40, 'z'));
+
+    map.Clear();
+    EXPECT_TRUE(map.Empty());
+    EXPECT_EQ(map.Begin(), map.End());
+    map["key"] = "value";
+    EXPECT_EQ(map.At("key"), "value");
+}
+
+namespace
+{
+
+bool g_throwOnCopy = false;
+
+// Move can throw, so the split copies it
+struct FragileValue
+{
+    explicit FragileValue(const uint64_t value) : value(value) {}
+    FragileValue(const FragileValue& other) : value(other.value)
+    {
+        if (g_throwOnCopy)
+        {
+            throw std::runtime_error{ "copy failed" };
+        }
+    }
+    FragileValue(FragileValue&& other) noexcept(false) : value(other.value) {}
+
+    uint64_t value;
+};
+
+} // namespace
+
+TEST(GrowingHashMapTest, FailedSplitKeepsMapIntact)
+{
+    ds::GrowingHashMapVM<uint64_t, FragileValue> map;
+    for (uint64_t i = 0; i < 100; i++)
+    {
+        map.TryEmplace(i, i);
+    }
+
+    g_throwOnCopy = true;
+    uint64_t key = 100;
+    size_t bucketCount = 0;
+    for (;; key++)
+    {
+        bucketCount = map.GetBucketCount();
+        try
+        {
+            map.TryEmplace(key, key);
+        }
+        catch (const std::runtime_error&)
+        {
+            break;
+        }
+    }
+    g_throwOnCopy = false;
+
+    EXPECT_EQ(map.GetSize(), key);
+    EXPECT_EQ(map.GetBucketCount(), bucketCount);
+    EXPECT_FALSE(map.Contains(key));
+    for (uint64_t i = 0; i < key; i++)
+    {
+        ASSERT_EQ(map.At(i).value, i);
+    }
+
+    map.TryEmplace(key, key);
+    EXPECT_EQ(map.GetBucketCount(), bucketCount + 1);
+    for (uint64_t i = 0; i <= key; i++)
+    {
+        ASSERT_EQ(map.At(i).value, i);
+    }
+
+    auto moved = std::move(map);
+    EXPECT_FALSE(map.Contains(0));
+    EXPECT_THROW(map.TryEmplace(0, 0), std::logic_error);
+    EXPECT_EQ(moved.GetSize(), key + 1);
+}
@@ -0,0 +1,128 @@
+#include "GrowingVectorVMKernels.h"
+#include "SimdLevelLimitGuard.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>      // for std::accumulate
+#include <random>
+
+namespace
+{
+
+constexpr ds::simd::SimdLevel AllLevels[] = {
+    ds::simd::SimdLevel::Scalar,
+    ds::simd::SimdLevel::SSE2,
+    ds::simd::SimdLevel::AVX2,
+    ds::simd::SimdLevel::AVX512,
+};
+
+template <typename T>
+ds::GrowingVectorVM<T, ds::_4GBSisePolicyTag> MakeRandomVector(const size_t count, const int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> distribution(-1000, 1000);
+
+    ds::GrowingVectorVM<T, ds::_4GBSisePolicyTag> vec;
+    for (size_t i = 0; i < count; i++)
+    {
+        vec.PushBack(static_cast<T>(distribution(generator)));
+    }
+    return vec;
+}
+
+} // namespace
+
+
+template <class T>
+class KernelsTest : public testing::Test {};
+
+typedef testing::Types<int32_t, float, double, int64_t, uint16_t> KernelTypes;
+TYPED_TEST_SUITE(KernelsTest, KernelTypes);
+
+TYPED_TEST(KernelsTest, FindCountContainsMatchSTL)
+{
+    using T = TypeParam;
+    SimdLevelLimitGuard guard;
+
+    // odd size to always have a ragged tail
+    const auto vec = MakeRandomVector<T>(10'007, 1);
+    const T needles[] = { vec[0], vec[5000], vec.Back(), static_cast<T>(5000) /*absent*/ };
+
+    for (const auto level : AllLevels)
+    {
+        ds::simd::SetSimdLevelLimit(level);
+        for (const T needle : needles)
+        {
+            EXPECT_EQ(ds::Find(vec, needle), std::find(vec.CBegin(), vec.CEnd(), needle));
+            EXPECT_EQ(ds::Count(vec, needle), (size_t)std::count(vec.CBegin(), vec.CEnd(), needle));
+            EXPECT_EQ(ds::Contains(vec, needle), std::find(vec.CBegin(), vec.CEnd(), needle) != vec.CEnd());
+        }
+    }
+}
+
+TYPED_TEST(KernelsTest, MinMaxSumMatchSTL)
+{
+    using T = TypeParam;
+    SimdLevelLimitGuard guard;
+
+    for (const size_t count : { (size_t)1, (size_t)3, (size_t)33, (size_t)10'007 })
+    {
+        const auto vec = MakeRandomVector<T>(count, 2);
+        const auto minIt = std::min_element(vec.CBegin(), vec.CEnd());
+        const auto maxIt = std::max_element(vec.CBegin(), vec.CEnd());
+        const auto expectedSum = std::accumulate(vec.CBegin(), vec.CEnd(), ds::simd::SumType<T>{});
+
+        for (const auto level : AllLevels)
+        {
+            ds::simd::SetSimdLevelLimit(level);
+            const auto [minValue, maxValue] = ds::MinMax(vec);
+            EXPECT_EQ(minValue, *minIt);
+            EXPECT_EQ(maxValue, *maxIt);
+            // integers in [-1000, 1000] are exact in double as well
+            EXPECT_EQ(ds::Sum(vec), expectedSum);
+        }
+    }
+
+    ds::GrowingVectorVM<T, ds::_4GBSisePolicyTag> empty;
+    EXPECT_THROW({ auto _ = ds::MinMax(empty); }, std::out_of_range);
+}
+
+TYPED_TEST(KernelsTest, GatherAndFilterIndices)
+{
+    using T = TypeParam;
+    SimdLevelLimitGuard guard;
+
+    const auto vec = MakeRandomVector<T>(4'099, 3);
+
+    ds::GrowingVectorVM<size_t, ds::_4GBSisePolicyTag> indices;
+    for (size_t i = 0; i < 1'001; i++)
+    {
+        indices.PushBack((i * 7919) % vec.GetSize());
+    }
+
+    for (const auto level : AllLevels)
+    {
+        ds::simd::SetSimdLevelLimit(level);
+
+        ds::GrowingVectorVM<T, ds::_4GBSisePolicyTag> gathered;
+        ds::Gather(vec, indices, gathered);
+        ASSERT_EQ(gathered.GetSize(), indices.GetSize());
+        for (size_t i = 0; i < indices.GetSize(); i++)
+        {
+            ASSERT_EQ(gathered[i], vec[indices[i]]);
+        }
+
+        ds::GrowingVectorVM<size_t, ds::_4GBSisePolicyTag> filtered;
+        ds::FilterIndices(vec, ds::simd::CompareOp::Greater, static_cast<T>(100), filtered);
+        size_t expectedCount = 0;
+        for (size_t i = 0; i < vec.GetSize(); i++)
+        {
+            if (vec[i] > static_cast<T>(100))
+            {
+                ASSERT_EQ(filtered[expectedCount], i);
+                expectedCount++;
+            }
+        }
+        EXPECT_EQ(filtered.GetSize(), expectedCount);
+    }
+}
@@ -0,0 +1,131 @@
+#include "LazyGrowingVectorVM.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+uint64_t Hash(const uint64_t index)
+{
+    uint64_t value = index * 0x9E3779B97F4A7C15ull;
+    return value ^ (value >> 29);
+}
+
+// 24 bytes, so elements cross chunk borders
+struct Triple
+{
+    uint64_t a;
+    uint64_t b;
+    uint64_t c;
+};
+
+} // namespace
+
+
+TEST(LazyGrowingVectorTest, ChunksAreFilledOnFirstTouch)
+{
+    std::atomic<size_t> filled = 0;
+    ds::LazyGrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag> table(100'000'000, [&filled](uint64_t* out, size_t first, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = Hash(first + i);
+        }
+        filled += count;
+    });
+    EXPECT_EQ(table.GetSize(), 100'000'000);
+    EXPECT_EQ(table.GetMaterializedChunkCount(), 0);
+
+    EXPECT_EQ(table[12'345'678], Hash(12'345'678));
+    EXPECT_EQ(table[12'345'679], Hash(12'345'679)); // same chunk
+    EXPECT_EQ(table.GetMaterializedChunkCount(), 1);
+    EXPECT_EQ(filled, ds::LazyGrowingVectorVM<uint64_t>::ChunkBytes / sizeof(uint64_t));
+
+    EXPECT_EQ(table.At(99'999'999), Hash(99'999'999));
+    EXPECT_EQ(table[0], Hash(0));
+    EXPECT_EQ(table.GetMaterializedChunkCount(), 3);
+    EXPECT_THROW({ auto _ = table.At(100'000'000); }, std::out_of_range);
+
+    // concurrent first touches of the same chunks
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < 4; t++)
+    {
+        readers.emplace_back([&table]
+        {
+            for (size_t i = 50'000'000; i < 50'100'000; i += 7)
+            {
+                ASSERT_EQ(table[i], Hash(i));
+            }
+        });
+    }
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+    constexpr size_t ChunkBytes = ds::LazyGrowingVectorVM<uint64_t>::ChunkBytes;
+    EXPECT_EQ(table.GetMaterializedChunkCount(), 3 + (50'100'000 * sizeof(uint64_t) - 1) / ChunkBytes - 50'000'000 * sizeof(uint64_t) / ChunkBytes + 1);
+    EXPECT_LT(table.GetMaterializedBytes(), DS_MB(2));
+}
+
+TEST(LazyGrowingVectorTest, ElementsCrossingChunksAndResize)
+{
+    constexpr size_t ChunkBytes = ds::LazyGrowingVectorVM<Triple>::ChunkBytes;
+    const auto fill = [](Triple* out, size_t first, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = { first + i, Hash(first + i), ~(first + i) };
+        }
+    };
+    ds::LazyGrowingVectorVM<Triple, ds::_4GBSisePolicyTag> table(10, fill);
+
+    // element crossing the first border: neighbor chunk first, then the owner
+    const size_t crossing = ChunkBytes / sizeof(Triple);
+    table.Resize(crossing * 4);
+    EXPECT_EQ(table[crossing + 1].c, ~(crossing + 1));
+    EXPECT_EQ(table[crossing].c, ~crossing);
+    EXPECT_EQ(table[crossing].a, crossing);
+
+    // grown elements in the materialized last chunk are filled immediately
+    table.Resize(5);
+    EXPECT_EQ(table[4].b, Hash(4));
+    table.Resize(crossing * 2);
+    for (size_t i = 0; i < table.GetSize(); i++)
+    {
+        ASSERT_EQ(table[i].a, i);
+        ASSERT_EQ(table[i].c, ~i);
+    }
+    EXPECT_THROW(table.Resize(table.GetReserve() + 1), std::bad_alloc);
+}
+
+TEST(LazyGrowingVectorTest, GrowAfterShrinkFillsMaterializedChunks)
+{
+    constexpr size_t ChunkBytes = ds::LazyGrowingVectorVM<Triple>::ChunkBytes;
+    const auto fill = [](Triple* out, size_t first, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = { first + i, Hash(first + i), ~(first + i) };
+        }
+    };
+    const size_t crossing = ChunkBytes / sizeof(Triple);
+    ds::LazyGrowingVectorVM<Triple, ds::_4GBSisePolicyTag> table(crossing * 3 + 10, fill);
+
+    // the chunk is filled only up to the current size
+    EXPECT_EQ(table[crossing * 3 + 9].a, crossing * 3 + 9);
+    EXPECT_EQ(table[0].a, 0);
+    EXPECT_EQ(table.GetMaterializedChunkCount(), 2);
+
+    table.Resize(5);
+    table.Resize(crossing * 5);
+    EXPECT_EQ(table.GetMaterializedChunkCount(), 2);
+    for (size_t i = 0; i < table.GetSize(); i++)
+    {
+        ASSERT_EQ(table[i].a, i);
+        ASSERT_EQ(table[i].b, Hash(i));
+        ASSERT_EQ(table[i].c, ~i);
+    }
+}
@@ -907,6 +907,135 @@ TEST(GrowingVectorTest, VectorResizeOutsideReserve)
         }, std::bad_alloc);
 }
 
+TEST(GrowingVectorTest, ContainerLimitPolicyCheck)
+{
+    const ds::MemoryLimits& limits = ds::GetMemoryLimits();
+    EXPECT_EQ(&limits, &ds::GetMemoryLimits()); // read once
+    EXPECT_GT(limits.effectiveLimit, 0);
+    EXPECT_LE(limits.effectiveLimit, limits.commitLimit);
+    EXPECT_LE(limits.effectiveLimit, limits.addressSpace / 2);
+    EXPECT_LE(limits.effectiveLimit, limits.jobProcessLimit);
+    EXPECT_LE(limits.effectiveLimit, limits.jobLimit);
+
+    ds::GrowingVectorVM<int, ds::ContainerLimitPolicyTag> vec;
+    const size_t pageSize = vec.GetPageSize();
+    EXPECT_EQ(vec.GetReserve(), (limits.effectiveLimit + pageSize - 1) / pageSize * pageSize / sizeof(int));
+    vec.Resize(1000, 7);
+    EXPECT_EQ(vec.Back(), 7);
+}
+
+TEST(GrowingVectorTest, RuntimeSizePolicyCheck)
+{
+    using RuntimeVector = ds::GrowingVectorVM<int, ds::RuntimeSizePolicyTag>;
+
+    RuntimeVector small(ds::ReserveConfig{ .reserveBytes = DS_MB(1) });
+    RuntimeVector large(ds::ReserveConfig{ .reserveBytes = DS_MB(4) });
+    EXPECT_EQ(small.GetReserve(), DS_MB(1) / sizeof(int));
+    EXPECT_EQ(large.GetReserve(), DS_MB(4) / sizeof(int));
+    EXPECT_THROW(small.Resize(small.GetReserve() + 1, 0), std::bad_alloc);
+
+    small.Resize(1000, 1);
+    small.Swap(large);
+    EXPECT_EQ(small.GetReserve(), DS_MB(4) / sizeof(int));
+    EXPECT_EQ(large.GetSize(), 1000);
+
+    const RuntimeVector copy(large);
+    EXPECT_EQ(copy.GetReserve(), DS_MB(1) / sizeof(int));
+    EXPECT_EQ(copy[999], 1);
+
+    RuntimeVector defaultSized;
+    EXPECT_EQ(defaultSized.GetReserve() * sizeof(int), ds::CalculateReserveBytesForPolicy<ds::RuntimeSizePolicyTag>());
+
+    // size from the environment
+    ASSERT_TRUE(SetEnvironmentVariableA("DS_TEST_RESERVE_SIZE", "2M"));
+    RuntimeVector configured(ds::ReserveConfig{ .environmentVariable = "DS_TEST_RESERVE_SIZE" });
+    EXPECT_EQ(configured.GetReserve(), DS_MB(2) / sizeof(int));
+    ASSERT_TRUE(SetEnvironmentVariableA("DS_TEST_RESERVE_SIZE", "2X"));
+    EXPECT_EQ((ds::ReserveConfig{ .environmentVariable = "DS_TEST_RESERVE_SIZE", .defaultReserveBytes = DS_MB(3) }.Resolve()), DS_MB(3));
+
+    // assignment takes the reservation of the source, whatever the sizes are
+    ASSERT_TRUE(SetEnvironmentVariableA("DS_TEST_RESERVE_SIZE", "4M"));
+    RuntimeVector larger(ds::ReserveConfig{ .environmentVariable = "DS_TEST_RESERVE_SIZE" });
+    larger.Resize(larger.GetReserve(), 3);
+    configured = larger;
+    EXPECT_EQ(configured.GetReserve(), DS_MB(4) / sizeof(int));
+    EXPECT_EQ(configured.GetSize(), larger.GetSize());
+    EXPECT_EQ(configured.Back(), 3);
+    larger = copy;
+    EXPECT_EQ(larger.GetReserve(), DS_MB(1) / sizeof(int));
+    EXPECT_EQ(larger.GetSize(), 1000);
+    SetEnvironmentVariableA("DS_TEST_RESERVE_SIZE", nullptr);
+
+    EXPECT_EQ(ds::detail::ParseReserveSize("4096"), 4096);
+    EXPECT_EQ(ds::detail::ParseReserveSize("64k"), DS_KB(64));
+    EXPECT_EQ(ds::detail::ParseReserveSize("16G"), DS_GB(16));
+    EXPECT_EQ(ds::detail::ParseReserveSize(""), 0);
+    EXPECT_EQ(ds::detail::ParseReserveSize("1GB"), 0);
+    EXPECT_EQ(ds::detail::ParseReserveSize("99999999999999999999999"), 0);
+}
+
+TEST(GrowingVectorTest, FreezeReleasesCommittedTail)
+{
+    ds::GrowingVectorVM<int, ds::_4GBSisePolicyTag> vec;
+    vec.Reserve(vec.GetPageSize()); // a lot of committed but unused pages
+    for (int i = 0; i < 3000; i++)
+    {
+        vec.PushBack(i);
+    }
+
+    const ds::FrozenView<int> view = vec.Freeze();
+    EXPECT_TRUE(vec.IsFrozen());
+    EXPECT_EQ(vec.GetCapacity(), 3 * vec.GetPageSize() / sizeof(int));
+    EXPECT_EQ(vec.Freeze().GetData(), view.GetData());
+
+    const ds::FrozenView<int> copy = view;
+    ASSERT_EQ(copy.GetSize(), 3000);
+    EXPECT_EQ(copy[2999], 2999);
+    EXPECT_EQ(std::accumulate(std::begin(copy), std::end(copy), 0), 2999 * 3000 / 2);
+    EXPECT_THROW({ auto _ = copy.At(3000); }, std::out_of_range);
+
+    vec.Unfreeze();
+    vec.PushBack(3000);
+    vec[0] = -1;
+    EXPECT_EQ(view[0], -1);
+    EXPECT_EQ(vec.GetSize(), 3001);
+
+    // commit with reserve mode gets the tail back on unfreeze
+    ds::GrowingVectorVM<int, ds::CustomSizePolicyTag<DS_MB(1)>, true> committed;
+    committed.PushBack(1);
+    committed.Freeze();
+    EXPECT_EQ(committed.GetCapacity(), committed.GetPageSize() / sizeof(int));
+    committed.Unfreeze();
+    EXPECT_EQ(committed.GetCapacity(), committed.GetReserve());
+    committed.Resize(committed.GetReserve(), 2);
+    EXPECT_EQ(committed.Back(), 2);
+}
+
+TEST(GrowingVectorTest, FrozenVectorRejectsModifications)
+{
+    ds::GrowingVectorVM<int, ds::_4GBSisePolicyTag> vec;
+    vec.Resize(10, 1);
+    [[maybe_unused]] const ds::FrozenView<int> view = vec.Freeze();
+    const size_t committedBytes = vec.GetStats().committedBytes;
+
+    EXPECT_EQ(vec.TryReserve(DS_MB(1)), ds::ReserveResult::Frozen);
+    EXPECT_THROW(vec.Reserve(DS_MB(1)), std::logic_error);
+    EXPECT_THROW(vec.PushBack(2), std::logic_error);
+    EXPECT_THROW(vec.EmplaceBack(2), std::logic_error);
+    EXPECT_THROW(vec.InsertAtIndex(0, 2), std::logic_error);
+    EXPECT_THROW(vec.Insert(vec.CBegin(), 2, 2), std::logic_error);
+    EXPECT_THROW(vec.Erase(vec.CBegin()), std::logic_error);
+    EXPECT_THROW(vec.Resize(DS_MB(1), 2), std::logic_error);
+    EXPECT_THROW(vec.Resize(5), std::logic_error);
+    EXPECT_THROW((vec = { 1, 2, 3 }), std::logic_error);
+    EXPECT_EQ(vec.GetStats().committedBytes, committedBytes);
+    EXPECT_EQ(vec.GetSize(), 10);
+
+    vec.Unfreeze();
+    vec.PushBack(2);
+    EXPECT_EQ(vec.Back(), 2);
+}
+
 
 // TODO [advanced] object memory management checks (ctor, dtor calls)
 
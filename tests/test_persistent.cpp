@@ -0,0 +1,80 @@
+#include "PersistentGrowingVectorVM.h"
+#include "Point.h"
+#include "TempFile.h"
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+namespace
+{
+
+using PersistentPoints = ds::PersistentGrowingVectorVM<Point, ds::_4GBSisePolicyTag>;
+
+} // namespace
+
+
+TEST(PersistentGrowingVectorTest, ReopenSeesTheSameData)
+{
+    TempFile file("ds_persistent_reopen.bin");
+    constexpr size_t Count = 300'000; // several mapped chunks
+
+    {
+        auto vec = PersistentPoints::Create(file.path);
+        EXPECT_TRUE(vec.Empty());
+        const Point* data = nullptr;
+        for (size_t i = 0; i < Count; i++)
+        {
+            vec.PushBack({ static_cast<int32_t>(i), -static_cast<int32_t>(i), i * 0.5 });
+            if (i == 0)
+            {
+                data = vec.GetData();
+            }
+        }
+        EXPECT_EQ(data, vec.GetData()); // grows in place
+        EXPECT_GE(vec.GetCapacity(), Count);
+        vec.Flush();
+    }
+
+    // closing truncates the file to the used size
+    EXPECT_EQ(std::filesystem::file_size(file.path), PersistentPoints::HeaderBytes + Count * sizeof(Point));
+
+    {
+        auto vec = PersistentPoints::Open(file.path);
+        ASSERT_EQ(vec.GetSize(), Count);
+        for (size_t i = 0; i < Count; i++)
+        {
+            ASSERT_EQ(vec[i].x, static_cast<int32_t>(i));
+            ASSERT_EQ(vec[i].weight, i * 0.5);
+        }
+
+        vec.PopBack();
+        vec.Resize(Count + 10, Point{ 7, 7, 7.0 });
+    }
+
+    auto vec = PersistentPoints::Open(file.path);
+    ASSERT_EQ(vec.GetSize(), Count + 10);
+    EXPECT_EQ(vec[Count - 2].x, static_cast<int32_t>(Count - 2));
+    EXPECT_EQ(vec[Count - 1].x, 7);
+    EXPECT_EQ(vec.Back().y, 7);
+    EXPECT_THROW({ auto _ = vec.At(Count + 10); }, std::out_of_range);
+}
+
+TEST(PersistentGrowingVectorTest, OpenValidatesHeader)
+{
+    TempFile file("ds_persistent_header.bin");
+    {
+        auto vec = ds::PersistentGrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>::Create(file.path);
+        vec.PushBack(42);
+    }
+
+    // same size, another type
+    EXPECT_THROW((ds::PersistentGrowingVectorVM<int64_t, ds::_4GBSisePolicyTag>::Open(file.path)), std::runtime_error);
+    EXPECT_THROW((ds::PersistentGrowingVectorVM<double, ds::_4GBSisePolicyTag>::Open(file.path)), std::runtime_error);
+
+    auto vec = ds::PersistentGrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>::Open(file.path);
+    ASSERT_EQ(vec.GetSize(), 1);
+    EXPECT_EQ(vec[0], 42);
+
+    TempFile missing("ds_persistent_missing.bin");
+    EXPECT_THROW((ds::PersistentGrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>::Open(missing.path)), std::system_error);
+}
@@ -0,0 +1,123 @@
+#include "GrowingVectorVMRegistry.h"
+#include "GrowingVectorVM.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+
+using Numbers = ds::GrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+using CommittedNumbers = ds::GrowingVectorVM<uint64_t, ds::CustomSizePolicyTag<DS_KB(256)>, true>;
+
+constexpr size_t ElementsPerKB = DS_KB(1) / sizeof(uint64_t);
+
+} // namespace
+
+
+TEST(RegistryTest, ShrinkToFitDecommitsSlack)
+{
+    Numbers vec;
+    vec.Reserve(256 * ElementsPerKB);
+    vec.Resize(ElementsPerKB / 2, uint64_t{ 7 });
+    EXPECT_EQ(vec.GetSlackBytes(), vec.GetStats().committedBytes - vec.GetPageSize());
+
+    EXPECT_EQ(vec.ShrinkToFit(), DS_KB(256) - vec.GetPageSize());
+    EXPECT_EQ(vec.GetSlackBytes(), 0);
+    EXPECT_EQ(vec.GetStats().committedBytes, vec.GetPageSize());
+    EXPECT_EQ(vec[ElementsPerKB / 2 - 1], 7);
+    EXPECT_EQ(vec.ShrinkToFit(), 0);
+
+    vec.Resize(64 * ElementsPerKB, uint64_t{ 8 }); // grows again after shrinking
+    EXPECT_EQ(vec.Back(), 8);
+
+    CommittedNumbers committed;
+    EXPECT_EQ(committed.GetSlackBytes(), 0);
+    EXPECT_EQ(committed.ShrinkToFit(), 0);
+}
+
+TEST(RegistryTest, TrimAllStartsWithLargestSlack)
+{
+    if constexpr (!DS_ENABLE_VECTOR_REGISTRY)
+    {
+        GTEST_SKIP() << "Built without DS_ENABLE_VECTOR_REGISTRY";
+    }
+
+    const size_t vectorCount = ds::detail::VectorRegistry::GetInstance().GetVectorCount();
+    {
+        Numbers small;
+        Numbers large;
+        Numbers notTrimmable;
+        small.SetTrimmable(true);
+        large.SetTrimmable(true);
+        small.Reserve(64 * ElementsPerKB);
+        large.Reserve(512 * ElementsPerKB);
+        notTrimmable.Reserve(128 * ElementsPerKB);
+        large.PushBack(1);
+        EXPECT_EQ(ds::detail::VectorRegistry::GetInstance().GetVectorCount(), vectorCount + 2);
+        EXPECT_GE(ds::GetTotalSlackBytes(), DS_KB(576) - large.GetPageSize());
+
+        EXPECT_EQ(ds::TrimAll(DS_KB(256)), DS_KB(512) - large.GetPageSize());
+        EXPECT_EQ(large.GetSlackBytes(), 0);
+        EXPECT_EQ(small.GetSlackBytes(), DS_KB(64));
+
+        Numbers moved = std::move(small);
+        EXPECT_TRUE(moved.IsTrimmable());
+        EXPECT_FALSE(small.IsTrimmable());
+        EXPECT_EQ(ds::TrimAll(), DS_KB(64));
+        EXPECT_EQ(moved.GetStats().committedBytes, 0);
+        EXPECT_EQ(notTrimmable.GetSlackBytes(), DS_KB(128));
+
+        large.SetTrimmable(false);
+        EXPECT_EQ(ds::detail::VectorRegistry::GetInstance().GetVectorCount(), vectorCount + 1);
+    }
+    EXPECT_EQ(ds::detail::VectorRegistry::GetInstance().GetVectorCount(), vectorCount);
+}
+
+namespace
+{
+
+std::atomic<size_t> g_trimRequestBytes = 0;
+
+} // namespace
+
+TEST(RegistryTest, WatcherRequestsTrimOnNotification)
+{
+    if constexpr (!DS_ENABLE_VECTOR_REGISTRY)
+    {
+        GTEST_SKIP() << "Built without DS_ENABLE_VECTOR_REGISTRY";
+    }
+
+    Numbers vec;
+    vec.SetTrimmable(true);
+    vec.Reserve(256 * ElementsPerKB);
+
+    HANDLE pressure = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    ASSERT_NE(pressure, nullptr);
+    auto& watcher = ds::MemoryPressureWatcher::GetInstance();
+    const size_t triggerCount = watcher.GetTriggerCount();
+    EXPECT_THROW(watcher.Start(SIZE_MAX, nullptr, pressure), std::invalid_argument);
+    // the handler only passes the request on, vectors are trimmed by the thread owning them
+    watcher.Start(SIZE_MAX, [](const size_t targetBytes) noexcept { g_trimRequestBytes = targetBytes; }, pressure, 10);
+    EXPECT_TRUE(watcher.IsStarted());
+    EXPECT_THROW(watcher.Start(SIZE_MAX, [](size_t) noexcept {}), std::logic_error);
+
+    SetEvent(pressure);
+    for (int i = 0; i < 1000 && watcher.GetTriggerCount() == triggerCount; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    watcher.Stop();
+    CloseHandle(pressure);
+
+    EXPECT_EQ(watcher.GetTriggerCount(), triggerCount + 1);
+    EXPECT_FALSE(watcher.IsStarted());
+    EXPECT_GE(vec.GetStats().committedBytes, DS_KB(256));
+
+    const size_t requestedBytes = g_trimRequestBytes.exchange(0);
+    EXPECT_EQ(requestedBytes, SIZE_MAX);
+    ds::TrimAll(requestedBytes);
+    EXPECT_EQ(vec.GetStats().committedBytes, 0);
+}
@@ -0,0 +1,67 @@
+#include "GrowingVectorVMResidency.h"
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+
+using Numbers = ds::GrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+
+} // namespace
+
+
+TEST(ResidencyTest, TouchedPagesAreResident)
+{
+    Numbers vec;
+    const size_t perPage = vec.GetPageSize() / sizeof(uint64_t);
+    vec.Resize(64 * perPage); // committed, but nothing is written yet
+    for (size_t i = 0; i < 32 * perPage; i++)
+    {
+        vec[i] = i;
+    }
+
+    std::vector<std::pair<const void*, size_t>> ranges;
+    const ds::ResidencyInfo info = ds::QueryResidency(vec, 0, vec.GetSize(), [&](const void* begin, const size_t bytes)
+    {
+        ranges.emplace_back(begin, bytes);
+    });
+    EXPECT_EQ(info.pageCount, 64);
+    EXPECT_EQ(info.sampledPages, 64);
+    EXPECT_EQ(info.residentPages, 32);
+    EXPECT_EQ(info.nonResidentPages, 32);
+    EXPECT_EQ(info.largePages, 0);
+    ASSERT_EQ(ranges.size(), 1);
+    EXPECT_EQ(ranges[0].first, static_cast<const void*>(vec.GetData() + 32 * perPage));
+    EXPECT_EQ(ranges[0].second, 32 * vec.GetPageSize());
+
+    // range is rounded out to pages
+    const ds::ResidencyInfo part = ds::QueryResidency(vec, perPage / 2, perPage + 1);
+    EXPECT_EQ(part.pageCount, 2);
+    EXPECT_EQ(part.residentPages, 2);
+
+    EXPECT_EQ(ds::QueryResidency(vec, 5, 5).pageCount, 0);
+    EXPECT_THROW((void)ds::QueryResidency(vec, 0, vec.GetSize() + 1), std::out_of_range);
+}
+
+TEST(ResidencyTest, SampledQueryExtrapolates)
+{
+    Numbers vec;
+    const size_t perPage = vec.GetPageSize() / sizeof(uint64_t);
+    vec.Resize(1024 * perPage);
+    for (size_t i = 0; i < 512 * perPage; i++)
+    {
+        vec[i] = i;
+    }
+
+    const ds::ResidencyInfo sampled = ds::SampleResidency(vec, 0, vec.GetSize(), 64);
+    EXPECT_EQ(sampled.pageCount, 1024);
+    EXPECT_EQ(sampled.sampledPages, 64);
+    EXPECT_EQ(sampled.residentPages, 512);
+    EXPECT_EQ(sampled.nonResidentPages, 512);
+
+    // small ranges are queried completely
+    const ds::ResidencyInfo small = ds::SampleResidency(vec, 0, 10 * perPage);
+    EXPECT_EQ(small.sampledPages, 10);
+    EXPECT_EQ(small.residentPages, 10);
+}
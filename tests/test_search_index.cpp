@@ -0,0 +1,136 @@
+#include "GrowingVectorVMSearchIndex.h"
+#include "SimdLevelLimitGuard.h"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+namespace
+{
+
+template <typename T>
+void AppendSortedRandom(ds::GrowingVectorVM<T, ds::_4GBSisePolicyTag>& vec, const size_t count, std::mt19937& generator)
+{
+    // small steps to have a lot of duplicates
+    std::uniform_int_distribution<int> step(0, 3);
+    T value = vec.Empty() ? static_cast<T>(std::is_signed_v<T> ? -1000 : 0) : vec.Back();
+    for (size_t i = 0; i < count; i++)
+    {
+        value = static_cast<T>(value + step(generator));
+        vec.PushBack(value);
+    }
+}
+
+template <typename T, typename Index>
+void ExpectMatchesStdLowerBound(const ds::GrowingVectorVM<T, ds::_4GBSisePolicyTag>& vec, const Index& index)
+{
+    ASSERT_FALSE(index.IsStale());
+
+    std::vector<T> needles;
+    const T last = vec.Empty() ? T{} : vec.Back();
+    for (T needle = static_cast<T>(std::is_signed_v<T> ? -1010 : 0); needle <= static_cast<T>(last + 10); needle = static_cast<T>(needle + 1))
+    {
+        needles.push_back(needle);
+    }
+
+    std::vector<size_t> batched(needles.size());
+    index.LowerBoundBatch(needles.data(), needles.size(), batched.data());
+
+    for (size_t i = 0; i < needles.size(); i++)
+    {
+        const size_t expected = std::lower_bound(vec.CBegin(), vec.CEnd(), needles[i]) - vec.CBegin();
+        ASSERT_EQ(index.LowerBound(needles[i]), expected) << "needle " << needles[i];
+        ASSERT_EQ(batched[i], expected) << "needle " << needles[i];
+    }
+}
+
+} // namespace
+
+
+template <class T>
+class SearchIndexTest : public testing::Test {};
+
+typedef testing::Types<uint64_t, int64_t, int32_t, uint32_t, double, float, int16_t> SearchIndexTypes;
+TYPED_TEST_SUITE(SearchIndexTest, SearchIndexTypes);
+
+TYPED_TEST(SearchIndexTest, LowerBoundMatchesSTL)
+{
+    using T = TypeParam;
+    SimdLevelLimitGuard guard;
+
+    for (const size_t count : { (size_t)0, (size_t)1, (size_t)7, (size_t)64, (size_t)65, (size_t)3'001 })
+    {
+        std::mt19937 generator(static_cast<unsigned>(count));
+        ds::GrowingVectorVM<T, ds::_4GBSisePolicyTag> vec;
+        AppendSortedRandom(vec, count, generator);
+
+        for (const auto level : { ds::simd::SimdLevel::Scalar, ds::simd::SimdLevel::AVX2 })
+        {
+            ds::simd::SetSimdLevelLimit(level);
+            const auto index = ds::BuildSearchIndex(vec);
+            ExpectMatchesStdLowerBound(vec, index);
+        }
+    }
+}
+
+TYPED_TEST(SearchIndexTest, IncrementalUpdateAfterAppend)
+{
+    using T = TypeParam;
+
+    std::mt19937 generator(17);
+    ds::GrowingVectorVM<T, ds::_4GBSisePolicyTag> vec;
+    auto index = ds::BuildSearchIndex(vec);
+    EXPECT_EQ(index.LowerBound(T{}), 0);
+
+    // appends of different sizes cross node and level boundaries
+    for (const size_t count : { 1, 5, 8, 50, 200, 1'000, 3 })
+    {
+        AppendSortedRandom(vec, count, generator);
+        EXPECT_TRUE(index.IsStale());
+        index.Update();
+        ExpectMatchesStdLowerBound(vec, index);
+    }
+
+    const size_t levelCount = index.GetLevelCount();
+    index.Rebuild();
+    EXPECT_EQ(index.GetLevelCount(), levelCount);
+    ExpectMatchesStdLowerBound(vec, index);
+
+    vec.PopBack();
+    EXPECT_THROW(index.Update(), std::logic_error);
+}
+
+TEST(SearchIndexTest, InfiniteKeys)
+{
+    SimdLevelLimitGuard guard;
+
+    constexpr double Infinity = std::numeric_limits<double>::infinity();
+    ds::GrowingVectorVM<double, ds::_4GBSisePolicyTag> vec;
+    vec.PushBack(-Infinity);
+    for (int i = 0; i < 100; i++)
+    {
+        vec.PushBack(i);
+    }
+    vec.PushBack(std::numeric_limits<double>::max());
+    vec.PushBack(Infinity);
+    vec.PushBack(Infinity);
+
+    for (const auto level : { ds::simd::SimdLevel::Scalar, ds::simd::SimdLevel::AVX2 })
+    {
+        ds::simd::SetSimdLevelLimit(level);
+        const auto index = ds::BuildSearchIndex(vec);
+        // the last nodes of internal levels are padded, padding must not be counted as less than +inf
+        EXPECT_EQ(index.LowerBound(Infinity), 102);
+        EXPECT_EQ(index.LowerBound(std::numeric_limits<double>::max()), 101);
+        EXPECT_EQ(index.LowerBound(-Infinity), 0);
+        EXPECT_TRUE(index.Contains(Infinity));
+
+        const double needles[] = { Infinity, -Infinity, 50.0 };
+        size_t results[3] = {};
+        index.LowerBoundBatch(needles, 3, results);
+        EXPECT_EQ(results[0], 102);
+        EXPECT_EQ(results[1], 0);
+        EXPECT_EQ(results[2], 51);
+    }
+}
@@ -0,0 +1,178 @@
+#include "GrowingVectorVMSerialization.h"
+#include "Point.h"
+#include "TempFile.h"
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+
+using Points = ds::GrowingVectorVM<Point, ds::_4GBSisePolicyTag>;
+
+} // namespace
+
+
+TEST(SerializationTest, SaveLoadAndMapRoundTrip)
+{
+    TempFile file("ds_serialized_points.bin");
+    constexpr size_t Count = 200'001;
+
+    Points points;
+    for (size_t i = 0; i < Count; i++)
+    {
+        points.PushBack({ static_cast<int32_t>(i), -static_cast<int32_t>(i), i * 0.25 });
+    }
+    ds::SaveTo(file.path, points);
+    EXPECT_EQ(std::filesystem::file_size(file.path), ds::SerializedVectorHeaderBytes + Count * sizeof(Point));
+
+    Points loaded;
+    loaded.PushBack({ 1, 2, 3.0 }); // replaced by load
+    ds::LoadFrom(file.path, loaded);
+    ASSERT_EQ(loaded.GetSize(), Count);
+    for (size_t i = 0; i < Count; i++)
+    {
+        ASSERT_EQ(loaded[i].x, points[i].x);
+        ASSERT_EQ(loaded[i].weight, points[i].weight);
+    }
+
+    {
+        auto view = ds::MappedVectorView<Point>::Open(file.path);
+        ASSERT_EQ(view.GetSize(), Count);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(view.GetData()) % 4096, 0);
+        EXPECT_EQ(view[Count - 1].y, -static_cast<int32_t>(Count - 1));
+        EXPECT_TRUE(view.VerifyChecksum());
+
+        // writes are private
+        view[0].x = 42;
+        EXPECT_EQ(view.Begin()->x, 42);
+        EXPECT_FALSE(view.VerifyChecksum());
+        EXPECT_THROW({ auto _ = view.At(Count); }, std::out_of_range);
+    }
+
+    auto view = ds::MappedVectorView<Point>::Open(file.path);
+    EXPECT_EQ(view[0].x, 0);
+    EXPECT_TRUE(view.VerifyChecksum());
+}
+
+TEST(SerializationTest, SeveralVectorsInOneFile)
+{
+    TempFile file("ds_serialized_several.bin");
+    ds::GrowingVectorVM<uint32_t, ds::_4GBSisePolicyTag> first;
+    ds::GrowingVectorVM<uint32_t, ds::_4GBSisePolicyTag> second;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        first.PushBack(i);
+        second.PushBack(i * i);
+    }
+
+    HANDLE handle = ds::FileMappingHelper::OpenFile(file.path, true);
+    ds::SaveTo(handle, first);
+    ds::SaveTo(handle, decltype(first){}); // empty one in the middle
+    ds::SaveTo(handle, second);
+    ds::FileMappingHelper::SetFilePosition(handle, 0);
+
+    decltype(first) loaded;
+    ds::LoadFrom(handle, loaded);
+    EXPECT_EQ(loaded.GetSize(), 1000);
+    EXPECT_EQ(loaded[999], 999);
+    ds::LoadFrom(handle, loaded);
+    EXPECT_TRUE(loaded.Empty());
+    ds::LoadFrom(handle, loaded);
+    EXPECT_EQ(loaded[999], 999u * 999u);
+    ds::FileMappingHelper::CloseFile(handle);
+}
+
+TEST(SerializationTest, LoadDetectsDamage)
+{
+    TempFile file("ds_serialized_damaged.bin");
+    ds::GrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag> vec;
+    for (uint64_t i = 0; i < 10'000; i++)
+    {
+        vec.PushBack(i);
+    }
+    ds::SaveTo(file.path, vec);
+
+    ds::GrowingVectorVM<int64_t, ds::_4GBSisePolicyTag> another;
+    EXPECT_THROW(ds::LoadFrom(file.path, another), std::runtime_error);
+    EXPECT_THROW(ds::MappedVectorView<double>::Open(file.path), std::runtime_error);
+
+    {
+        std::fstream stream(file.path, std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp(ds::SerializedVectorHeaderBytes + 5000 * sizeof(uint64_t));
+        stream.put('\x7f');
+    }
+    decltype(vec) loaded;
+    EXPECT_THROW(ds::LoadFrom(file.path, loaded), std::runtime_error);
+    EXPECT_TRUE(loaded.Empty());
+    EXPECT_FALSE(ds::MappedVectorView<uint64_t>::Open(file.path).VerifyChecksum());
+
+    std::filesystem::resize_file(file.path, ds::SerializedVectorHeaderBytes + 100);
+    EXPECT_THROW(ds::LoadFrom(file.path, loaded), std::runtime_error);
+    EXPECT_THROW(ds::MappedVectorView<uint64_t>::Open(file.path), std::runtime_error);
+
+    // a damaged size is rejected before anything is committed, size * sizeof(T) overflows to 8 bytes here
+    {
+        const uint64_t size = (uint64_t{ 1 } << 61) + 1;
+        std::fstream stream(file.path, std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp(offsetof(ds::SerializedVectorHeader, size));
+        stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    decltype(vec) huge;
+    EXPECT_THROW(ds::LoadFrom(file.path, huge), std::runtime_error);
+    EXPECT_EQ(huge.GetStats().committedBytes, 0);
+    EXPECT_THROW(ds::MappedVectorView<uint64_t>::Open(file.path), std::runtime_error);
+}
+
+TEST(SerializationTest, ReadAppendAndWriteRange)
+{
+    TempFile file("ds_raw_points.bin");
+    TempFile unbufferedFile("ds_raw_points_unbuffered.bin");
+
+    Points points;
+    for (size_t i = 0; i < 100'000; i++)
+    {
+        points.PushBack({ static_cast<int32_t>(i), 0, 1.0 });
+    }
+
+    ds::WriteRange(file.path, points, 10, 50'010);
+    EXPECT_EQ(std::filesystem::file_size(file.path), 50'000 * sizeof(Point));
+    EXPECT_THROW(ds::WriteRange(file.path, points, 10, 100'001), std::out_of_range);
+
+    Points loaded;
+    loaded.PushBack({ -1, 0, 0.0 });
+    EXPECT_EQ(ds::ReadAppend(file.path, loaded), 50'000);
+    ASSERT_EQ(loaded.GetSize(), 50'001);
+    EXPECT_EQ(loaded[0].x, -1);
+    EXPECT_EQ(loaded[1].x, 10);
+    EXPECT_EQ(loaded.Back().x, 50'009);
+
+    // limited reads continue from the file position
+    HANDLE handle = ds::FileMappingHelper::OpenFile(file.path, false);
+    Points chunked;
+    EXPECT_EQ(ds::ReadAppend(handle, chunked, 1000 * sizeof(Point) + 5), 1000);
+    EXPECT_EQ(ds::ReadAppend(handle, chunked, DS_MB(16)), 49'000);
+    EXPECT_EQ(ds::ReadAppend(handle, chunked, DS_MB(16)), 0);
+    ds::FileMappingHelper::CloseFile(handle);
+    ASSERT_EQ(chunked.GetSize(), 50'000);
+    EXPECT_EQ(chunked[1000].x, 1010);
+
+    // unbuffered: range has to start at a page
+    const size_t perPage = points.GetPageSize() / sizeof(Point);
+    EXPECT_THROW(ds::WriteRange(unbufferedFile.path, points, 1, 10, true), std::logic_error);
+    ds::WriteRange(unbufferedFile.path, points, perPage * 2, perPage * 2 + 777, true);
+    EXPECT_EQ(std::filesystem::file_size(unbufferedFile.path), 777 * sizeof(Point));
+
+    Points unbuffered;
+    EXPECT_EQ(ds::ReadAppend(unbufferedFile.path, unbuffered, true), 777);
+    EXPECT_EQ(unbuffered[0].x, static_cast<int32_t>(perPage * 2));
+    EXPECT_THROW(ds::ReadAppend(unbufferedFile.path, unbuffered, true), std::logic_error);
+
+    // truncated element
+    std::filesystem::resize_file(file.path, 10 * sizeof(Point) + 3);
+    Points truncated;
+    EXPECT_THROW(ds::ReadAppend(file.path, truncated), std::runtime_error);
+    EXPECT_EQ(truncated.GetSize(), 10);
+}
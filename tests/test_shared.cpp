@@ -0,0 +1,118 @@
+#include "SharedGrowingVectorVM.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+// Reader and writer are in the same process here, but they map the section independently (different addresses),
+// exactly as separate processes would do.
+
+using SharedWriter = ds::SharedGrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+using SharedReader = ds::SharedGrowingVectorReaderVM<uint64_t>;
+
+TEST(SharedGrowingVectorTest, ReaderSeesGrowthWithoutRemap)
+{
+    SharedWriter writer(L"ds_shared_vector_growth");
+    SharedReader reader(L"ds_shared_vector_growth");
+
+    EXPECT_TRUE(reader.Empty());
+    EXPECT_NE(static_cast<const void*>(reader.GetData()), static_cast<const void*>(writer.GetData()));
+    EXPECT_EQ(reader.GetReserve(), writer.GetReserve());
+
+    const uint64_t* readerData = reader.GetData();
+    for (uint64_t i = 0; i < 500'000; i++)
+    {
+        writer.PushBack(i * 3);
+    }
+
+    ASSERT_EQ(reader.GetSize(), 500'000);
+    EXPECT_EQ(readerData, reader.GetData());
+    for (size_t i = 0; i < reader.GetSize(); i++)
+    {
+        ASSERT_EQ(reader[i], i * 3);
+    }
+
+    const uint64_t batch[] = { 1, 2, 3 };
+    writer.Append(batch, 3);
+    EXPECT_EQ(reader.GetSize(), 500'003);
+    EXPECT_EQ(reader.At(500'002), 3);
+    EXPECT_THROW({ auto _ = reader.At(500'003); }, std::out_of_range);
+
+    // element is modified in place and visible through the other mapping
+    writer[0] = 42;
+    EXPECT_EQ(reader[0], 42);
+}
+
+TEST(SharedGrowingVectorTest, ConcurrentReaderSeesOnlyWrittenElements)
+{
+    SharedWriter writer(L"ds_shared_vector_concurrent");
+    constexpr uint64_t Count = 2'000'000;
+
+    std::thread readerThread([]()
+    {
+        SharedReader reader(L"ds_shared_vector_concurrent");
+        size_t checked = 0;
+        while (checked < Count)
+        {
+            const size_t size = reader.GetSize();
+            for (; checked < size; checked++)
+            {
+                ASSERT_EQ(reader[checked], checked + 1);
+            }
+        }
+    });
+
+    for (uint64_t i = 0; i < Count; i++)
+    {
+        writer.PushBack(i + 1);
+    }
+    readerThread.join();
+}
+
+TEST(SharedGrowingVectorTest, AttachValidation)
+{
+    EXPECT_THROW(SharedReader{ L"ds_shared_vector_missing" }, std::system_error);
+
+    SharedWriter writer(L"ds_shared_vector_validation");
+    // single writer
+    EXPECT_THROW((SharedWriter{ L"ds_shared_vector_validation" }), std::runtime_error);
+    // another element type
+    EXPECT_THROW(ds::SharedGrowingVectorReaderVM<double>{ L"ds_shared_vector_validation" }, std::runtime_error);
+}
+
+TEST(SharedGrowingVectorTest, ReaderAttachesWhileWriterIsConstructed)
+{
+    for (int round = 0; round < 20; round++)
+    {
+        std::atomic<bool> isAttached = false;
+        std::thread readerThread([&isAttached]()
+        {
+            while (!isAttached)
+            {
+                try
+                {
+                    SharedReader reader(L"ds_shared_vector_attach");
+                    EXPECT_GT(reader.GetReserve(), 0);
+                    isAttached = true;
+                }
+                catch (const std::system_error&)
+                {
+                    // not created yet
+                }
+                catch (const std::runtime_error&)
+                {
+                    // created but not initialized yet
+                }
+            }
+        });
+
+        {
+            SharedWriter writer(L"ds_shared_vector_attach");
+            while (!isAttached)
+            {
+                std::this_thread::yield();
+            }
+        }
+        readerThread.join();
+    }
+}
@@ -0,0 +1,93 @@
+#include "GrowingVectorVMSnapshot.h"
+#include "TempFile.h"
+#include <gtest/gtest.h>
+
+namespace
+{
+
+using Vector = ds::GrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+using SnapshotFile = ds::PersistentGrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+
+} // namespace
+
+
+TEST(SnapshotTest, SnapshotIsPointInTimeWhileWriterMutates)
+{
+    TempFile file("ds_snapshot_single.bin");
+    constexpr size_t Count = 2'000'000; // ~16MB
+
+    Vector vec;
+    for (uint64_t i = 0; i < Count; i++)
+    {
+        vec.PushBack(i);
+    }
+
+    auto snapshot = ds::SnapshotToFileAsync(file.path, vec);
+
+    // mutate and grow while the snapshot is being written
+    for (size_t i = 0; i < Count; i += 1'000)
+    {
+        vec[i] = 0;
+    }
+    for (uint64_t i = 0; i < 10'000; i++)
+    {
+        vec.PushBack(i);
+    }
+
+    snapshot.Wait();
+    EXPECT_TRUE(snapshot.IsDone());
+    EXPECT_EQ(WaitForSingleObject(snapshot.GetNativeHandle(), 0), static_cast<DWORD>(WAIT_OBJECT_0));
+    EXPECT_EQ(snapshot.GetSavedPageCount(), (Count * sizeof(uint64_t) + vec.GetPageSize() - 1) / vec.GetPageSize());
+    EXPECT_LE(snapshot.GetCopiedPageCount(), snapshot.GetSavedPageCount());
+
+    // vector is writable as usual after the snapshot
+    vec[1] = 42;
+    EXPECT_EQ(vec[1], 42);
+    EXPECT_EQ(vec[1'000], 0);
+
+    const auto saved = SnapshotFile::Open(file.path);
+    ASSERT_EQ(saved.GetSize(), Count);
+    for (size_t i = 0; i < Count; i++)
+    {
+        ASSERT_EQ(saved[i], i);
+    }
+}
+
+TEST(SnapshotTest, SeveralVectorsAreFrozenTogether)
+{
+    TempFile firstFile("ds_snapshot_first.bin");
+    TempFile secondFile("ds_snapshot_second.bin");
+
+    Vector first(100'000, 1);
+    Vector second(50'000, 2);
+    Vector empty;
+
+    TempFile emptyFile("ds_snapshot_empty.bin");
+    auto snapshot = ds::SnapshotToFileAsync({
+        { firstFile.path, ds::MakeSnapshotSource(first) },
+        { secondFile.path, ds::MakeSnapshotSource(second) },
+        { emptyFile.path, ds::MakeSnapshotSource(empty) },
+    });
+
+    // writes right after the call go to the copies, not to the snapshot
+    first[0] = 100;
+    second[49'999] = 200;
+    snapshot.Wait();
+
+    EXPECT_EQ(first[0], 100);
+    const auto savedFirst = SnapshotFile::Open(firstFile.path);
+    const auto savedSecond = SnapshotFile::Open(secondFile.path);
+    ASSERT_EQ(savedFirst.GetSize(), first.GetSize());
+    ASSERT_EQ(savedSecond.GetSize(), second.GetSize());
+    EXPECT_EQ(savedFirst[0], 1);
+    EXPECT_EQ(savedSecond[49'999], 2);
+    EXPECT_TRUE(SnapshotFile::Open(emptyFile.path).Empty());
+
+    // the same vector can't be snapshotted twice at the same time
+    auto longSnapshot = ds::SnapshotToFileAsync(firstFile.path, first);
+    if (!longSnapshot.IsDone())
+    {
+        EXPECT_THROW({ auto _ = ds::SnapshotToFileAsync(secondFile.path, first); }, std::logic_error);
+    }
+    longSnapshot.Wait();
+}
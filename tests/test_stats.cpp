@@ -0,0 +1,101 @@
+#include "PersistentGrowingVectorVM.h"
+#include "GrowingVectorVMStats.h"
+#include "TempFile.h"
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+
+using Numbers = ds::GrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+
+} // namespace
+
+
+TEST(MemoryStatsTest, PerVectorStats)
+{
+    Numbers vec;
+    EXPECT_EQ(vec.GetStats().reservedBytes, DS_GB(4));
+    EXPECT_EQ(vec.GetStats().committedBytes, 0);
+    EXPECT_EQ(vec.GetStats().usedBytes, 0);
+
+    vec.Resize(1000, uint64_t{ 3 });
+    const ds::VectorMemoryStats stats = vec.GetStats();
+    EXPECT_EQ(stats.usedBytes, 1000 * sizeof(uint64_t));
+    EXPECT_EQ(stats.committedBytes, vec.GetCapacity() * sizeof(uint64_t));
+    EXPECT_GE(stats.committedBytes, stats.usedBytes);
+}
+
+TEST(MemoryStatsTest, CountersFollowVectorLifetime)
+{
+    if constexpr (!ds::IsMemoryStatsEnabled)
+    {
+        GTEST_SKIP() << "Built without DS_ENABLE_MEMORY_STATS";
+    }
+
+    const ds::MemoryStatsSnapshot before = ds::GetMemoryStats();
+    size_t committedBytes = 0;
+    {
+        Numbers vec;
+        vec.Resize(DS_MB(1) / sizeof(uint64_t), uint64_t{ 1 });
+        committedBytes = vec.GetStats().committedBytes;
+
+        const ds::MemoryStatsSnapshot alive = ds::GetMemoryStats();
+        EXPECT_EQ(alive.reservations - before.reservations, 1);
+        EXPECT_EQ(alive.reservedBytes - before.reservedBytes, DS_GB(4));
+        EXPECT_EQ(alive.committedBytes - before.committedBytes, committedBytes);
+        EXPECT_EQ(alive.commitBytes - before.commitBytes, committedBytes);
+        EXPECT_GE(alive.commitCalls - before.commitCalls, 1);
+        EXPECT_GE(alive.largestReservationBytes, DS_GB(4));
+        EXPECT_EQ(alive.policies[0].vectors - before.policies[0].vectors, 1);
+        EXPECT_EQ(alive.policies[0].committedBytes - before.policies[0].committedBytes, committedBytes);
+
+        uint64_t latencySamples = 0;
+        for (size_t i = 0; i < ds::CommitLatencyBucketCount; i++)
+        {
+            latencySamples += alive.commitLatencyBuckets[i] - before.commitLatencyBuckets[i];
+        }
+        EXPECT_EQ(latencySamples, alive.commitCalls - before.commitCalls);
+
+        // frozen vector gives its slack back
+        vec.Resize(10);
+        const ds::FrozenView<uint64_t> view = vec.Freeze();
+        const ds::MemoryStatsSnapshot frozen = ds::GetMemoryStats();
+        EXPECT_EQ(frozen.decommitCalls - before.decommitCalls, 1);
+        EXPECT_EQ(frozen.decommitBytes - before.decommitBytes, committedBytes - vec.GetPageSize());
+        EXPECT_EQ(frozen.committedBytes - before.committedBytes, vec.GetPageSize());
+        EXPECT_EQ(view.GetSize(), 10);
+    }
+
+    const ds::MemoryStatsSnapshot after = ds::GetMemoryStats();
+    EXPECT_EQ(after.releases - before.releases, 1);
+    EXPECT_EQ(after.reservedBytes, before.reservedBytes);
+    EXPECT_EQ(after.committedBytes, before.committedBytes);
+    EXPECT_EQ(after.policies[0].vectors, before.policies[0].vectors);
+}
+
+TEST(MemoryStatsTest, PrometheusText)
+{
+    Numbers vec(100, uint64_t{ 5 });
+
+    const std::string text = ds::FormatPrometheusMetrics(ds::GetMemoryStats());
+    EXPECT_NE(text.find("# TYPE ds_vm_reservations_total counter\nds_vm_reservations_total "), std::string::npos);
+    EXPECT_NE(text.find("# TYPE ds_vm_committed_bytes gauge\n"), std::string::npos);
+    EXPECT_NE(text.find("ds_vm_policy_reserved_bytes{policy=\"4GB\"} "), std::string::npos);
+    EXPECT_NE(text.find("ds_vm_commit_latency_seconds_bucket{le=\"1e-06\"} "), std::string::npos);
+    EXPECT_NE(text.find("ds_vm_commit_latency_seconds_bucket{le=\"+Inf\"} "), std::string::npos);
+    EXPECT_NE(text.find("ds_vm_commit_latency_seconds_count "), std::string::npos);
+    EXPECT_EQ(text.back(), '\n');
+
+    TempFile file("ds_stats_test.prom");
+    HANDLE output = ds::FileMappingHelper::OpenFile(file.path, true);
+    EXPECT_TRUE(ds::WritePrometheusMetrics(output));
+    ds::FileMappingHelper::CloseFile(output);
+
+    std::ifstream input(file.path, std::ios::binary);
+    std::stringstream written;
+    written << input.rdbuf();
+    EXPECT_NE(written.str().find("ds_vm_largest_reservation_bytes "), std::string::npos);
+}
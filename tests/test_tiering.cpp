@@ -0,0 +1,81 @@
+#include "GrowingVectorVMTiering.h"
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <thread>
+
+namespace
+{
+
+using Vector = ds::GrowingVectorVM<uint64_t, ds::_4GBSisePolicyTag>;
+using Spiller = ds::ColdPageSpiller<uint64_t, ds::_4GBSisePolicyTag>;
+
+std::filesystem::path MakeBackingPath(const char* name)
+{
+    return std::filesystem::temp_directory_path() / name;
+}
+
+} // namespace
+
+
+TEST(TieringTest, SpilledPagesAreReadBackTransparently)
+{
+    Vector vec;
+    const size_t pageSize = vec.GetPageSize();
+    const size_t perPage = pageSize / sizeof(uint64_t);
+    const auto path = MakeBackingPath("ds_tiering_backing.bin");
+
+    {
+        Spiller spiller(vec, path, pageSize * 8);
+        for (uint64_t i = 0; i < perPage * 64 + 10; i++)
+        {
+            vec.PushBack(i * 3);
+        }
+        const uint64_t* first = &vec[0];
+
+        EXPECT_EQ(spiller.Maintain(), 57);
+        EXPECT_EQ(spiller.GetSpilledPageCount(), 57);
+        EXPECT_EQ(spiller.GetResidentBytes(), pageSize * 8);
+        EXPECT_EQ(spiller.Maintain(), 0);
+
+        // pointers are still valid, reads fault pages back
+        EXPECT_EQ(*first, 0);
+        EXPECT_EQ(vec[perPage * 10 + 1], (perPage * 10 + 1) * 3);
+        EXPECT_EQ(spiller.GetFaultInCount(), 2);
+        EXPECT_EQ(spiller.GetSpilledPageCount(), 55);
+
+        // written page has to be saved again, clean one is just dropped
+        vec[perPage * 10] = 7;
+        EXPECT_EQ(spiller.Maintain(), 2);
+        EXPECT_EQ(vec[perPage * 10], 7);
+        EXPECT_EQ(vec[0], 0);
+
+        // concurrent readers of spilled pages
+        std::thread reader([&vec, perPage]
+        {
+            for (size_t i = 0; i < perPage * 32; i += 97)
+            {
+                ASSERT_EQ(vec[i], i == perPage * 10 ? 7 : i * 3);
+            }
+        });
+        for (size_t i = perPage * 32; i < perPage * 64; i += 89)
+        {
+            ASSERT_EQ(vec[i], i * 3);
+        }
+        reader.join();
+
+        spiller.SetResidentBudget(pageSize * 65);
+        EXPECT_EQ(spiller.Maintain(), 0);
+        spiller.SetResidentBudget(0);
+        spiller.Maintain();
+        EXPECT_EQ(spiller.GetSpilledPageCount(), 64); // partial last page stays
+    }
+    EXPECT_FALSE(std::filesystem::exists(path));
+
+    // everything is back after the spiller is gone
+    vec.PushBack(1);
+    for (size_t i = 0; i < perPage * 64 + 10; i++)
+    {
+        ASSERT_EQ(vec[i], i == perPage * 10 ? 7 : i * 3);
+    }
+}
@@ -0,0 +1,87 @@
+#include "GrowingVectorVMTrace.h"
+#include "GrowingVectorVM.h"
+#include "TempFile.h"
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+namespace
+{
+
+using Numbers = ds::GrowingVectorVM<uint32_t, ds::_4GBSisePolicyTag>;
+
+} // namespace
+
+
+TEST(TraceTest, MutatingOperationsAreRecorded)
+{
+    if constexpr (!DS_ENABLE_OPERATION_TRACE)
+    {
+        GTEST_SKIP() << "Built without DS_ENABLE_OPERATION_TRACE";
+    }
+
+    TempFile file("ds_trace_test.trace");
+    uint64_t first = 0;
+    uint64_t second = 0;
+    {
+        ds::TraceRecorder recorder(file.path);
+        recorder.Start();
+
+        ds::TraceRecorder another(std::filesystem::temp_directory_path() / "ds_trace_test_another.trace");
+        EXPECT_THROW(another.Start(), std::logic_error);
+
+        Numbers vec;
+        first = reinterpret_cast<uintptr_t>(&vec);
+        vec.PushBack(1u);
+        vec.PushBack(2u);
+        vec.Insert(vec.CBegin(), 0u);
+        vec.Erase(vec.CBegin() + 1);
+        vec.Resize(10, 7u);
+        // operations which do nothing or fail are not recorded
+        vec.Resize(10);
+        (void)vec.Freeze();
+        EXPECT_THROW(vec.PushBack(4u), std::logic_error);
+        EXPECT_THROW(vec.Resize(20), std::logic_error);
+        vec.Unfreeze();
+        Numbers moved(std::move(vec));
+        second = reinterpret_cast<uintptr_t>(&moved);
+        moved.Clear();
+        vec.Clear();
+
+        recorder.Stop();
+        moved.PushBack(3u); // not recorded anymore
+        EXPECT_EQ(recorder.GetRecordCount(), 8);
+    }
+    std::filesystem::remove(std::filesystem::temp_directory_path() / "ds_trace_test_another.trace");
+
+    const std::vector<ds::TraceRecord> records = ds::LoadTrace(file.path);
+    ASSERT_EQ(records.size(), 8);
+    EXPECT_EQ(records[0].operation, ds::TraceOperation::Create);
+    EXPECT_EQ(records[0].vector, first);
+    EXPECT_EQ(records[0].first, sizeof(uint32_t));
+    EXPECT_EQ(records[1].operation, ds::TraceOperation::Append);
+    EXPECT_EQ(records[2].operation, ds::TraceOperation::Append);
+    EXPECT_EQ(records[2].first, 1);
+    EXPECT_EQ(records[3].operation, ds::TraceOperation::Insert);
+    EXPECT_EQ(records[3].first, 0);
+    EXPECT_EQ(records[3].count, 1);
+    EXPECT_EQ(records[4].operation, ds::TraceOperation::Erase);
+    EXPECT_EQ(records[4].first, 1);
+    EXPECT_EQ(records[5].operation, ds::TraceOperation::Resize);
+    EXPECT_EQ(records[5].first, 10);
+    EXPECT_EQ(records[6].operation, ds::TraceOperation::MoveConstruct);
+    EXPECT_EQ(records[6].vector, second);
+    EXPECT_EQ(records[6].first, first);
+    EXPECT_EQ(records[7].operation, ds::TraceOperation::Clear);
+    for (size_t i = 1; i < records.size(); i++)
+    {
+        EXPECT_GE(records[i].timestampNs, records[i - 1].timestampNs);
+    }
+
+    TempFile empty("ds_trace_test_empty.trace");
+    {
+        ds::TraceRecorder recorder(empty.path);
+    }
+    EXPECT_TRUE(ds::LoadTrace(empty.path).empty());
+    EXPECT_THROW((void)ds::LoadTrace(file.path.string() + ".missing"), std::runtime_error);
+}